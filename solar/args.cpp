@@ -0,0 +1,165 @@
+﻿#include "args.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "constants.h"
+
+namespace args
+{
+    Options options{};
+
+    void parse(int argc, char** argv)
+    {
+        options = Options{};
+        options.backend = "window";
+        options.size    = WINDOW_SIZE;
+        options.frames  = HEADLESS_FRAMES_DEFAULT;
+
+        options.textures = TEXTURE_PATH;
+        options.vsop87   = EPHEMERIS_VSOP87_PATH;
+        options.mpcorb   = MINORBODY_SOURCE_PATH;
+
+        options.exportFrames = EXPORT_FRAMES_DEFAULT;
+        options.exportStep   = EXPORT_STEP_DEFAULT;
+        options.exportFps    = EXPORT_FPS_DEFAULT;
+        options.shardCount   = 1;
+
+        options.regressGolden = REGRESS_GOLDEN_PATH;
+        options.regressOut    = REGRESS_OUTPUT_PATH;
+
+        options.program = argv[0];
+
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string arg = argv[i];
+            options.rawArgs.push_back(arg);
+
+            if (arg == "--bench-ephemeris")
+            {
+                options.benchEphemeris = true;
+            }
+            else if (arg == "--bench-text")
+            {
+                options.benchText = true;
+            }
+            else if (arg == "--single-thread")
+            {
+                options.singleThread = true;
+            }
+            else if (arg == "--headless")
+            {
+                options.backend = "egl";
+            }
+            else if (arg.rfind("--backend=", 0) == 0)
+            {
+                options.backend = arg.substr(10);
+            }
+            else if (arg.rfind("--size=", 0) == 0)
+            {
+                v::Size2i size;
+                if (std::sscanf(arg.c_str() + 7, "%dx%d", &size.w, &size.h) == 2 && size.w > 0 && size.h > 0)
+                {
+                    options.size = size;
+                }
+            }
+            else if (arg.rfind("--textures=", 0) == 0)
+            {
+                options.textures = arg.substr(11);
+            }
+            else if (arg.rfind("--vsop87=", 0) == 0)
+            {
+                options.vsop87 = arg.substr(9);
+            }
+            else if (arg.rfind("--mpcorb=", 0) == 0)
+            {
+                options.mpcorb = arg.substr(9);
+            }
+            else if (arg.rfind("--benchmark=", 0) == 0)
+            {
+                options.benchmark = arg.substr(12);
+            }
+            else if (arg.rfind("--benchmark-out=", 0) == 0)
+            {
+                options.benchmarkOut = arg.substr(16);
+            }
+            else if (arg.rfind("--export=", 0) == 0)
+            {
+                options.exportPath = arg.substr(9);
+            }
+            else if (arg.rfind("--export-format=", 0) == 0)
+            {
+                options.exportFormat = arg.substr(16);
+            }
+            else if (arg.rfind("--export-frames=", 0) == 0)
+            {
+                options.exportFrames = std::max(1, std::atoi(arg.c_str() + 16));
+            }
+            else if (arg.rfind("--export-start=", 0) == 0)
+            {
+                options.exportStart = std::atof(arg.c_str() + 15);
+            }
+            else if (arg.rfind("--export-step=", 0) == 0)
+            {
+                options.exportStep = std::atof(arg.c_str() + 14);
+            }
+            else if (arg.rfind("--export-fps=", 0) == 0)
+            {
+                options.exportFps = std::max(1, std::atoi(arg.c_str() + 13));
+            }
+            else if (arg.rfind("--export-first=", 0) == 0)
+            {
+                options.exportFirst = std::max(0, std::atoi(arg.c_str() + 15));
+            }
+            else if (arg.rfind("--export-processes=", 0) == 0)
+            {
+                options.exportProcesses = std::max(1, std::atoi(arg.c_str() + 19));
+            }
+            else if (arg.rfind("--shard=", 0) == 0)
+            {
+                int index, count;
+                if (std::sscanf(arg.c_str() + 8, "%d/%d", &index, &count) == 2 && count > 0 && 0 <= index && index < count)
+                {
+                    options.shardIndex = index;
+                    options.shardCount = count;
+                }
+            }
+            else if (arg.rfind("--regress=", 0) == 0)
+            {
+                options.regress = arg.substr(10);
+            }
+            else if (arg.rfind("--regress-golden=", 0) == 0)
+            {
+                options.regressGolden = arg.substr(17);
+            }
+            else if (arg.rfind("--regress-out=", 0) == 0)
+            {
+                options.regressOut = arg.substr(14);
+            }
+            else if (arg == "--regress-update")
+            {
+                options.regressUpdate = true;
+            }
+            else if (arg.rfind("--trace=", 0) == 0)
+            {
+                options.trace = arg.substr(8);
+            }
+            else if (arg.rfind("--frames=", 0) == 0)
+            {
+                options.frames = std::max(1, std::atoi(arg.c_str() + 9));
+            }
+            else
+            {
+                std::cout << "args : unknown argument. " << arg << std::endl;
+            }
+        }
+    }
+
+    const Options& get()
+    {
+        return options;
+    }
+}
@@ -0,0 +1,58 @@
+﻿// 명령줄 인자
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "v.h"
+
+namespace args
+{
+    struct Options
+    {
+        std::string              program; // argv[0]
+        std::vector<std::string> rawArgs; // 받은 인자 그대로. 자식 프로세스에 넘겨줄 때 사용
+
+        bool benchEphemeris; // --bench-ephemeris : 창을 띄우지 않고 급수 계산 시간, 오차만 출력
+        bool benchText;      // --bench-text : 글자 찾기, 배치, 그리기 속도 (초당 글자 수) 만 출력
+
+        std::string backend; // --backend=window|egl|osmesa, --headless 는 egl
+        v::Size2i   size;    // --size=1920x1080 : 화면 크기
+        int         frames;  // --frames=N : 창이 없을 때 로딩 후 그릴 프레임 수
+
+        std::string textures; // --textures=폴더 : 텍스쳐 폴더. 저장소에 있는 저화질 텍스쳐는 ../textures-low
+        std::string vsop87;   // --vsop87=경로 : VSOP87A 급수 파일 경로. 뒤에 mer, ven ... 이 붙음
+        std::string mpcorb;   // --mpcorb=파일 : 소천체 궤도 요소 파일 (MPCORB.DAT 형식)
+
+        bool singleThread; // --single-thread : 렌더링 스레드를 따로 두지 않고 메인 스레드에서 이벤트 처리와 렌더링을 같이 함
+
+        std::string benchmark;    // --benchmark=script.txt : 스크립트대로 렌더링하고 결과 출력 후 종료
+        std::string benchmarkOut; // --benchmark-out=report.json : 결과 파일. 없으면 표준 출력
+
+        std::string exportPath;   // --export=out.y4m, frames/%05d.png, "|명령어" : 날자를 진행시키며 화면을 내보내고 종료
+        std::string exportFormat; // --export-format=png|y4m : 없으면 확장자로 판단
+        int         exportFrames; // --export-frames=N : 내보낼 프레임 수
+        double      exportStart;  // --export-start=일 : 첫 프레임 날자 (J2000 기준 일 수)
+        double      exportStep;   // --export-step=일 : 프레임당 진행 일 수
+        int         exportFps;    // --export-fps=N : Y4M 헤더에 쓸 fps
+        int         exportFirst;  // --export-first=N : 첫 프레임 번호. 날자는 start + step * 번호
+
+        int exportProcesses; // --export-processes=N : N 개 프로세스로 나눠서 내보내고 합침
+        int shardIndex;      // --shard=i/N : 전체 프레임 중 i 번째 조각만 그림
+        int shardCount;
+
+        std::string regress;       // --regress=scenes.txt : 장면마다 정답 이미지와 비교하고 종료. 실패하면 종료 코드 1
+        std::string regressGolden; // --regress-golden=폴더 : 정답 이미지 폴더
+        std::string regressOut;    // --regress-out=폴더 : 실패한 장면의 결과, 차이 이미지 저장 폴더
+        bool        regressUpdate; // --regress-update : 비교하지 않고 정답 이미지를 새로 저장
+
+        std::string trace; // --trace=trace.json : 종료할 때 CPU 구간 기록 저장. ENABLE_TRACE 빌드에서만 기록됨
+    };
+
+    // 인자 읽기. 모르는 인자는 무시한다.
+    void parse(int argc, char** argv);
+
+    // 읽어둔 인자
+    const Options& get();
+}
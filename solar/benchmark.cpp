@@ -0,0 +1,414 @@
+﻿#include "benchmark.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "camera.h"
+#include "catalog.h"
+#include "config.h"
+#include "constants.h"
+#include "glext.h"
+#include "platform.h"
+#include "render.h"
+
+namespace benchmark
+{
+    using clock = std::chrono::steady_clock;
+
+    // 카메라 키프레임. 사이 프레임은 선형 보간. 중심 천체는 키프레임에서 바뀜
+    struct Keyframe
+    {
+        int   frame;
+        int   focus;
+        float radius;
+        float azimuth;
+        float elevation;
+    };
+
+    // 설정 변경
+    struct Toggle
+    {
+        int         frame;
+        std::string name;
+        double      value;
+    };
+
+    struct Script
+    {
+        std::string path;
+
+        int    frames = BENCHMARK_FRAMES_DEFAULT;
+        int    warmup = BENCHMARK_WARMUP_DEFAULT; // 기록하지 않는 프레임
+        double start  = 0;                        // 시작 날짜 (J2000 기준 일)
+        double step   = BENCHMARK_STEP_DEFAULT;   // 프레임당 진행 일 수
+
+        std::vector<Keyframe> keyframes; // frame 순
+        std::vector<Toggle>   toggles;   // frame 순
+    };
+
+    // 프레임별 기록
+    struct Sample
+    {
+        double   cpuMs;
+        double   gpuMs;
+        uint64_t drawCalls;
+        uint64_t bytesUploaded;
+    };
+
+    bool running = false;
+
+    Script script;
+
+    int frame = 0; // warmup 포함 현재 프레임
+    size_t nextToggle = 0;
+
+    clock::time_point frameStart;
+
+    std::vector<Sample> samples;
+
+    // GPU 시간 측정용 쿼리. 결과가 나올 때 까지 기다리지 않도록 몇 프레임 늦게 읽는다
+    std::array<GLuint, BENCHMARK_QUERY_LATENCY> queries{};
+    std::array<int,    BENCHMARK_QUERY_LATENCY> querySample{}; // 쿼리에 해당하는 samples 위치. 없으면 -1
+    size_t queryCursor = 0;
+
+    /**************************************************************************************************************/
+
+    void parse(const std::string& path, Script& s)
+    {
+        std::ifstream fs(path);
+        if (!fs.is_open())
+        {
+            throw std::runtime_error("Failed to open benchmark script. path: " + path);
+        }
+
+        s.path = path;
+
+        std::string line;
+        std::istringstream ss;
+        int lineNumber = 0;
+
+        while (std::getline(fs, line))
+        {
+            lineNumber++;
+
+            // 주석 제거
+            const auto comment = line.find('#');
+            if (comment != std::string::npos) line.erase(comment);
+
+            ss.clear();
+            ss.str(line);
+
+            std::string command;
+            if (!(ss >> command)) continue; // 빈 줄
+
+                 if (command == "frames") ss >> s.frames;
+            else if (command == "warmup") ss >> s.warmup;
+            else if (command == "start" ) ss >> s.start;
+            else if (command == "step"  ) ss >> s.step;
+            else if (command == "key")
+            {
+                // key <frame> <focus> <radius> <azimuth> <elevation>
+                Keyframe key{};
+                std::string focus;
+                ss >> key.frame >> focus >> key.radius >> key.azimuth >> key.elevation;
+
+                key.focus = catalog::find(focus);
+                if (key.focus == -1)
+                {
+                    throw std::runtime_error("Unknown body in benchmark script: " + focus);
+                }
+                if (key.radius <= 0)
+                {
+                    throw std::runtime_error("Invalid camera radius. path: " + path + ", line: " + std::to_string(lineNumber));
+                }
+
+                s.keyframes.push_back(key);
+            }
+            else if (command == "set")
+            {
+                // set <frame> <option> <value>
+                Toggle toggle{};
+                ss >> toggle.frame >> toggle.name >> toggle.value;
+
+                if (!config::hasOption(toggle.name))
+                {
+                    throw std::runtime_error("Unknown option in benchmark script: " + toggle.name);
+                }
+
+                s.toggles.push_back(toggle);
+            }
+            else
+            {
+                throw std::runtime_error("Unknown command in benchmark script: " + command);
+            }
+
+            if (ss.fail() || s.frames <= 0 || s.warmup < 0)
+            {
+                throw std::runtime_error("Invalid benchmark script line. path: " + path + ", line: " + std::to_string(lineNumber));
+            }
+        }
+
+        const auto byFrame = [](const auto& a, const auto& b) { return a.frame < b.frame; };
+        std::stable_sort(s.keyframes.begin(), s.keyframes.end(), byFrame);
+        std::stable_sort(s.toggles  .begin(), s.toggles  .end(), byFrame);
+    }
+
+    void load(const std::string& path)
+    {
+        script = Script{};
+        parse(path, script);
+
+        frame = 0;
+        nextToggle = 0;
+        samples.clear();
+        samples.reserve(script.frames);
+        querySample.fill(-1);
+
+        running = true;
+
+        std::cout << "benchmark : loaded " << path << ". frames: " << script.frames << ", warmup: " << script.warmup << std::endl;
+    }
+
+    bool active() noexcept
+    {
+        return running;
+    }
+
+    bool finished() noexcept
+    {
+        return running && frame >= script.warmup + script.frames;
+    }
+
+    double frameSeconds() noexcept
+    {
+        return BENCHMARK_FRAME_SECONDS;
+    }
+
+    /**************************************************************************************************************/
+
+    // 현재 프레임의 카메라
+    void applyCamera(int f)
+    {
+        const auto& keys = script.keyframes;
+        if (keys.empty()) return;
+
+        // f 이후 첫 키프레임
+        const auto next = std::upper_bound(keys.begin(), keys.end(), f, [](int value, const Keyframe& k) { return value < k.frame; });
+
+        Keyframe key;
+        if (next == keys.begin())
+        {
+            key = keys.front();
+        }
+        else if (next == keys.end())
+        {
+            key = keys.back();
+        }
+        else
+        {
+            const auto& a = *(next - 1);
+            const auto& b = *next;
+            const float t = static_cast<float>(f - a.frame) / (b.frame - a.frame);
+
+            // 거리는 배율로 움직이므로 로그 공간에서 보간
+            key.focus     = a.focus;
+            key.radius    = std::exp(std::log(a.radius) + (std::log(b.radius) - std::log(a.radius)) * t);
+            key.azimuth   = a.azimuth   + (b.azimuth   - a.azimuth  ) * t;
+            key.elevation = a.elevation + (b.elevation - a.elevation) * t;
+        }
+
+        auto cam = camera::get();
+        cam.focusedPlanet = key.focus;
+        cam.radius        = key.radius;
+        cam.azimuth       = key.azimuth;
+        cam.elevation     = key.elevation;
+        camera::update(cam);
+    }
+
+    // GPU 쿼리 결과 읽기. wait 이면 결과가 나올 때 까지 기다림
+    void collectQuery(size_t slot, bool wait)
+    {
+        const auto index = querySample.at(slot);
+        if (index == -1) return;
+
+        GLint available = GL_FALSE;
+        if (!wait)
+        {
+            glGetQueryObjectiv(queries.at(slot), GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available == GL_FALSE) return;
+        }
+
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(queries.at(slot), GL_QUERY_RESULT, &ns);
+
+        samples.at(index).gpuMs = ns / 1e6;
+        querySample.at(slot) = -1;
+    }
+
+    void beginFrame()
+    {
+        if (!running || finished() || !render::loaded()) return;
+
+        if (frame == 0)
+        {
+            // 재현 가능하도록 애니메이션, fps 표시 (글자 수가 바뀜) 는 끄고 시작
+            auto cfg = config::get();
+            cfg.playAnimation = false;
+            cfg.showFPS       = false;
+            cfg.vsync         = false;
+            config::update(cfg);
+
+            camera::resetCenter();
+
+            glGenQueries(static_cast<GLsizei>(queries.size()), queries.data());
+        }
+
+        // 설정 변경
+        if (nextToggle < script.toggles.size() && script.toggles.at(nextToggle).frame <= frame)
+        {
+            auto cfg = config::get();
+            while (nextToggle < script.toggles.size() && script.toggles.at(nextToggle).frame <= frame)
+            {
+                const auto& toggle = script.toggles.at(nextToggle++);
+                config::setOption(cfg, toggle.name, toggle.value);
+            }
+            config::update(cfg);
+        }
+
+        applyCamera(frame);
+        render::setDate(script.start + script.step * frame);
+
+        // 이 슬롯의 이전 결과는 여기서 반드시 받아둠
+        queryCursor = frame % queries.size();
+        collectQuery(queryCursor, true);
+
+        glext::resetCounters();
+
+        glBeginQuery(GL_TIME_ELAPSED, queries.at(queryCursor));
+        frameStart = clock::now();
+    }
+
+    void endFrame()
+    {
+        if (!running || finished() || !render::loaded() || frameStart == clock::time_point()) return;
+
+        const double cpuMs = std::chrono::duration<double, std::milli>(clock::now() - frameStart).count();
+        glEndQuery(GL_TIME_ELAPSED);
+        frameStart = clock::time_point();
+
+        if (frame >= script.warmup)
+        {
+            const auto counters = glext::counters();
+
+            querySample.at(queryCursor) = static_cast<int>(samples.size());
+            samples.push_back(Sample{ cpuMs, 0, counters.drawCalls, counters.bytesUploaded });
+        }
+
+        // 끝난 쿼리가 있으면 미리 받아둠
+        for (size_t i = 0; i < queries.size(); i++)
+        {
+            if (i != queryCursor) collectQuery(i, false);
+        }
+
+        frame++;
+    }
+
+    /**************************************************************************************************************/
+
+    // 백분위수 (nearest-rank)
+    double percentile(const std::vector<double>& sorted, double p)
+    {
+        if (sorted.empty()) return 0;
+
+        const auto rank = static_cast<size_t>(std::ceil(p / 100 * sorted.size()));
+        return sorted.at(std::clamp<size_t>(rank, 1, sorted.size()) - 1);
+    }
+
+    // "name": { "mean": .., "p50": .., "p95": .., "p99": .., "max": .. }
+    template <typename GET>
+    void writeStats(std::ostream& os, const char* name, GET get, bool last)
+    {
+        std::vector<double> values;
+        values.reserve(samples.size());
+        for (const auto& s : samples) values.push_back(static_cast<double>(get(s)));
+
+        std::sort(values.begin(), values.end());
+
+        const double sum = std::accumulate(values.begin(), values.end(), 0.0);
+        const double mean = values.empty() ? 0 : sum / values.size();
+
+        std::array<char, 256> buff;
+        std::snprintf(
+            buff.data(),
+            buff.size(),
+            "  \"%s\": { \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f, \"total\": %.4f }%s",
+            name,
+            mean,
+            percentile(values, 50),
+            percentile(values, 95),
+            percentile(values, 99),
+            values.empty() ? 0 : values.back(),
+            sum,
+            last ? "" : ","
+        );
+        os << buff.data() << std::endl;
+    }
+
+    // JSON 문자열 이스케이프
+    std::string quote(const std::string& str)
+    {
+        std::string out = "\"";
+        for (const char c : str)
+        {
+            if (c == '"' || c == '\\') out.push_back('\\');
+            if (static_cast<unsigned char>(c) >= 0x20) out.push_back(c);
+        }
+        out.push_back('"');
+        return out;
+    }
+
+    void report(std::ostream& os)
+    {
+        // 남은 쿼리 받기
+        for (size_t i = 0; i < queries.size(); i++)
+        {
+            collectQuery(i, true);
+        }
+        if (queries.front() != 0)
+        {
+            glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data());
+            queries.fill(0);
+        }
+
+        const auto renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+        const auto size = platform::size();
+
+        os << "{" << std::endl;
+        os << "  \"script\": "   << quote(script.path)                       << "," << std::endl;
+        os << "  \"renderer\": " << quote(renderer ? renderer : "")          << "," << std::endl;
+        os << "  \"headless\": " << (platform::headless() ? "true" : "false") << "," << std::endl;
+        os << "  \"width\": "    << size.w                                   << "," << std::endl;
+        os << "  \"height\": "   << size.h                                   << "," << std::endl;
+        os << "  \"frames\": "   << samples.size()                           << "," << std::endl;
+        os << "  \"warmup\": "   << script.warmup                            << "," << std::endl;
+
+        writeStats(os, "cpu_ms",         [](const Sample& s) { return s.cpuMs;         }, false);
+        writeStats(os, "gpu_ms",         [](const Sample& s) { return s.gpuMs;         }, false);
+        writeStats(os, "draw_calls",     [](const Sample& s) { return s.drawCalls;     }, false);
+        writeStats(os, "bytes_uploaded", [](const Sample& s) { return s.bytesUploaded; }, true );
+
+        os << "}" << std::endl;
+    }
+}
@@ -0,0 +1,32 @@
+﻿// 스크립트 기반 벤치마크
+// 카메라 키프레임, 시작 날짜, 설정 변경을 스크립트로 받아서 정해진 프레임 수만큼 고정된 시간 간격으로 렌더링하고
+// CPU, GPU 프레임 시간 백분위수와 그리기 호출 수, 업로드 크기를 JSON 으로 출력한다.
+// 스크립트 형식은 resources/benchmark.txt 참조.
+
+#pragma once
+
+#include <ostream>
+#include <string>
+
+namespace benchmark
+{
+    // 스크립트 읽기. 실패하면 예외 발생.
+    void load(const std::string& path);
+
+    // 벤치마크 실행중인지
+    bool active() noexcept;
+
+    // 모든 프레임을 다 그렸는지
+    bool finished() noexcept;
+
+    // 렌더링 직전, 직후에 호출. 로딩이 끝나기 전에는 아무것도 안 함
+    // CPU 시간은 그 사이 (화면 갱신 제외), GPU 시간은 그 사이에 보낸 명령의 실행 시간
+    void beginFrame();
+    void endFrame();
+
+    // 렌더러에 넘겨줄 프레임 간격 (초)
+    double frameSeconds() noexcept;
+
+    // 결과 출력. 아직 결과를 받지 못한 GPU 쿼리는 기다린다
+    void report(std::ostream& os);
+}
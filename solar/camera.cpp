@@ -14,6 +14,7 @@
 
 #include "constants.h"
 #include "planet.h"
+#include "snapshot.h"
 #include "utils.h"
 #include "v.h"
 
@@ -25,7 +26,9 @@ namespace camera
     // 중심 좌표
     glm::vec3 center;
 
-    Camera mat{};
+    Camera mat{}; // 쓰는 쪽 원본. lock 잡고 고침
+
+    SeqLock<Camera> published; // 읽는 쪽에 내보낸 값
 
     // 중심 이동할 때 쓰는거...
     glm::vec3 panningCameraPos;
@@ -35,6 +38,8 @@ namespace camera
     void updateProjection()
     {
         mat.matProjection = glm::perspective(CAMERA_PERSPECTIVE_FOV, mat.aspect, CAMERA_PERSPECTIVE_NEAR, CAMERA_PERSPECTIVE_FAR);
+
+        published.publish(mat);
     }
 
     // 뷰 매트릭스 업데이트. facesLock 하면 안됨
@@ -68,6 +73,8 @@ namespace camera
 
         panningMatrix = glm::inverse(panningMatrix);
 
+        published.publish(mat);
+
         /*
         if constexpr (IS_DEBUG)
         {
@@ -122,11 +129,14 @@ namespace camera
         updateView();
     }
 
-    Camera get()
+    Camera get(uint64_t* version)
     {
-        LOCK_CAMERA;
+        return published.read(version);
+    }
 
-        return mat;
+    uint64_t version()
+    {
+        return published.version();
     }
     
     void update(const Camera cam)
@@ -165,6 +175,9 @@ namespace camera
 
     void setFocus(int planetIndex)
     {
+        // 천체 목록에 없는 천체
+        if (planetIndex < 0 || static_cast<size_t>(planetIndex) >= planet::planetList.size()) return;
+
         LOCK_CAMERA;
 
         mat.focusedPlanet = planetIndex;
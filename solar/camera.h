@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include <cstdint>
+
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
@@ -35,10 +37,11 @@ namespace camera
     void resetAngle(); // 카메라 각도 초기화
     void resetCenter(); // 카메라 위치 초기화
 
-    Camera get();
+    Camera get(uint64_t* version = nullptr); // 잠그지 않고 마지막으로 바뀐 값을 가져옴. version 에는 가져온 값의 버전
 
     void update(const Camera cam);
 
+    uint64_t version(); // 카메라가 바뀔 때 마다 증가. 다시 그려야 하는지 확인용
 
     void cbFramebufferSize(GLFWwindow* window, int w, int h); // 화면 비율 설정
     void setFocus(int planetIndex); // 행성 바라보기 설정
@@ -0,0 +1,360 @@
+﻿#include "catalog.h"
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+#include "constants.h"
+#include "utils.h"
+
+namespace catalog
+{
+    constexpr uint32_t BINARY_MAGIC   = 0x43425353; // "SSBC"
+    constexpr uint32_t BINARY_VERSION = 3;
+
+    // 캐시에는 내부 단위로 변환한 값이 들어가므로 변환에 쓴 상수도 같이 저장해둠.
+    // constants.h 에서 배율을 바꾸면 파일 시간은 그대로라도 다시 만들어야 함
+    struct UnitHeader
+    {
+        double au;        // au2unit(1)
+        double km;        // km2unit(1)
+        double planetMul; // PLANET_SIZE_MUL
+        double radian;    // glm::radians(1)
+
+        bool operator==(const UnitHeader& other) const noexcept
+        {
+            return this->au == other.au && this->km == other.km && this->planetMul == other.planetMul && this->radian == other.radian;
+        }
+    };
+
+    UnitHeader currentUnits()
+    {
+        return UnitHeader{ au2unit(1), km2unit(1), PLANET_SIZE_MUL, glm::radians(1.0) };
+    }
+
+    Bodies current;
+
+    // 이름 -> index
+    std::unordered_map<std::string, int> nameIndex;
+
+    /**************************************************************************************************************/
+
+    // 문자열 버퍼에 추가하고 위치 반환
+    uint32_t addString(Bodies& bodies, const std::string& str)
+    {
+        const auto offset = static_cast<uint32_t>(bodies.strings.size());
+        bodies.strings.insert(bodies.strings.end(), str.begin(), str.end());
+        bodies.strings.push_back('\0');
+        return offset;
+    }
+
+    // 부모 -> 자식 인접 목록 만들기
+    void buildChildren(Bodies& bodies)
+    {
+        const auto count = bodies.size();
+
+        // 자식 수 세기
+        bodies.childrenOffset.assign(count + 1, 0);
+        for (size_t i = 0; i < count; i++)
+        {
+            const auto parent = bodies.parent.at(i);
+            if (parent != -1) bodies.childrenOffset.at(parent + 1)++;
+        }
+
+        // 누적해서 시작 위치로
+        for (size_t i = 0; i < count; i++)
+        {
+            bodies.childrenOffset.at(i + 1) += bodies.childrenOffset.at(i);
+        }
+
+        // 채우기. 목록 순서 유지
+        std::vector<uint32_t> cursor(bodies.childrenOffset.begin(), bodies.childrenOffset.end() - 1);
+
+        bodies.children.resize(bodies.childrenOffset.back());
+        for (size_t i = 0; i < count; i++)
+        {
+            const auto parent = bodies.parent.at(i);
+            if (parent != -1) bodies.children.at(cursor.at(parent)++) = static_cast<int32_t>(i);
+        }
+    }
+
+    void buildNameIndex(const Bodies& bodies)
+    {
+        nameIndex.clear();
+        nameIndex.reserve(bodies.size());
+
+        for (size_t i = 0; i < bodies.size(); i++)
+        {
+            nameIndex.emplace(bodies.name(static_cast<int>(i)), static_cast<int>(i));
+        }
+    }
+
+    /**************************************************************************************************************/
+
+    OrbitType parseOrbitType(const std::string& str)
+    {
+        if (str == "none"    ) return OrbitNone;
+        if (str == "kepler"  ) return OrbitKepler;
+        if (str == "circular") return OrbitCircular;
+
+        throw std::runtime_error("Unknown orbit type: " + str);
+    }
+
+    uint32_t parseMaterial(const std::string& str)
+    {
+        uint32_t material = MaterialNone;
+        if (str == "-") return material;
+
+        std::istringstream ss(str);
+        std::string token;
+        while (std::getline(ss, token, ','))
+        {
+                 if (token == "emissive") material |= MaterialEmissive;
+            else if (token == "earth"   ) material |= MaterialEarth;
+            else if (token == "ring"    ) material |= MaterialRing;
+            else if (token == "virtual" ) material |= MaterialVirtual;
+            else throw std::runtime_error("Unknown material: " + token);
+        }
+
+        return material;
+    }
+
+    // 궤도 요소 단위 변경. degree 는 radian 으로, AU 단위도 내부단위로
+    Elements convertElements(const double (&v)[6])
+    {
+        return Elements{
+            au2unit(v[0]),
+            v[1],
+            glm::radians(v[2]),
+            glm::radians(v[3]),
+            glm::radians(v[4]),
+            glm::radians(v[5]),
+        };
+    }
+
+    void parseText(const std::string& path, Bodies& bodies)
+    {
+        std::ifstream fs(path);
+        if (!fs.is_open())
+        {
+            throw std::runtime_error("Failed to open catalog. path: " + path);
+        }
+
+        // 부모는 이름으로 적혀있으니 다 읽고 나서 연결
+        std::vector<std::string> parentNames;
+
+        std::string line;
+        std::istringstream ss;
+        int lineNumber = 0;
+
+        while (std::getline(fs, line))
+        {
+            lineNumber++;
+
+            // 주석 제거
+            const auto comment = line.find('#');
+            if (comment != std::string::npos) line.erase(comment);
+
+            ss.clear();
+            ss.str(line);
+
+            std::string name;
+            if (!(ss >> name)) continue; // 빈 줄
+
+            std::string texture, color, parent, orbit, material;
+            float diameter = 0, resolutionPeriod = 0, tilt = 0;
+            double rotationPeriod = 0, rotationPhase = 0;
+            double elements[6] = {}, rates[6] = {};
+
+            ss >> texture >> color >> diameter >> resolutionPeriod >> rotationPeriod >> tilt >> rotationPhase >> parent >> orbit >> material;
+            for (auto& v : elements) ss >> v;
+            for (auto& v : rates   ) ss >> v;
+
+            if (ss.fail())
+            {
+                throw std::runtime_error("Invalid catalog line. path: " + path + ", line: " + std::to_string(lineNumber));
+            }
+
+            bodies.nameOffset      .push_back(addString(bodies, name));
+            bodies.textureOffset   .push_back(addString(bodies, texture == "-" ? "" : texture));
+            bodies.color           .push_back(static_cast<uint32_t>(std::stoul(color, nullptr, 16)));
+            bodies.radius          .push_back(km2unit(diameter) / 2 * PLANET_SIZE_MUL);
+            bodies.resolutionPeriod.push_back(resolutionPeriod);
+            bodies.rotationPeriod  .push_back(rotationPeriod);
+            bodies.tilt            .push_back(glm::radians(tilt));
+            bodies.rotationPhase   .push_back(rotationPhase - std::floor(rotationPhase));
+            bodies.parent          .push_back(-1);
+            bodies.orbitType       .push_back(parseOrbitType(orbit));
+            bodies.material        .push_back(parseMaterial(material));
+            bodies.elements        .push_back(convertElements(elements));
+            bodies.rates           .push_back(convertElements(rates));
+
+            parentNames.push_back(parent);
+        }
+
+        // 부모 연결
+        buildNameIndex(bodies);
+        for (size_t i = 0; i < parentNames.size(); i++)
+        {
+            const auto& parent = parentNames.at(i);
+            if (parent == "-") continue;
+
+            const auto it = nameIndex.find(parent);
+            if (it == nameIndex.end())
+            {
+                throw std::runtime_error("Unknown parent: " + parent);
+            }
+
+            bodies.parent.at(i) = it->second;
+        }
+
+        buildChildren(bodies);
+    }
+
+    /**************************************************************************************************************/
+
+    template <typename T>
+    void writeVector(std::ofstream& fs, const std::vector<T>& v)
+    {
+        const uint64_t size = v.size();
+        fs.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        fs.write(reinterpret_cast<const char*>(v.data()), size * sizeof(T));
+    }
+
+    template <typename T>
+    void readVector(std::ifstream& fs, std::vector<T>& v)
+    {
+        uint64_t size = 0;
+        fs.read(reinterpret_cast<char*>(&size), sizeof(size));
+        if (!fs) return;
+
+        v.resize(static_cast<size_t>(size));
+        fs.read(reinterpret_cast<char*>(v.data()), size * sizeof(T));
+    }
+
+    bool readBinary(const std::string& path, Bodies& bodies)
+    {
+        std::ifstream fs(path, std::ios::binary);
+        if (!fs.is_open()) return false;
+
+        uint32_t magic = 0, version = 0;
+        UnitHeader units{};
+        fs.read(reinterpret_cast<char*>(&magic),   sizeof(magic));
+        fs.read(reinterpret_cast<char*>(&version), sizeof(version));
+        fs.read(reinterpret_cast<char*>(&units),   sizeof(units));
+
+        if (!fs || magic != BINARY_MAGIC || version != BINARY_VERSION) return false;
+        if (!(units == currentUnits()))
+        {
+            std::cout << "catalog : cache units changed. rebuilding" << std::endl;
+            return false;
+        }
+
+        readVector(fs, bodies.strings);
+        readVector(fs, bodies.nameOffset);
+        readVector(fs, bodies.textureOffset);
+        readVector(fs, bodies.color);
+        readVector(fs, bodies.radius);
+        readVector(fs, bodies.resolutionPeriod);
+        readVector(fs, bodies.rotationPeriod);
+        readVector(fs, bodies.tilt);
+        readVector(fs, bodies.rotationPhase);
+        readVector(fs, bodies.parent);
+        readVector(fs, bodies.orbitType);
+        readVector(fs, bodies.material);
+        readVector(fs, bodies.elements);
+        readVector(fs, bodies.rates);
+
+        if (!fs) return false;
+
+        buildNameIndex(bodies);
+        buildChildren(bodies);
+
+        return true;
+    }
+
+    void writeBinary(const std::string& path, const Bodies& bodies)
+    {
+        std::ofstream fs(path, std::ios::binary | std::ios::trunc);
+        if (!fs.is_open())
+        {
+            std::cout << "catalog : failed to write cache. path: " << path << std::endl;
+            return;
+        }
+
+        fs.write(reinterpret_cast<const char*>(&BINARY_MAGIC),   sizeof(BINARY_MAGIC));
+        fs.write(reinterpret_cast<const char*>(&BINARY_VERSION), sizeof(BINARY_VERSION));
+
+        const auto units = currentUnits();
+        fs.write(reinterpret_cast<const char*>(&units), sizeof(units));
+
+        // 인접 목록은 읽을 때 다시 만든다
+        writeVector(fs, bodies.strings);
+        writeVector(fs, bodies.nameOffset);
+        writeVector(fs, bodies.textureOffset);
+        writeVector(fs, bodies.color);
+        writeVector(fs, bodies.radius);
+        writeVector(fs, bodies.resolutionPeriod);
+        writeVector(fs, bodies.rotationPeriod);
+        writeVector(fs, bodies.tilt);
+        writeVector(fs, bodies.rotationPhase);
+        writeVector(fs, bodies.parent);
+        writeVector(fs, bodies.orbitType);
+        writeVector(fs, bodies.material);
+        writeVector(fs, bodies.elements);
+        writeVector(fs, bodies.rates);
+    }
+
+    /**************************************************************************************************************/
+
+    void load()
+    {
+        if (utils::isCacheFresh(CATALOG_CACHE_PATH, CATALOG_SOURCE_PATH))
+        {
+            Bodies bodies;
+            if (readBinary(CATALOG_CACHE_PATH, bodies))
+            {
+                current = std::move(bodies);
+                std::cout << "catalog : loaded cache. count: " << current.size() << std::endl;
+                return;
+            }
+        }
+
+        Bodies bodies;
+        parseText(CATALOG_SOURCE_PATH, bodies);
+
+        if (bodies.size() == 0)
+        {
+            throw std::runtime_error(std::string("Empty catalog. path: ") + CATALOG_SOURCE_PATH);
+        }
+
+        current = std::move(bodies);
+        std::cout << "catalog : parsed " << CATALOG_SOURCE_PATH << ". count: " << current.size() << std::endl;
+
+        writeBinary(CATALOG_CACHE_PATH, current);
+    }
+
+    const Bodies& bodies()
+    {
+        return current;
+    }
+
+    Children children(int index)
+    {
+        const auto first = current.childrenOffset.at(index);
+        const auto last  = current.childrenOffset.at(index + 1);
+
+        return Children{ current.children.data() + first, current.children.data() + last };
+    }
+
+    int find(const std::string& name)
+    {
+        const auto it = nameIndex.find(name);
+        return it == nameIndex.end() ? -1 : it->second;
+    }
+}
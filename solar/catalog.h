@@ -0,0 +1,104 @@
+﻿// 천체 목록
+// 행성, 위성 정보를 resources/bodies.txt 에서 읽어서 항목별 배열 (SoA) 로 저장한다.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace catalog
+{
+    // 공전 궤도 계산 방법
+    enum OrbitType : uint8_t
+    {
+        OrbitNone,     // 공전하지 않음 (태양)
+        OrbitKepler,   // 케플러 궤도 요소와 변화율
+        OrbitCircular, // 기울어진 원 궤도. a, I, L 만 사용 (달)
+    };
+
+    // 렌더링할 때 쓰는 재질 플래그
+    enum Material : uint32_t
+    {
+        MaterialNone     = 0,
+        MaterialEmissive = 1 << 0, // 스스로 빛남. 조명 계산 안 함
+        MaterialEarth    = 1 << 1, // 반사광, 야간, 구름 텍스쳐 사용
+        MaterialRing     = 1 << 2, // 고리 있음
+        MaterialVirtual  = 1 << 3, // 큰 텍스쳐. 타일로 나눠서 필요한 부분만 올림 (vtexture.h)
+    };
+
+    // 케플러 궤도 요소. 내부 단위 (opengl 좌표, radian) 로 변환해서 저장함.
+    struct Elements
+    {
+        double a;  // 장반경
+        double e;  // 이심률
+        double I;  // 기울기
+        double L;  // 평균 경도
+        double Lp; // 근일점 경도
+        double o;  // 승교점 적경
+    };
+
+    // 천체 목록.
+    struct Bodies
+    {
+        // 이름, 텍스쳐 이름은 하나의 버퍼에 이어서 저장함. offset 위치부터 null 문자까지
+        std::vector<char>     strings;
+        std::vector<uint32_t> nameOffset;
+        std::vector<uint32_t> textureOffset; // 텍스쳐 없으면 빈 문자열
+
+        std::vector<uint32_t> color;            // 궤도 고유 색. 0xRRGGBB
+        std::vector<float>    radius;           // 반지름. opengl 좌표 단위
+        std::vector<float>    resolutionPeriod; // 공전 주기 (day)
+        std::vector<double>   rotationPeriod;   // 자전 주기 (day). 위상 계산용이라 double
+        std::vector<float>    tilt;             // 자전축 기울기 (radian)
+        std::vector<double>   rotationPhase;    // J2000 시점의 자전 위상. 0 ~ 1
+        std::vector<int32_t>  parent;           // 부모 천체. 없으면 -1
+        std::vector<uint8_t>  orbitType;        // OrbitType
+        std::vector<uint32_t> material;         // Material 조합
+
+        std::vector<Elements> elements; // J2000 시점 궤도 요소
+        std::vector<Elements> rates;    // 100 년 당 변화율
+
+        // 부모 -> 자식 인접 목록.
+        // index 의 자식들은 children[childrenOffset[index]] ~ children[childrenOffset[index + 1]]
+        std::vector<uint32_t> childrenOffset;
+        std::vector<int32_t>  children;
+
+        size_t size() const noexcept { return this->parent.size(); }
+
+        const char* name   (int index) const { return &this->strings.at(this->nameOffset   .at(index)); }
+        const char* texture(int index) const { return &this->strings.at(this->textureOffset.at(index)); }
+    };
+
+    // 자식 천체 목록. range-based for 용
+    struct Children
+    {
+        const int32_t* first;
+        const int32_t* last;
+
+        const int32_t* begin() const noexcept { return this->first; }
+        const int32_t* end()   const noexcept { return this->last;  }
+
+        size_t size() const noexcept { return this->last - this->first; }
+    };
+
+    // 천체 목록 읽기. 실패하면 예외 발생.
+    // 바이너리 캐시가 텍스트 파일보다 최신이고 단위 변환 상수가 같으면 캐시를 사용하고, 아니면 텍스트 파일을 읽고 캐시를 새로 만든다.
+    void load();
+
+    // 읽어둔 천체 목록
+    const Bodies& bodies();
+
+    // 자식 천체 목록
+    Children children(int index);
+
+    // 이름으로 찾기. 없으면 -1
+    int find(const std::string& name);
+
+    // 텍스트 형식 읽기. 한 줄에 천체 하나. 형식은 resources/bodies.txt 참조.
+    void parseText(const std::string& path, Bodies& bodies);
+
+    // 바이너리 형식 읽고 쓰기
+    bool readBinary(const std::string& path, Bodies& bodies);
+    void writeBinary(const std::string& path, const Bodies& bodies);
+}
@@ -1,8 +1,14 @@
 ﻿#include "config.h"
 
 #include <algorithm>
+#include <array>
+#include <string>
+#include <tuple>
 
 #include "constants.h"
+#include "platform.h"
+#include "simulation.h"
+#include "snapshot.h"
 
 namespace config
 {
@@ -10,7 +16,34 @@ namespace config
     std::mutex lock;
     #define LOCK_CONFIG std::lock_guard<std::mutex> __lock_camera(lock);
 
-    Config cfg;
+    Config cfg; // 쓰는 쪽 원본. lock 잡고 고침
+
+    SeqLock<Config> published; // 읽는 쪽에 내보낸 값. 값이 바뀌었을 때만 씀
+
+    // 바뀐 값 내보내기. lock 잡고 호출
+    void publish()
+    {
+        published.publish(cfg);
+
+        // 일시정지 중 잠들어 있는 계산 스레드도 새 설정으로 다시 계산하도록
+        simulation::notify();
+    }
+
+    // 모든 값이 같은지
+    bool same(const Config& a, const Config& b)
+    {
+        const auto tie = [](const Config& c) {
+            return std::tie(
+                c.speed, c.vsync, c.playAnimation,
+                c.showDate, c.showSpeed, c.showFPS, c.showHelp,
+                c.showOrbit, c.showOrbitColored, c.showOrbitGradient, c.showOrbitType,
+                c.showPlanetName, c.showMinorBodies, c.showBackground,
+                c.useEphemeris, c.ephemerisPrecision,
+                c.enableMSAA, c.enableProfiler, c.renderOnDemand
+            );
+        };
+        return tie(a) == tie(b);
+    }
 
     Config reset()
     {
@@ -35,17 +68,30 @@ namespace config
 
         cfgNew.showPlanetName = true;
 
+        cfgNew.showMinorBodies = true;
+
         cfgNew.showBackground = true;
 
+        cfgNew.useEphemeris = true;
+        cfgNew.ephemerisPrecision = EPHEMERIS_PRECISION_DEFAULT;
+
         cfgNew.enableMSAA = true;
 
+        cfgNew.enableProfiler = false;
+
+        cfgNew.renderOnDemand = true;
+
         return update(cfgNew);
     }
 
-    Config get()
+    Config get(uint64_t* version)
     {
-        LOCK_CONFIG;
-        return cfg;
+        return published.read(version);
+    }
+
+    uint64_t version()
+    {
+        return published.version();
     }
 
     void speedDelta(float delta, bool byMouse)
@@ -60,6 +106,8 @@ namespace config
             SPEED_MAX
         );
 
+        publish();
+
         std::cout << "speed :" << cfg.speed << std::endl;
     }
 
@@ -67,6 +115,8 @@ namespace config
     {
         LOCK_CONFIG;
 
+        const Config cfgOld = cfg;
+
         // 값 업데이트
         cfg.speed             = cfgNew.speed;
         cfg.playAnimation     = cfgNew.playAnimation;
@@ -79,7 +129,13 @@ namespace config
         cfg.showOrbitGradient = cfgNew.showOrbitGradient;
         cfg.showOrbitType     = cfgNew.showOrbitType;
         cfg.showPlanetName    = cfgNew.showPlanetName;
+        cfg.showMinorBodies   = cfgNew.showMinorBodies;
         cfg.showBackground    = cfgNew.showBackground;
+        cfg.useEphemeris      = cfgNew.useEphemeris;
+        cfg.enableProfiler    = cfgNew.enableProfiler;
+        cfg.renderOnDemand    = cfgNew.renderOnDemand;
+
+        cfg.ephemerisPrecision = std::clamp(cfgNew.ephemerisPrecision, EPHEMERIS_PRECISION_MIN, EPHEMERIS_PRECISION_MAX);
 
         // MSAA 값 변화
         if (cfg.enableMSAA != cfgNew.enableMSAA)
@@ -99,39 +155,95 @@ namespace config
         if (cfg.vsync != cfgNew.vsync)
         {
             cfg.vsync = cfgNew.vsync;
-            if (cfgNew.vsync)
-            {
-                glfwSwapInterval(1);
-            }
-            else
-            {
-                glfwSwapInterval(0);
-            }
+            platform::setSwapInterval(cfgNew.vsync ? 1 : 0);
         }
 
+        if (!same(cfgOld, cfg)) publish();
+
         return cfgNew;
     }
 
+    /**************************************************************************************************************/
+    // 이름으로 바꿀 수 있는 설정 (스크립트용)
+
+    struct Option
+    {
+        const char*     name;
+        bool  Config::* b;
+        int   Config::* i;
+        float Config::* f;
+    };
+
+    const std::array<Option, 17> OPTIONS = {{
+        { "speed",              nullptr,                    nullptr,                     &Config::speed },
+        { "vsync",              &Config::vsync,             nullptr,                     nullptr },
+        { "showDate",           &Config::showDate,          nullptr,                     nullptr },
+        { "showSpeed",          &Config::showSpeed,         nullptr,                     nullptr },
+        { "showFPS",            &Config::showFPS,           nullptr,                     nullptr },
+        { "showHelp",           &Config::showHelp,          nullptr,                     nullptr },
+        { "showOrbit",          &Config::showOrbit,         nullptr,                     nullptr },
+        { "showOrbitColored",   &Config::showOrbitColored,  nullptr,                     nullptr },
+        { "showOrbitGradient",  &Config::showOrbitGradient, nullptr,                     nullptr },
+        { "showOrbitType",      nullptr,                    &Config::showOrbitType,      nullptr },
+        { "showPlanetName",     &Config::showPlanetName,    nullptr,                     nullptr },
+        { "showMinorBodies",    &Config::showMinorBodies,   nullptr,                     nullptr },
+        { "showBackground",     &Config::showBackground,    nullptr,                     nullptr },
+        { "useEphemeris",       &Config::useEphemeris,      nullptr,                     nullptr },
+        { "ephemerisPrecision", nullptr,                    &Config::ephemerisPrecision, nullptr },
+        { "enableMSAA",         &Config::enableMSAA,        nullptr,                     nullptr },
+        { "renderOnDemand",     &Config::renderOnDemand,    nullptr,                     nullptr },
+    }};
+
+    const Option* findOption(const std::string& name)
+    {
+        for (const auto& option : OPTIONS)
+        {
+            if (name == option.name) return &option;
+        }
+        return nullptr;
+    }
+
+    bool hasOption(const std::string& name)
+    {
+        return findOption(name) != nullptr;
+    }
+
+    bool setOption(Config& cfgTarget, const std::string& name, double value)
+    {
+        const auto option = findOption(name);
+        if (option == nullptr) return false;
+
+        if (option->b != nullptr) cfgTarget.*option->b = value != 0;
+        if (option->i != nullptr) cfgTarget.*option->i = static_cast<int>(value);
+        if (option->f != nullptr) cfgTarget.*option->f = static_cast<float>(value);
+
+        return true;
+    }
+
     void togglePlay()
     {
         LOCK_CONFIG;
         cfg.playAnimation = !cfg.playAnimation;
+        publish();
     }
     void toggleHelp()
     {
         LOCK_CONFIG;
         cfg.showHelp = !cfg.showHelp;
+        publish();
     }
 
     void pause()
     {
         LOCK_CONFIG;
         cfg.playAnimation = false;
+        publish();
     }
 
     void play()
     {
         LOCK_CONFIG;
         cfg.playAnimation = true;
+        publish();
     }
 }
@@ -1,6 +1,8 @@
 ﻿#pragma once
 
+#include <cstdint>
 #include <mutex>
+#include <string>
 #include <vector>
 
 namespace config
@@ -32,15 +34,30 @@ namespace config
 
         bool showPlanetName; // 행성 이름 표시
 
+        bool showMinorBodies; // 소행성대, 카이퍼 벨트 표시
+
         bool showBackground; // 배경 표시
 
+        bool useEphemeris;       // 급수로 행성 위치 계산
+        int  ephemerisPrecision; // 급수를 잘라낼 진폭 (log10 AU)
+
         bool enableMSAA; // MSAA 켜기/끄기
+
+        bool enableProfiler; // GPU 구간 측정
+
+        bool renderOnDemand; // 바뀐 것이 없으면 다시 그리지 않고 입력을 기다림
     };
 
     Config reset(); // 설정 초기화
     Config update(const Config cfg); // 설정 업데이트
     
-    Config get(); // 현재 설정 가져오기
+    Config get(uint64_t* version = nullptr); // 현재 설정 가져오기. 잠그지 않음. version 에는 가져온 값의 버전
+
+    uint64_t version(); // 설정이 바뀔 때 마다 증가. 다시 그려야 하는지 확인용
+
+    // 이름으로 설정 바꾸기 (스크립트용). 이름은 Config 멤버 이름. 모르는 이름이면 false
+    bool hasOption(const std::string& name);
+    bool setOption(Config& cfg, const std::string& name, double value);
 
     void speedDelta(float delta, bool isMouse); // 재생 속도 변경
 
@@ -2,10 +2,13 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 #include <glm/gtc/constants.hpp>
 
+#include "args.h"
 #include "model_text.h"
 #include "ui.h"
 #include "v.h"
@@ -21,8 +24,11 @@ constexpr bool IS_DEBUG = false;
 
 /********************************************************************************/
 
-inline std::string getTexturePath(const std::string& textureName) { return "textures\\" + textureName + ".png"; } // 텍스쳐 위치 가져오는 함수
-inline std::string getShaderPath (const std::string& shaderName ) { return "shaders\\"  + shaderName          ; } // 셰이더 위치 가져오는 함수
+constexpr const char* TEXTURE_PATH = "textures"; // 텍스쳐 폴더 기본값. --textures 로 바꿀 수 있음
+
+inline std::string getTexturePath(const std::string& textureName) { return args::get().textures + "/" + textureName + ".png"; } // 텍스쳐 위치 가져오는 함수
+inline std::string getVirtualTexturePath(const std::string& textureName) { return args::get().textures + "/" + textureName + ".vtex"; } // 타일로 나눠둔 텍스쳐 위치 (vtexture.h)
+inline std::string getShaderPath (const std::string& shaderName ) { return "shaders/"  + shaderName          ; } // 셰이더 위치 가져오는 함수
 
 /********************************************************************************/
 // 상수값
@@ -54,6 +60,22 @@ constexpr int FONT_SIZE_6 = 30;
 constexpr const char* FONT_PATH = "resources/D2Coding-Ver1.3.2-20180524.ttf";
 constexpr const char* FONT_SHADER = "text_2d";
 
+constexpr size_t FONT_LAYOUT_CACHE_SIZE = 512; // 배치를 기억해둘 문자열 수. 넘으면 비우고 다시 쌓음
+constexpr int    FONT_ATLAS_SIZE        = 1024; // 글자 아틀라스 텍스쳐 크기. 가득 차면 하나 더 만듦
+constexpr int    FONT_ATLAS_PADDING     = 1;    // 글자 사이 간격. 선형 보간으로 옆 글자가 번지지 않도록
+
+// 자주 바뀌는 숫자 글씨 (fps, 속도, 날자)
+constexpr const char* DYNAMIC_TEXT_SHADER       = "dynamic_text";
+constexpr size_t      DYNAMIC_TEXT_MAX_GLYPHS   = 64; // 한 번에 쓸 수 있는 글자 수
+constexpr size_t      DYNAMIC_TEXT_MAX_ALPHABET = 64; // 쓸 수 있는 글자 종류. 셰이더의 배열 크기와 같아야 함
+
+constexpr int    TEXT_WARMUP_WORKERS           = 2;  // 글자를 미리 그리는 스레드 수
+constexpr size_t TEXT_WARMUP_UPLOADS_PER_FRAME = 64; // 한 프레임에 텍스쳐로 올릴 글자 수
+
+constexpr const wchar_t* TEXT_BENCH_SAMPLE          = L"목성 Jupiter 2024-01-01 12:00:00 UTC 속도 x1000 FPS 60.0 토성 Saturn"; // --bench-text 에서 쓸 문자열
+constexpr size_t         TEXT_BENCH_ITERATIONS      = 20000; // 찾기, 배치 반복 횟수
+constexpr size_t         TEXT_BENCH_DRAW_ITERATIONS = 200;   // 그리기 반복 횟수
+
 /********************************************************************************/
 
 // MSAA 샘플링 값
@@ -63,9 +85,72 @@ constexpr float OPENGL_ANISTROPY = 16;
 constexpr v::Size2i    WINDOW_SIZE    = { 1024, 768 };  // 기본 윈도우 크기
 constexpr const char*  WINDOW_CAPTION = "Solar System"; // 윈도우 타이틀
 
+constexpr int HEADLESS_FRAMES_DEFAULT = 1; // 창 없이 실행할 때 로딩 후 그릴 프레임 수
+
+/********************************************************************************/
+// 벤치마크
+
+constexpr int    BENCHMARK_FRAMES_DEFAULT = 600;        // 기록할 프레임 수
+constexpr int    BENCHMARK_WARMUP_DEFAULT = 60;         // 기록 전에 버리는 프레임 수
+constexpr double BENCHMARK_STEP_DEFAULT   = 1;          // 프레임당 진행 일 수
+constexpr double BENCHMARK_FRAME_SECONDS  = 1.0 / 60;   // 렌더러에 넘겨주는 고정 프레임 간격
+constexpr size_t BENCHMARK_QUERY_LATENCY  = 4;          // GPU 시간 쿼리를 몇 프레임 늦게 읽을지
+
+/********************************************************************************/
+// GPU 구간 측정
+
+constexpr size_t      PROFILER_FRAME_LATENCY  = 4;                // 쿼리를 몇 프레임 늦게 읽을지
+constexpr int         PROFILER_MAX_SCOPES     = 64;               // 프레임당 최대 구간 수
+constexpr double      PROFILER_AVERAGE_WEIGHT = 0.05;             // 평균 갱신 비율
+constexpr uint64_t    PROFILER_HISTORY        = 600;              // CSV 로 내보낼 최근 프레임 수
+constexpr const char* PROFILER_CSV_PATH       = "profiler.csv";   // CSV 저장 위치
+
+/********************************************************************************/
+// CPU 구간 기록
+
+constexpr uint64_t    TRACE_BUFFER_EVENTS = 1 << 16;      // 스레드당 보관할 최근 구간 수
+constexpr const char* TRACE_JSON_PATH     = "trace.json"; // UI 에서 저장할 위치
+
+/********************************************************************************/
+// 내보내기
+
+constexpr int      EXPORT_FRAMES_DEFAULT = 300;            // 내보낼 프레임 수
+constexpr double   EXPORT_STEP_DEFAULT   = 1;              // 프레임당 진행 일 수
+constexpr int      EXPORT_FPS_DEFAULT    = 30;             // Y4M 헤더에 쓸 fps
+constexpr size_t   EXPORT_PBO_COUNT      = 3;              // 돌려쓸 PBO 수. 이만큼 늦게 읽음
+constexpr size_t   EXPORT_QUEUE_FRAMES   = 8;              // 인코딩 대기열 최대 길이
+constexpr int      EXPORT_WORKERS_MAX    = 8;              // 최대 인코딩 스레드 수
+constexpr uint64_t EXPORT_SYNC_TIMEOUT   = 1000000000;     // 읽기 완료를 기다릴 때 한 번에 기다릴 시간 (ns)
+
+constexpr const char* EXPORT_SHARD_TEMP_PATH = "export";     // 파이프로 내보낼 때 조각별 임시 파일 이름
+constexpr size_t      EXPORT_CONCAT_BUFFER   = 1 << 20;      // 조각을 합칠 때 읽기 버퍼 크기
+
+/********************************************************************************/
+// 회귀 테스트
+
+constexpr const char* REGRESS_GOLDEN_PATH     = "resources/golden"; // 정답 이미지 폴더
+constexpr const char* REGRESS_OUTPUT_PATH     = "regress";          // 실패한 장면의 결과, 차이 이미지 저장 폴더
+constexpr int         REGRESS_SETTLE_FRAMES   = 3;                  // 장면마다 비교 전에 버리는 프레임 수
+constexpr int         REGRESS_TIMED_FRAMES    = 5;                  // 시간을 잴 프레임 수. 마지막 프레임을 비교
+constexpr double      REGRESS_PIXEL_THRESHOLD = 3.0;                // 이보다 ΔE 가 크면 다른 픽셀
+constexpr double      REGRESS_MAX_DIFF_RATIO  = 0.002;              // 장면 기본 허용치. 다른 픽셀 비율
+
+/********************************************************************************/
+// 천체 위치 계산 스레드
+
+constexpr double SIMULATION_STEP_SECONDS      = 1.0 / 120; // 고정 간격 (초)
+constexpr int    SIMULATION_MAX_CATCHUP_STEPS = 12;        // 이보다 밀리면 따라잡지 않고 건너뜀
+
 // 텍스트 쓸 때 외각 여백
 constexpr float WINDOW_TEXT_MARGIN = 20; 
 
+// 글씨 레이어에서 위젯을 다시 쓸 때 더 지울 여백 (픽셀)
+constexpr float WINDOW_HUD_DIRTY_MARGIN = 2;
+
+// 도움말, 워터마크 같이 미리 그려두는 그림을 모아두는 텍스쳐
+constexpr int WINDOW_SPRITE_ATLAS_SIZE = 1024; // 가로 세로 크기 (픽셀)
+constexpr int WINDOW_SPRITE_PADDING    = 2;    // 그림 사이 여백 (픽셀). 필터링할 때 옆 그림이 번지지 않도록
+
 // 로딩
 constexpr const wchar_t*   WINDOW_LOADING_TEXT_FORMAT = 
     L"데이터를 불러오고 있습니다\n"
@@ -95,16 +180,16 @@ constexpr int              WINDOW_PAUSED_TEXT_SIZE        = FONT_SIZE_6;
 constexpr model::Alignment WINDOW_PAUSED_TEXT_ALIGN_HORIZ = model::Alignment::Middle; // 가로 정렬
 constexpr model::Alignment WINDOW_PAUSED_TEXT_ALIGN_VERTI = model::Alignment::Near;   // 세로 정렬
 
-// 날자
-constexpr const char*      WINDOW_DATE_TEXT             = "%04d-%02d-%02d %02d:%02d:%02d UTC";
+// 날자. yyyy-mm-dd hh:mm:ss UTC
+constexpr const char*      WINDOW_DATE_TEXT_SUFFIX      = " UTC";
 constexpr v::Color         WINDOW_DATE_TEXT_COLOR       = 0xFFFFFF;
 constexpr int              WINDOW_DATE_TEXT_SIZE        = FONT_SIZE_4;
 constexpr model::Alignment WINDOW_DATE_TEXT_ALIGN_HORIZ = model::Alignment::Near;  // 가로 정렬
 constexpr model::Alignment WINDOW_DATE_TEXT_ALIGN_VERTI = model::Alignment::Far; // 세로 정렬
 
 // 재생 속도
-constexpr const char*      WINDOW_SPEED_TEXT_FORMAT       = "%.3lf days / sec";
-constexpr const char*      WINDOW_SPEED_TEXT_FORMAT_EX    = "0000.00 days / sec"; // 버퍼 폭 계산용 텍스트 예시
+constexpr int              WINDOW_SPEED_TEXT_DECIMALS     = 3; // 소수점 아래 자리 수
+constexpr const char*      WINDOW_SPEED_TEXT_UNIT         = " days / sec";
 constexpr v::Color         WINDOW_SPEED_TEXT_COLOR        = 0xFFFFFF;
 constexpr int              WINDOW_SPEED_TEXT_SIZE         = FONT_SIZE_3;
 constexpr model::Alignment WINDOW_SPEED_TEXT_ALIGN_HORIZ  = model::Alignment::Far;  // 가로 정렬
@@ -113,17 +198,71 @@ constexpr model::Alignment WINDOW_SPEED_TEXT_ALIGN_VERTI  = model::Alignment::Ne
 // FPS
 // fps 표시 간격 (ms)
 constexpr float            WINDOW_FPS_UPDATE_INTERVAL   = 500.0f; // 갱신 간걱. ms
-constexpr const char*      WINDOW_FPS_TEXT_FORMAT       = "fps : %.1f (%.2f ms)";
-constexpr const char*      WINDOW_FPS_TEXT_FORMAT_EX    = "fps : 0000.0 (0000.00 ms)"; // 버퍼 폭 계산용 텍스트 예시
+constexpr const char*      WINDOW_FPS_TEXT_PREFIX       = "fps : "; // fps : 0.0 (0.00 ms)
+constexpr const char*      WINDOW_FPS_TEXT_TIME_PREFIX  = " (";
+constexpr const char*      WINDOW_FPS_TEXT_TIME_SUFFIX  = " ms)";
 constexpr v::Color         WINDOW_FPS_TEXT_COLOR        = 0xFFFFFF;
 constexpr int              WINDOW_FPS_TEXT_SIZE         = FONT_SIZE_3;
 constexpr model::Alignment WINDOW_FPS_TEXT_ALIGN_HORIZ  = model::Alignment::Far;  // 가로 정렬
 constexpr model::Alignment WINDOW_FPS_TEXT_ALIGN_VERTI  = model::Alignment::Near; // 세로 정렬
 
+// 날자, 속도, fps 에 쓰는 글자. 여기 없는 글자는 공백으로 나오므로 위 문자열에서 모아서 만듦
+struct DynamicTextAlphabet
+{
+    char   chars[DYNAMIC_TEXT_MAX_ALPHABET + 1] = {};
+    size_t size = 0;
+
+    constexpr bool contains(char c) const
+    {
+        for (size_t i = 0; i < this->size; i++) if (this->chars[i] == c) return true;
+        return false;
+    }
+
+    constexpr bool containsAll(const char* str) const
+    {
+        for (auto p = str; *p != 0; p++) if (!this->contains(*p)) return false;
+        return true;
+    }
+
+    constexpr void add(const char* str)
+    {
+        for (auto p = str; *p != 0; p++)
+        {
+            if (this->contains(*p) || this->size == DYNAMIC_TEXT_MAX_ALPHABET) continue;
+            this->chars[this->size++] = *p;
+        }
+    }
+};
+
+constexpr DynamicTextAlphabet makeDynamicTextAlphabet()
+{
+    DynamicTextAlphabet alphabet;
+    alphabet.add("0123456789-.: "); // 숫자, 날자 구분자
+    alphabet.add(WINDOW_DATE_TEXT_SUFFIX);
+    alphabet.add(WINDOW_SPEED_TEXT_UNIT);
+    alphabet.add(WINDOW_FPS_TEXT_PREFIX);
+    alphabet.add(WINDOW_FPS_TEXT_TIME_PREFIX);
+    alphabet.add(WINDOW_FPS_TEXT_TIME_SUFFIX);
+    return alphabet;
+}
+
+constexpr DynamicTextAlphabet WINDOW_DYNAMIC_TEXT_ALPHABET = makeDynamicTextAlphabet();
+
+// 글자 종류가 DYNAMIC_TEXT_MAX_ALPHABET 를 넘어서 빠진 글자가 없는지
+static_assert(WINDOW_DYNAMIC_TEXT_ALPHABET.containsAll(WINDOW_DATE_TEXT_SUFFIX),     "dynamic text alphabet is full");
+static_assert(WINDOW_DYNAMIC_TEXT_ALPHABET.containsAll(WINDOW_SPEED_TEXT_UNIT),      "dynamic text alphabet is full");
+static_assert(WINDOW_DYNAMIC_TEXT_ALPHABET.containsAll(WINDOW_FPS_TEXT_PREFIX),      "dynamic text alphabet is full");
+static_assert(WINDOW_DYNAMIC_TEXT_ALPHABET.containsAll(WINDOW_FPS_TEXT_TIME_PREFIX), "dynamic text alphabet is full");
+static_assert(WINDOW_DYNAMIC_TEXT_ALPHABET.containsAll(WINDOW_FPS_TEXT_TIME_SUFFIX), "dynamic text alphabet is full");
+
 constexpr int WINDOW_DRAG_MIN = 2; // 이 이상 움직이면 마우스 드래그로 간주. (픽셀)
 
 constexpr int WINDOW_LONG_PRESSED_TIME = 700; // 이 이상 누르고 있으면 꾹 누른 버튼으로 간주. (ms)
 
+// 필요할 때만 그리기 (일시정지 중 입력이 없으면 쉼)
+constexpr int    RENDER_REDRAW_FRAMES     = 2;                                   // 바뀐 뒤로 더 그릴 프레임 수
+constexpr double RENDER_IDLE_WAIT_SECONDS = WINDOW_FPS_UPDATE_INTERVAL / 1000.0; // 쉬는 동안 이벤트를 기다리는 최대 시간
+
 /********************************************************************************/
 
 constexpr float CAMERA_PERSPECTIVE_FOV  =    45;      // FOV
@@ -148,6 +287,24 @@ constexpr float CAMERA_AZIMUTH_DEFAULT     =   0;          // 기본값
 
 constexpr float CAMERA_MOVEMENT_DELTA = 0.2f; // percent/sec = 5초동안 화면의 100% 만큼 움직임
 
+/********************************************************************************/
+// 큰 텍스쳐 (가상 텍스쳐) -> vtexture.h
+
+constexpr int      VTEX_TILE_SIZE             = 128; // 타일 크기 (테두리 빼고)
+constexpr int      VTEX_TILE_BORDER           = 4;   // 타일 테두리. 옆 타일 내용을 복사해둬서 필터링할 때 이음매가 안 보이게 함
+constexpr int      VTEX_TILE_SLOT             = VTEX_TILE_SIZE + VTEX_TILE_BORDER * 2; // 풀에서 타일 하나가 차지하는 크기
+constexpr int      VTEX_POOL_SLOTS            = 24;  // 풀 가로, 세로 타일 수. 24 x 24 x 136 x 136 x 4 = 약 42 MB
+constexpr int      VTEX_MAX_LEVELS            = 16;  // 밉맵 단계 최대 수 (셰이더 배열 크기와 같아야 함)
+constexpr size_t   VTEX_UPLOADS_PER_FRAME     = 16;  // 한 프레임에 올리는 타일 수
+constexpr uint64_t VTEX_REQUEST_EXPIRE_FRAMES = 30;  // 이 프레임 수 동안 다시 요청하지 않은 타일은 읽지 않고 버림
+constexpr float    VTEX_FOOTPRINT_MARGIN      = 0.1f; // 패치 uv 범위 여유 (범위 대비 비율)
+
+/********************************************************************************/
+// 구체 메시 (행성, 은하수)
+
+constexpr size_t SPHERE_VERTEX_CACHE_SIZE     = 32; // 인덱스 순서를 정할 때 가정하는 post-transform 캐시 크기 (LRU)
+constexpr size_t SPHERE_VERTEX_CACHE_SIM_SIZE = 16; // 버텍스 셰이더 호출 횟수를 셀 때 쓰는 캐시 크기 (FIFO)
+
 /********************************************************************************/
 // 은하수 배경 = milky-way
 
@@ -184,6 +341,29 @@ constexpr float ORBIT_DOTTED_SIZE = 1; // 점 크기
 constexpr float ORBIT_SOLID_DAY_PER_VERTEX = 0.25; // n 일마다 버텍스 한개
 constexpr float ORBIT_DOTTED_DAY_PER_VERTEX = 2; // n 일마다 버텍스 한개
 
+constexpr int ORBIT_VERTEX_STRIDE = 5;   // 버텍스 하나당 float 수. X Y Z ANGLE SLOT
+constexpr int ORBIT_BATCH_SIZE    = 128; // 한번에 그리는 궤도 수. orbit.vert 의 OrbitBlock 크기와 맞춰야 함
+constexpr int ORBIT_UBO_BINDING   = 0;   // 궤도 정보 UBO 바인딩 위치
+
+/********************************************************************************/
+// 소천체 (소행성대, 카이퍼 벨트)
+
+constexpr const char* MINORBODY_SHADER      = "minorbody";
+constexpr const char* MINORBODY_SOURCE_PATH = "resources/MPCORB.DAT"; // MPC 궤도 요소 파일 기본값. --mpcorb 로 바꿀 수 있음. 없으면 표시 안 함
+constexpr const char* MINORBODY_CACHE_EXT   = ".bin";                 // 변환해둔 바이너리 파일. 원본 옆에 확장자만 바꿔서 저장
+
+constexpr float    MINORBODY_MAGNITUDE_DEFAULT = 20;    // 절대 등급이 없는 천체의 등급
+constexpr float    MINORBODY_MAGNITUDE_BRIGHT  =  5;    // 이 등급보다 밝으면 알파 최대
+constexpr float    MINORBODY_MAGNITUDE_FAINT   = 20;    // 이 등급보다 어두우면 알파 최소
+constexpr float    MINORBODY_ALPHA_MIN         = 0.15f; // 알파 최소값
+constexpr float    MINORBODY_ALPHA_MAX         = 0.80f; // 알파 최대값
+constexpr float    MINORBODY_POINT_SIZE        = 2;     // 점 크기 (픽셀)
+
+constexpr v::Color MINORBODY_COLOR_INNER = 0xC8B49A; // 소행성대 색
+constexpr v::Color MINORBODY_COLOR_OUTER = 0x8AA8D8; // 카이퍼 벨트 색
+constexpr float    MINORBODY_INNER_AU    =  5;       // 이 거리까지는 소행성대 색
+constexpr float    MINORBODY_OUTER_AU    = 30;       // 이 거리부터는 카이퍼 벨트 색
+
 /********************************************************************************/
 // 조명 상수
 
@@ -200,11 +380,27 @@ constexpr int      LIGHT_SHININESS = 4;        // 반사광빛나는 정도
 
 constexpr float PLANET_SIZE_MUL = 10; // 행성 크기 배율
 
+constexpr const char* CATALOG_SOURCE_PATH = "resources/bodies.txt"; // 천체 목록
+constexpr const char* CATALOG_CACHE_PATH  = "resources/bodies.bin"; // 변환해둔 바이너리 파일
+
+constexpr const char* EPHEMERIS_VSOP87_PATH       = "resources/vsop87/VSOP87A."; // VSOP87A 급수 파일 기본값. 뒤에 mer, ven ... 이 붙음. --vsop87 로 바꿀 수 있음. 없으면 케플러 궤도 사용
+constexpr int         EPHEMERIS_PRECISION_DEFAULT = -7;  // 급수를 잘라낼 진폭 (log10 AU). -7 이면 약 15 km
+constexpr int         EPHEMERIS_PRECISION_MIN     = -10;
+constexpr int         EPHEMERIS_PRECISION_MAX     = -2;
+
+constexpr size_t EPHEMERIS_BENCH_SAMPLES       = 2000; // --bench-ephemeris 에서 계산할 날짜 수
+constexpr double EPHEMERIS_BENCH_THRESHOLDS[]  = { 0, 1e-10, 1e-9, 1e-8, 1e-7, 1e-6, 1e-5, 1e-4, 1e-3 };
+
 constexpr const char* SUN_SHADER = "sun";
 
 constexpr const char* PLANET_MODEL_SHADER_NAME = "planet";
 constexpr int         PLANET_MODEL_SLICES_AND_STACKS = 100; // 행성 크기 1 당 slices 와 stacks 크기
 
+constexpr int   PLANET_LOD_GRID        = 32;    // 표면 패치 하나의 격자 수 (가로, 세로)
+constexpr int   PLANET_LOD_MAX_DEPTH   = 12;    // 표면 쿼드트리 최대 깊이
+constexpr float PLANET_LOD_PIXEL_ERROR = 8.0f;  // 격자 한 칸이 화면에서 이 픽셀보다 크면 패치를 나눔
+constexpr float PLANET_LOD_SKIRT_DEPTH = 0.05f; // 패치 사이 틈을 가리는 치마 깊이 (면 하나 크기의 패치 기준, 반지름 비율)
+
 constexpr const char* PLANET_SATURN_RING_SHADER           = "saturn_ring";
 constexpr const char* PLANET_SATURN_RING_TEXTURE          = "saturn_ring_alpha";
 constexpr int         PLANET_SATURN_RING_PARTICLES        = 720;   // 토성 고리 파티클 분할 수
@@ -0,0 +1,561 @@
+﻿#include "ephemeris.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <glm/gtc/constants.hpp>
+
+#include "args.h"
+#include "catalog.h"
+#include "constants.h"
+
+// 참고자료
+// VSOP87 : https://cdsarc.u-strasbg.fr/viz-bin/qcat?VI/81  (vsop87.doc 참조)
+// 달 : Jean Meeus, Astronomical Algorithms 2nd ed. chapter 47 (ELP-2000/82 의 주요 항)
+
+namespace ephemeris
+{
+    constexpr double PI2 = glm::two_pi<double>();
+    constexpr double DEG2RAD = glm::pi<double>() / 180;
+
+    constexpr double AU_KM = 149597870.7;
+
+    constexpr double daysPerMillennium = 1000 * 365.25;
+    constexpr double daysPerCentry     =  100 * 365.25;
+
+    constexpr int VSOP_VARIABLES = 3; // X Y Z
+    constexpr int VSOP_POWERS    = 6; // T^0 ~ T^5
+
+    // 한번에 계산하는 항 수. 임시 버퍼가 L1 캐시에 들어갈 정도
+    constexpr size_t EVAL_CHUNK = 256;
+
+    // 급수 하나의 위치. terms 배열 내에서 [first, first + count)
+    // 진폭이 큰 항부터 정렬되어 있어서 앞에서부터 필요한 만큼만 계산하면 됨.
+    struct Series
+    {
+        uint32_t first = 0;
+        uint32_t count = 0;
+    };
+
+    // A * cos(B + C * t) 항들. 항목별로 이어서 저장 (SoA)
+    struct Terms
+    {
+        std::vector<double> A;
+        std::vector<double> B;
+        std::vector<double> C;
+    };
+
+    // VSOP87 천체 하나
+    struct Body
+    {
+        Series series[VSOP_VARIABLES][VSOP_POWERS];
+    };
+
+    // 달 급수. 항 = coef * E^|M| * sin/cos(D * d + M * m + Mp * mp + F * f)
+    struct MoonTerms
+    {
+        std::vector<double> D, M, Mp, F; // 인수 배수. 곱할 때 변환하지 않도록 double 로 둔다
+        std::vector<double> coef;        // 계수 (radian, AU)
+        std::vector<double> amplitude;   // 잘라내기 기준 (AU). 내림차순
+    };
+
+    Terms terms;
+    std::vector<Body> vsop;
+    std::vector<int> bodyIndex; // planetIndex -> vsop 내의 위치. 없으면 -1
+
+    MoonTerms moonLongitude; // Σl
+    MoonTerms moonDistance;  // Σr
+    MoonTerms moonLatitude;  // Σb
+    int moonIndex = -1; // 달 급수를 다 읽은 뒤에 설정함
+
+    // 로딩 스레드에서 읽는 동안에는 사용하지 않도록. 위 값들은 ready 를 확인 (acquire) 한 뒤에만 읽음
+    std::atomic<bool> ready = false;
+
+    // VSOP87 파일 확장자. 카탈로그의 이름과 연결
+    const std::array<std::pair<const char*, const char*>, 8> VSOP_FILES = {{
+        { "Mercury", "mer" },
+        { "Venus",   "ven" },
+        { "Earth",   "ear" },
+        { "Mars",    "mar" },
+        { "Jupiter", "jup" },
+        { "Saturn",  "sat" },
+        { "Uranus",  "ura" },
+        { "Neptune", "nep" },
+    }};
+
+    /**************************************************************************************************************/
+    // Meeus 표 47.A, 47.B
+    // D M M' F 배수와 계수. 경도, 위도는 0.000001 도, 거리는 0.001 km 단위.
+
+    struct MoonLR { int8_t D, M, Mp, F; int32_t l, r; };
+    struct MoonB  { int8_t D, M, Mp, F; int32_t b; };
+
+    constexpr MoonLR MOON_LR[] = {
+        { 0,  0,  1,  0, 6288774, -20905355 }, { 2,  0, -1,  0, 1274027, -3699111 }, { 2,  0,  0,  0,  658314, -2955968 },
+        { 0,  0,  2,  0,  213618,   -569925 }, { 0,  1,  0,  0, -185116,    48888 }, { 0,  0,  0,  2, -114332,    -3149 },
+        { 2,  0, -2,  0,   58793,    246158 }, { 2, -1, -1,  0,   57066,  -152138 }, { 2,  0,  1,  0,   53322,  -170733 },
+        { 2, -1,  0,  0,   45758,   -204586 }, { 0,  1, -1,  0,  -40923,  -129620 }, { 1,  0,  0,  0,  -34720,   108743 },
+        { 0,  1,  1,  0,  -30383,    104755 }, { 2,  0,  0, -2,   15327,    10321 }, { 0,  0,  1,  2,  -12528,        0 },
+        { 0,  0,  1, -2,   10980,     79661 }, { 4,  0, -1,  0,   10675,   -34782 }, { 0,  0,  3,  0,   10034,   -23210 },
+        { 4,  0, -2,  0,    8548,    -21636 }, { 2,  1, -1,  0,   -7888,    24208 }, { 2,  1,  0,  0,   -6766,    30824 },
+        { 1,  0, -1,  0,   -5163,     -8379 }, { 1,  1,  0,  0,    4987,   -16675 }, { 2, -1,  1,  0,    4036,   -12831 },
+        { 2,  0,  2,  0,    3994,    -10445 }, { 4,  0,  0,  0,    3861,   -11650 }, { 2,  0, -3,  0,    3665,    14403 },
+        { 0,  1, -2,  0,   -2689,     -7003 }, { 2,  0, -1,  2,   -2602,        0 }, { 2, -1, -2,  0,    2390,    10056 },
+        { 1,  0,  1,  0,   -2348,      6322 }, { 2, -2,  0,  0,    2236,    -9884 }, { 0,  1,  2,  0,   -2120,     5751 },
+        { 0,  2,  0,  0,   -2069,         0 }, { 2, -2, -1,  0,    2048,    -4950 }, { 2,  0,  1, -2,   -1773,     4130 },
+        { 2,  0,  0,  2,   -1595,         0 }, { 4, -1, -1,  0,    1215,    -3958 }, { 0,  0,  2,  2,   -1110,        0 },
+        { 3,  0, -1,  0,    -892,      3258 }, { 2,  1,  1,  0,    -810,     2616 }, { 4, -1, -2,  0,     759,    -1897 },
+        { 0,  2, -1,  0,    -713,     -2117 }, { 2,  2, -1,  0,    -700,     2354 }, { 2,  1, -2,  0,     691,        0 },
+        { 2, -1,  0, -2,     596,         0 }, { 4,  0,  1,  0,     549,    -1423 }, { 0,  0,  4,  0,     537,    -1117 },
+        { 4, -1,  0,  0,     520,     -1571 }, { 1,  0, -2,  0,    -487,    -1739 }, { 2,  1,  0, -2,    -399,        0 },
+        { 0,  0,  2, -2,    -381,     -4421 }, { 1,  1,  1,  0,     351,        0 }, { 3,  0, -2,  0,    -340,        0 },
+        { 4,  0, -3,  0,     330,         0 }, { 2, -1,  2,  0,     327,        0 }, { 0,  2,  1,  0,    -323,     1165 },
+        { 1,  1, -1,  0,     299,         0 }, { 2,  0,  3,  0,     294,        0 }, { 2,  0, -1, -2,       0,     8752 },
+    };
+
+    constexpr MoonB MOON_B[] = {
+        { 0,  0,  0,  1, 5128122 }, { 0,  0,  1,  1,  280602 }, { 0,  0,  1, -1,  277693 }, { 2,  0,  0, -1,  173237 },
+        { 2,  0, -1,  1,   55413 }, { 2,  0, -1, -1,   46271 }, { 2,  0,  0,  1,   32573 }, { 0,  0,  2,  1,   17198 },
+        { 2,  0,  1, -1,    9266 }, { 0,  0,  2, -1,    8822 }, { 2, -1,  0, -1,    8216 }, { 2,  0, -2, -1,    4324 },
+        { 2,  0,  1,  1,    4200 }, { 2,  1,  0, -1,   -3359 }, { 2, -1, -1,  1,    2463 }, { 2, -1,  0,  1,    2211 },
+        { 2, -1, -1, -1,    2065 }, { 0,  1, -1, -1,   -1870 }, { 4,  0, -1, -1,    1828 }, { 0,  1,  0,  1,   -1794 },
+        { 0,  0,  0,  3,   -1749 }, { 0,  1, -1,  1,   -1565 }, { 1,  0,  0,  1,   -1491 }, { 0,  1,  1,  1,   -1475 },
+        { 0,  1,  1, -1,   -1410 }, { 0,  1,  0, -1,   -1344 }, { 1,  0,  0, -1,   -1335 }, { 0,  0,  3,  1,    1107 },
+        { 4,  0,  0, -1,    1021 }, { 4,  0, -1,  1,     833 }, { 0,  0,  1, -3,     777 }, { 4,  0, -2,  1,     671 },
+        { 2,  0,  0, -3,     607 }, { 2,  0,  2, -1,     596 }, { 2, -1,  1, -1,     491 }, { 2,  0, -2,  1,    -451 },
+        { 0,  0,  3, -1,     439 }, { 2,  0,  2,  1,     422 }, { 2,  0, -3, -1,     421 }, { 2,  1, -1,  1,    -366 },
+        { 2,  1,  0,  1,    -351 }, { 4,  0,  0,  1,     331 }, { 2, -1,  1,  1,     315 }, { 2, -2,  0, -1,     302 },
+        { 0,  0,  1,  3,    -283 }, { 2,  1,  1, -1,    -229 }, { 1,  1,  0, -1,     223 }, { 1,  1,  0,  1,     223 },
+        { 0,  1, -2, -1,    -220 }, { 2,  1, -1, -1,    -220 }, { 1,  0,  1,  1,    -185 }, { 2, -1, -2, -1,     181 },
+        { 0,  1,  2,  1,    -177 }, { 4,  0, -2, -1,     176 }, { 4, -1, -1, -1,     166 }, { 1,  0,  1, -1,    -164 },
+        { 4,  0,  1, -1,     132 }, { 1,  0, -1, -1,    -119 }, { 4, -1,  0, -1,     115 }, { 2, -2,  0,  1,     107 },
+    };
+
+    /**************************************************************************************************************/
+
+    // 진폭 순으로 정렬된 급수에서 threshold 이상인 항 수
+    uint32_t truncate(const Series& s, double threshold)
+    {
+        if (threshold <= 0) return s.count;
+
+        const auto first = terms.A.begin() + s.first;
+        const auto last  = first + s.count;
+        const auto it = std::partition_point(first, last, [threshold](double a) { return std::abs(a) >= threshold; });
+
+        return static_cast<uint32_t>(it - first);
+    }
+
+    // Σ A * cos(B + C * t)
+    // 인수 계산, cos, 곱셈을 각각 연속된 배열에 대한 단순 반복으로 나누어서 컴파일러가 벡터화할 수 있게 함.
+    double evaluate(const Series& s, double t, double threshold)
+    {
+        const uint32_t count = truncate(s, threshold);
+
+        const double* A = terms.A.data() + s.first;
+        const double* B = terms.B.data() + s.first;
+        const double* C = terms.C.data() + s.first;
+
+        std::array<double, EVAL_CHUNK> buff;
+
+        double sum = 0;
+        for (uint32_t start = 0; start < count; start += EVAL_CHUNK)
+        {
+            const uint32_t n = std::min<uint32_t>(EVAL_CHUNK, count - start);
+
+            for (uint32_t i = 0; i < n; i++) buff[i] = B[start + i] + C[start + i] * t;
+            for (uint32_t i = 0; i < n; i++) buff[i] = std::cos(buff[i]);
+            for (uint32_t i = 0; i < n; i++) sum += A[start + i] * buff[i];
+        }
+
+        return sum;
+    }
+
+    // Σ coef * E^|M| * sin(arg) 또는 cos(arg)
+    double evaluate(const MoonTerms& mt, const double (&arg)[4], double E, bool useCos, double threshold)
+    {
+        const auto it = threshold <= 0
+            ? mt.amplitude.end()
+            : std::partition_point(mt.amplitude.begin(), mt.amplitude.end(), [threshold](double a) { return a >= threshold; });
+        const size_t count = it - mt.amplitude.begin();
+
+        std::array<double, std::max(std::size(MOON_LR), std::size(MOON_B))> buff;
+
+        for (size_t i = 0; i < count; i++) buff[i] = mt.D[i] * arg[0] + mt.M[i] * arg[1] + mt.Mp[i] * arg[2] + mt.F[i] * arg[3];
+        if (useCos)
+        {
+            for (size_t i = 0; i < count; i++) buff[i] = std::cos(buff[i]);
+        }
+        else
+        {
+            for (size_t i = 0; i < count; i++) buff[i] = std::sin(buff[i]);
+        }
+
+        // 태양의 평균 근점이각 (M) 이 들어간 항은 지구 궤도 이심률 변화만큼 보정
+        double sum = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            const double m = std::abs(mt.M[i]);
+            const double e = m == 0 ? 1 : (m == 1 ? E : E * E);
+            sum += mt.coef[i] * e * buff[i];
+        }
+
+        return sum;
+    }
+
+    /**************************************************************************************************************/
+
+    // VSOP87 파일 하나 읽기
+    bool loadVSOP(const std::string& path, Body& body)
+    {
+        std::ifstream fs(path);
+        if (!fs.is_open()) return false;
+
+        Series* current = nullptr;
+
+        std::string line;
+        while (std::getline(fs, line))
+        {
+            // 머리말 : " VSOP87 VERSION A1    EARTH     VARIABLE 1 (XYZ)       *T**0    843 TERMS ..."
+            if (line.compare(0, 7, " VSOP87") == 0)
+            {
+                const auto posVar = line.find("VARIABLE");
+                const auto posPow = line.find("*T**");
+                if (posVar == std::string::npos || posPow == std::string::npos) return false;
+
+                const int variable = std::atoi(line.c_str() + posVar + 8) - 1;
+                const int power    = std::atoi(line.c_str() + posPow + 4);
+                if (variable < 0 || variable >= VSOP_VARIABLES || power < 0 || power >= VSOP_POWERS) return false;
+
+                current = &body.series[variable][power];
+                current->first = static_cast<uint32_t>(terms.A.size());
+                current->count = 0;
+                continue;
+            }
+
+            if (current == nullptr) continue;
+
+            // 항 : 마지막 숫자 세 개가 A B C
+            // 배수 항목은 붙어있을 수도 있어서 뒤에서부터 읽는다.
+            std::array<double, 3> abc{};
+            {
+                std::istringstream ss(line);
+                std::vector<std::string> tokens{ std::istream_iterator<std::string>(ss), std::istream_iterator<std::string>() };
+                if (tokens.size() < 3) continue;
+
+                for (size_t i = 0; i < 3; i++)
+                {
+                    abc[i] = std::strtod(tokens.at(tokens.size() - 3 + i).c_str(), nullptr);
+                }
+            }
+
+            terms.A.push_back(abc[0]);
+            terms.B.push_back(abc[1]);
+            terms.C.push_back(abc[2]);
+            current->count++;
+        }
+
+        // 진폭 큰 순서로 정렬. 잘라낼 때 앞에서부터 읽으면 되도록
+        for (auto& variable : body.series)
+        {
+            for (auto& s : variable)
+            {
+                std::vector<uint32_t> order(s.count);
+                for (uint32_t i = 0; i < s.count; i++) order[i] = s.first + i;
+
+                std::stable_sort(order.begin(), order.end(), [](uint32_t a, uint32_t b) { return std::abs(terms.A[a]) > std::abs(terms.A[b]); });
+
+                Terms sorted;
+                for (const auto i : order)
+                {
+                    sorted.A.push_back(terms.A[i]);
+                    sorted.B.push_back(terms.B[i]);
+                    sorted.C.push_back(terms.C[i]);
+                }
+
+                std::copy(sorted.A.begin(), sorted.A.end(), terms.A.begin() + s.first);
+                std::copy(sorted.B.begin(), sorted.B.end(), terms.B.begin() + s.first);
+                std::copy(sorted.C.begin(), sorted.C.end(), terms.C.begin() + s.first);
+            }
+        }
+
+        return true;
+    }
+
+    // 달 급수 표를 진폭 순으로 정렬해서 담기
+    // scale : 계수 단위 변환, amplitudeScale : 계수를 AU 로 바꾸는 값
+    template <typename T, size_t N, typename GET>
+    void loadMoon(MoonTerms& mt, const T (&table)[N], GET get, double scale, double amplitudeScale)
+    {
+        std::vector<const T*> order;
+        for (const auto& term : table)
+        {
+            if (get(term) != 0) order.push_back(&term);
+        }
+
+        std::stable_sort(order.begin(), order.end(), [&](const T* a, const T* b) { return std::abs(get(*a)) > std::abs(get(*b)); });
+
+        for (const auto term : order)
+        {
+            mt.D .push_back(term->D );
+            mt.M .push_back(term->M );
+            mt.Mp.push_back(term->Mp);
+            mt.F .push_back(term->F );
+            mt.coef     .push_back(get(*term) * scale);
+            mt.amplitude.push_back(std::abs(get(*term) * scale * amplitudeScale));
+        }
+    }
+
+    void load()
+    {
+        const auto& bodies = catalog::bodies();
+        bodyIndex.assign(bodies.size(), -1);
+
+        // 행성
+        for (const auto& [name, ext] : VSOP_FILES)
+        {
+            const int planetIndex = catalog::find(name);
+            if (planetIndex == -1) continue;
+
+            Body body;
+            const std::string path = args::get().vsop87 + ext;
+            if (!loadVSOP(path, body))
+            {
+                std::cout << "ephemeris : not found. path: " << path << std::endl;
+                continue;
+            }
+
+            bodyIndex.at(planetIndex) = static_cast<int>(vsop.size());
+            vsop.push_back(body);
+        }
+
+        // 달. 표는 코드에 들어있음
+        const int moon = catalog::find("Moon");
+        if (moon != -1)
+        {
+            // 경도, 위도는 radian 으로. 잘라낼 때는 달 거리만큼의 길이 (AU) 로 비교
+            loadMoon(moonLongitude, MOON_LR, [](const MoonLR& t) { return t.l; }, 1e-6 * DEG2RAD, MOON_MEAN_DISTANCE_AU);
+            loadMoon(moonLatitude,  MOON_B,  [](const MoonB&  t) { return t.b; }, 1e-6 * DEG2RAD, MOON_MEAN_DISTANCE_AU);
+
+            // 거리는 AU 로
+            loadMoon(moonDistance,  MOON_LR, [](const MoonLR& t) { return t.r; }, 1e-3 / AU_KM, 1);
+        }
+        moonIndex = moon;
+
+        ready.store(true, std::memory_order_release);
+        std::cout << "ephemeris : loaded. bodies: " << vsop.size() << ", terms: " << terms.A.size() << std::endl;
+    }
+
+    bool available(int planetIndex)
+    {
+        if (!ready.load(std::memory_order_acquire)) return false;
+
+        if (planetIndex == moonIndex && moonIndex != -1) return true;
+        return 0 <= planetIndex && static_cast<size_t>(planetIndex) < bodyIndex.size() && bodyIndex.at(planetIndex) != -1;
+    }
+
+    /**************************************************************************************************************/
+
+    // 달 위치. 지구 중심
+    glm::dvec3 getMoonPosition(double days, double threshold)
+    {
+        const double T = days / daysPerCentry;
+        const double T2 = T * T;
+        const double T3 = T2 * T;
+        const double T4 = T3 * T;
+
+        // 기본 인수 (degree)
+        const double Lp = 218.3164477 + 481267.88123421 * T - 0.0015786 * T2 + T3 / 538841 - T4 / 65194000;
+        const double D  = 297.8501921 + 445267.1114034  * T - 0.0018819 * T2 + T3 / 545868 - T4 / 113065000;
+        const double M  = 357.5291092 +  35999.0502909  * T - 0.0001536 * T2 + T3 / 24490000;
+        const double Mp = 134.9633964 + 477198.8675055  * T + 0.0087414 * T2 + T3 / 69699  - T4 / 14712000;
+        const double F  =  93.2720950 + 483202.0175233  * T - 0.0036539 * T2 - T3 / 3526000 + T4 / 863310000;
+
+        const double A1 = (119.75 +    131.849 * T) * DEG2RAD;
+        const double A2 = ( 53.09 + 479264.290 * T) * DEG2RAD;
+        const double A3 = (313.45 + 481266.484 * T) * DEG2RAD;
+
+        const double E = 1 - 0.002516 * T - 0.0000074 * T2;
+
+        const double arg[4] = {
+            std::fmod(D,  360) * DEG2RAD,
+            std::fmod(M,  360) * DEG2RAD,
+            std::fmod(Mp, 360) * DEG2RAD,
+            std::fmod(F,  360) * DEG2RAD,
+        };
+        const double LpRad = std::fmod(Lp, 360) * DEG2RAD;
+        const double MpRad = arg[2];
+        const double FRad  = arg[3];
+
+        double sumL = evaluate(moonLongitude, arg, E, false, threshold);
+        double sumB = evaluate(moonLatitude,  arg, E, false, threshold);
+        double sumR = evaluate(moonDistance,  arg, E, true,  threshold);
+
+        // 금성, 목성 섭동과 지구 편평도에 의한 항
+        constexpr double u = 1e-6 * DEG2RAD;
+        sumL += u * (3958 * std::sin(A1) + 1962 * std::sin(LpRad - FRad) + 318 * std::sin(A2));
+        sumB += u * (-2235 * std::sin(LpRad) + 382 * std::sin(A3) + 175 * std::sin(A1 - FRad) + 175 * std::sin(A1 + FRad)
+                     + 127 * std::sin(LpRad - MpRad) - 115 * std::sin(LpRad + MpRad));
+
+        // 당일 춘분점 기준 -> J2000 기준 (경도 방향 세차만 보정)
+        constexpr double PRECESSION = 1.3969713 * DEG2RAD; // 100 년당
+        const double lambda = LpRad + sumL - PRECESSION * T;
+        const double beta   = sumB;
+        const double delta  = MOON_MEAN_DISTANCE_AU + sumR;
+
+        return glm::dvec3(
+            delta * std::cos(beta) * std::cos(lambda),
+            delta * std::cos(beta) * std::sin(lambda),
+            delta * std::sin(beta)
+        );
+    }
+
+    bool getPosition(int planetIndex, double days, double threshold, glm::dvec3& position)
+    {
+        if (!available(planetIndex)) return false;
+
+        if (planetIndex == moonIndex)
+        {
+            position = getMoonPosition(days, threshold);
+            return true;
+        }
+
+        const auto& body = vsop.at(bodyIndex.at(planetIndex));
+
+        // VSOP87 은 J2000 기준 율리우스 천년
+        const double t = days / daysPerMillennium;
+
+        for (int v = 0; v < VSOP_VARIABLES; v++)
+        {
+            // Σ t^n * series_n
+            double value = 0;
+            double tn = 1;
+            for (int n = 0; n < VSOP_POWERS; n++)
+            {
+                if (body.series[v][n].count > 0)
+                {
+                    value += tn * evaluate(body.series[v][n], t, threshold);
+                }
+                tn *= t;
+            }
+
+            position[v] = value;
+        }
+
+        return true;
+    }
+
+    size_t countTerms(double threshold)
+    {
+        size_t count = 0;
+        if (!ready.load(std::memory_order_acquire)) return count;
+
+        for (const auto& body : vsop)
+        {
+            for (const auto& variable : body.series)
+            {
+                for (const auto& s : variable)
+                {
+                    count += truncate(s, threshold);
+                }
+            }
+        }
+
+        if (moonIndex != -1)
+        {
+            for (const auto* mt : { &moonLongitude, &moonLatitude, &moonDistance })
+            {
+                count += threshold <= 0
+                    ? mt->amplitude.size()
+                    : std::partition_point(mt->amplitude.begin(), mt->amplitude.end(), [threshold](double a) { return a >= threshold; }) - mt->amplitude.begin();
+            }
+        }
+
+        return count;
+    }
+
+    /**************************************************************************************************************/
+
+    void benchmark(std::ostream& os)
+    {
+        // 급수가 있는 천체
+        std::vector<int> targets;
+        for (size_t i = 0; i < catalog::bodies().size(); i++)
+        {
+            if (available(static_cast<int>(i))) targets.push_back(static_cast<int>(i));
+        }
+
+        if (targets.empty())
+        {
+            os << "ephemeris : no series loaded." << std::endl;
+            return;
+        }
+
+        // 1900 ~ 2100 년 사이를 고르게
+        std::vector<double> dates(EPHEMERIS_BENCH_SAMPLES);
+        for (size_t i = 0; i < dates.size(); i++)
+        {
+            dates[i] = -daysPerCentry + 2 * daysPerCentry * i / (dates.size() - 1);
+        }
+
+        // 기준값 : 전부 계산
+        std::vector<glm::dvec3> reference(dates.size() * targets.size());
+        for (size_t d = 0; d < dates.size(); d++)
+        {
+            for (size_t b = 0; b < targets.size(); b++)
+            {
+                getPosition(targets[b], dates[d], 0, reference[d * targets.size() + b]);
+            }
+        }
+
+        std::array<char, 256> buff;
+        std::snprintf(buff.data(), buff.size(), "%-10s %8s %12s %16s %16s", "threshold", "terms", "us/frame", "planet err (km)", "moon err (km)");
+        os << buff.data() << std::endl;
+
+        for (const double threshold : EPHEMERIS_BENCH_THRESHOLDS)
+        {
+            double errPlanet = 0;
+            double errMoon   = 0;
+
+            const auto start = std::chrono::steady_clock::now();
+
+            for (size_t d = 0; d < dates.size(); d++)
+            {
+                for (size_t b = 0; b < targets.size(); b++)
+                {
+                    glm::dvec3 pos;
+                    getPosition(targets[b], dates[d], threshold, pos);
+
+                    const double err = glm::length(pos - reference[d * targets.size() + b]) * AU_KM;
+                    if (targets[b] == moonIndex) errMoon   = std::max(errMoon,   err);
+                    else                         errPlanet = std::max(errPlanet, err);
+                }
+            }
+
+            const auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+            // 한 프레임 = 모든 천체 위치 한 번씩
+            std::snprintf(
+                buff.data(),
+                buff.size(),
+                "%-10.0e %8zu %12.2f %16.3f %16.3f",
+                threshold,
+                countTerms(threshold),
+                elapsed / dates.size(),
+                errPlanet,
+                errMoon
+            );
+            os << buff.data() << std::endl;
+        }
+    }
+}
@@ -0,0 +1,31 @@
+﻿// 급수 기반 고정밀 천체력
+// 행성은 VSOP87, 달은 ELP-2000/82 를 줄인 급수 (Meeus) 를 사용한다.
+
+#pragma once
+
+#include <ostream>
+
+#include <glm/glm.hpp>
+
+namespace ephemeris
+{
+    // 달까지의 평균 거리 (AU). 385000.56 km
+    constexpr double MOON_MEAN_DISTANCE_AU = 385000.56 / 149597870.7;
+
+    // 급수 파일 읽기. 파일이 없는 천체는 건너뛴다.
+    void load();
+
+    // 해당 천체의 급수가 있는지
+    bool available(int planetIndex);
+
+    // J2000 황도 기준 위치 (AU). 행성은 태양 중심, 달은 지구 중심.
+    // threshold : 진폭이 이 값 (AU) 보다 작은 항은 계산하지 않음. 0 이면 전부 계산
+    // 급수가 없으면 false
+    bool getPosition(int planetIndex, double days, double threshold, glm::dvec3& position);
+
+    // 계산에 쓰이는 항 수
+    size_t countTerms(double threshold);
+
+    // 잘라내는 정도에 따른 계산 시간과 오차 출력
+    void benchmark(std::ostream& os);
+}
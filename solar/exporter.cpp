@@ -0,0 +1,621 @@
+﻿#include "exporter.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "args.h"
+#include "camera.h"
+#include "config.h"
+#include "constants.h"
+#include "image.h"
+#include "platform.h"
+#include "render.h"
+#include "trace.h"
+#include "ui.h"
+
+#ifdef _WIN32
+#define popen  _popen
+#define pclose _pclose
+constexpr const char* PIPE_MODE = "wb";
+#else
+constexpr const char* PIPE_MODE = "w";
+#endif
+
+namespace exporter
+{
+    using clock = std::chrono::steady_clock;
+
+    enum class Format
+    {
+        PNG,
+        Y4M,
+    };
+
+    // 화면을 읽어둔 PBO
+    struct Slot
+    {
+        GLuint pbo   = 0;
+        GLsync fence = nullptr;
+        int    frame = -1; // -1 이면 비어있음
+    };
+
+    // 인코딩할 프레임
+    struct Job
+    {
+        int frame;
+        std::vector<uint8_t> pixels; // RGBA, 아래쪽 줄부터
+    };
+
+    bool running = false;
+
+    // 프레임마다 파일로 쓸 때의 경로. "frames/%05d.png" -> "frames/" + 5 자리 번호 + ".png"
+    struct FramePattern
+    {
+        std::string prefix;
+        std::string suffix;
+        int         width = 0; // 이보다 짧으면 앞을 0 으로 채움
+    };
+
+    Format       format;
+    std::string  path;
+    bool         perFrameFile = false; // 경로에 %d 가 있으면 프레임마다 파일
+    FramePattern framePattern;
+    FILE*        stream = nullptr;     // 하나로 이어서 쓸 때
+
+    int    first;  // 첫 프레임 번호. 나눠서 렌더링하면 전체 기준
+    int    frames; // 이 프로세스가 그릴 프레임 수
+    double start;
+    double step;
+
+    v::Size2i size;
+    size_t    frameBytes;
+
+    int frame = 0;
+    bool inFrame = false;
+
+    std::array<Slot, EXPORT_PBO_COUNT> slots;
+
+    // 작업 스레드
+    std::vector<std::thread> workers;
+
+    std::mutex              jobLock;
+    std::condition_variable jobAdded;   // 일거리가 생겼거나 종료
+    std::condition_variable jobRemoved; // 대기열에 자리가 생김
+    std::deque<Job>         jobs;
+    bool                    stopping = false;
+
+    std::vector<std::vector<uint8_t>> pixelPool; // 다 쓴 버퍼 재사용. jobLock
+
+    // 스트림은 프레임 순서대로 써야 해서 먼저 끝난 건 모아둠
+    std::mutex                               writeLock;
+    std::map<int, std::vector<uint8_t>>      encoded;
+    int                                      nextWrite = 0;
+    bool                                     writeFailed = false;
+
+    clock::time_point startClock;
+
+    /**************************************************************************************************************/
+
+    bool endsWith(const std::string& str, const std::string& suffix)
+    {
+        return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    // 경로에서 %d, %0Nd (N 은 1 ~ 9) 하나를 찾아서 앞뒤로 나눔. %% 는 % 글자.
+    // 사용자가 준 경로를 printf 형식 문자열로 쓰지 않도록 직접 읽는다.
+    // 번호 자리가 없으면 false, 형식이 틀렸거나 두 개 이상이면 예외
+    bool parseFramePattern(const std::string& output, FramePattern& pattern)
+    {
+        pattern = FramePattern{};
+
+        bool found = false;
+        for (size_t i = 0; i < output.size(); i++)
+        {
+            auto& part = found ? pattern.suffix : pattern.prefix;
+
+            if (output[i] != '%')
+            {
+                part.push_back(output[i]);
+                continue;
+            }
+
+            size_t j = i + 1;
+            if (j < output.size() && output[j] == '%')
+            {
+                part.push_back('%');
+                i = j;
+                continue;
+            }
+
+            int width = 0;
+            if (j + 1 < output.size() && output[j] == '0' && '1' <= output[j + 1] && output[j + 1] <= '9')
+            {
+                width = output[j + 1] - '0';
+                j += 2;
+            }
+
+            if (found || j >= output.size() || output[j] != 'd')
+            {
+                throw std::runtime_error("Invalid export path. use one %d or %0Nd for the frame number. path: " + output);
+            }
+
+            found = true;
+            pattern.width = width;
+            i = j;
+        }
+
+        return found;
+    }
+
+    // 프레임 번호를 넣은 파일 이름
+    std::string frameFileName(const FramePattern& pattern, int frame)
+    {
+        auto number = std::to_string(frame);
+        if (static_cast<int>(number.size()) < pattern.width)
+        {
+            number.insert(0, pattern.width - number.size(), '0');
+        }
+
+        return pattern.prefix + number + pattern.suffix;
+    }
+
+    // 작업 스레드에서 프레임 순서대로 스트림에 쓰기
+    void writeOrdered(int f, std::vector<uint8_t>&& data)
+    {
+        std::lock_guard __lock(writeLock);
+
+        encoded.emplace(f, std::move(data));
+
+        while (!encoded.empty() && encoded.begin()->first == nextWrite)
+        {
+            const auto& bytes = encoded.begin()->second;
+            if (!writeFailed && std::fwrite(bytes.data(), 1, bytes.size(), stream) != bytes.size())
+            {
+                std::cout << "exporter : failed to write frame " << nextWrite << std::endl;
+                writeFailed = true;
+            }
+
+            encoded.erase(encoded.begin());
+            nextWrite++;
+        }
+    }
+
+    void encode(Job& job, std::vector<uint8_t>& out)
+    {
+        TRACE_SCOPE("exporter::encode");
+
+        switch (format)
+        {
+        case Format::PNG: image::encodePNG(job.pixels.data(), size, out); break;
+        case Format::Y4M: image::encodeY4M(job.pixels.data(), size, out); break;
+        }
+
+        if (!perFrameFile)
+        {
+            writeOrdered(job.frame, std::move(out));
+            out = std::vector<uint8_t>();
+            return;
+        }
+
+        const auto filename = frameFileName(framePattern, first + job.frame);
+
+        FILE* fp = std::fopen(filename.c_str(), "wb");
+        if (fp == nullptr || std::fwrite(out.data(), 1, out.size(), fp) != out.size())
+        {
+            std::cout << "exporter : failed to write. path: " << filename << std::endl;
+        }
+        if (fp != nullptr) std::fclose(fp);
+    }
+
+    void workerThread()
+    {
+        trace::setThreadName("exporter");
+
+        std::vector<uint8_t> out;
+
+        while (true)
+        {
+            Job job;
+            {
+                std::unique_lock __lock(jobLock);
+                jobAdded.wait(__lock, []() { return stopping || !jobs.empty(); });
+
+                if (jobs.empty()) return;
+
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            jobRemoved.notify_one();
+
+            encode(job, out);
+
+            std::lock_guard __lock(jobLock);
+            pixelPool.push_back(std::move(job.pixels));
+        }
+    }
+
+    /**************************************************************************************************************/
+
+    Format parseFormat(const args::Options& opt)
+    {
+        if (opt.exportFormat == "png") return Format::PNG;
+        if (opt.exportFormat == "y4m") return Format::Y4M;
+        if (opt.exportFormat.empty())  return endsWith(opt.exportPath, ".y4m") ? Format::Y4M : Format::PNG;
+
+        throw std::runtime_error("Unknown export format: " + opt.exportFormat);
+    }
+
+    // "|명령어" 면 파이프, 아니면 파일
+    // std::system, popen 에 넘길 명령어
+    // Windows 는 cmd.exe /c 로 실행하는데, 큰따옴표가 두 쌍 이상이면 처음과 마지막 큰따옴표를 지워버리므로 전체를 한번 더 감쌈
+    std::string shellCommand(const std::string& cmd)
+    {
+#ifdef _WIN32
+        return "\"" + cmd + "\"";
+#else
+        return cmd;
+#endif
+    }
+
+    FILE* openOutput(const std::string& output)
+    {
+        FILE* fp = output.front() == '|' ? popen(shellCommand(output.substr(1)).c_str(), PIPE_MODE) : std::fopen(output.c_str(), "wb");
+        if (fp == nullptr)
+        {
+            throw std::runtime_error("Failed to open export output: " + output);
+        }
+        return fp;
+    }
+
+    void closeOutput(const std::string& output, FILE* fp)
+    {
+        if (output.front() == '|') pclose(fp);
+        else                       std::fclose(fp);
+    }
+
+    // 경로에 %d 가 있는 PNG 면 프레임마다 파일
+    bool isPerFrameFile(const std::string& output, Format fmt, FramePattern& pattern)
+    {
+        return output.front() != '|' && fmt == Format::PNG && parseFramePattern(output, pattern);
+    }
+
+    void init()
+    {
+        const auto& opt = args::get();
+        if (opt.exportPath.empty()) return;
+
+        path   = opt.exportPath;
+        format = parseFormat(opt);
+        start  = opt.exportStart;
+        step   = opt.exportStep;
+
+        // 전체 범위 중 이 조각이 맡은 부분
+        const int total = opt.exportFrames;
+        first  = opt.exportFirst + total *  opt.shardIndex      / opt.shardCount;
+        frames = opt.exportFirst + total * (opt.shardIndex + 1) / opt.shardCount - first;
+
+        // 내보내는 동안 창 크기는 바꾸지 않는다고 가정
+        const auto screen = camera::get().screen;
+        size = v::Size2i(static_cast<int>(screen.w), static_cast<int>(screen.h));
+        frameBytes = static_cast<size_t>(size.w) * size.h * 4;
+
+        /**************************************************************************************************************/
+        // 출력
+
+        perFrameFile = isPerFrameFile(path, format, framePattern);
+
+        if (!perFrameFile)
+        {
+            stream = openOutput(path);
+
+            if (format == Format::Y4M)
+            {
+                const auto header = image::headerY4M(size, opt.exportFps);
+                std::fwrite(header.data(), 1, header.size(), stream);
+            }
+        }
+
+        /**************************************************************************************************************/
+        // PBO
+
+        for (auto& slot : slots)
+        {
+            glGenBuffers(1, &slot.pbo);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+            glBufferData(GL_PIXEL_PACK_BUFFER, frameBytes, nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        // 인코딩 스레드. 렌더링 스레드 하나는 남겨두고, 여러 프로세스로 나눴으면 코어를 나눠 씀
+        const int cores = static_cast<int>(std::thread::hardware_concurrency()) / opt.shardCount;
+        const int workerCount = std::clamp(cores - 1, 1, EXPORT_WORKERS_MAX);
+        for (int i = 0; i < workerCount; i++)
+        {
+            workers.emplace_back(workerThread);
+        }
+
+        running = true;
+
+        std::cout << "exporter : " << path << ". " << size.w << "x" << size.h << ", frames: " << first << " ~ " << first + frames - 1 << ", workers: " << workerCount << std::endl;
+    }
+
+    bool active() noexcept
+    {
+        return running;
+    }
+
+    bool finished() noexcept
+    {
+        return running && frame >= frames;
+    }
+
+    /**************************************************************************************************************/
+
+    // PBO 에 읽어둔 프레임을 꺼내서 대기열에 넣음
+    void collect(Slot& slot)
+    {
+        if (slot.frame == -1) return;
+
+        TRACE_SCOPE("exporter::collect");
+
+        // 몇 프레임 전에 읽기 시작한 것이라 대부분 바로 끝남
+        while (glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, EXPORT_SYNC_TIMEOUT) == GL_TIMEOUT_EXPIRED)
+        {
+        }
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+
+        Job job{ slot.frame, {} };
+        slot.frame = -1;
+
+        // 인코딩이 밀려 있으면 기다림
+        {
+            std::unique_lock __lock(jobLock);
+            jobRemoved.wait(__lock, []() { return jobs.size() < EXPORT_QUEUE_FRAMES; });
+
+            if (!pixelPool.empty())
+            {
+                job.pixels = std::move(pixelPool.back());
+                pixelPool.pop_back();
+            }
+        }
+        job.pixels.resize(frameBytes);
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        const auto mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameBytes, GL_MAP_READ_BIT);
+        if (mapped != nullptr)
+        {
+            std::copy_n(static_cast<const uint8_t*>(mapped), frameBytes, job.pixels.data());
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        {
+            std::lock_guard __lock(jobLock);
+            jobs.push_back(std::move(job));
+        }
+        jobAdded.notify_one();
+    }
+
+    void beginFrame()
+    {
+        if (!running || finished() || !render::loaded()) return;
+
+        if (frame == 0)
+        {
+            // 화면에 시간에 따라 바뀌는 글자가 없도록. 날자는 남겨둠
+            auto cfg = config::get();
+            cfg.playAnimation = true;
+            cfg.showFPS       = false;
+            cfg.showSpeed     = false;
+            cfg.showHelp      = false;
+            cfg.vsync         = false;
+            config::update(cfg);
+
+            ui::close();
+
+            startClock = clock::now();
+        }
+
+        render::setDate(start + step * (first + frame));
+        inFrame = true;
+    }
+
+    void endFrame()
+    {
+        if (!inFrame) return;
+        inFrame = false;
+
+        TRACE_SCOPE("exporter::readback");
+
+        auto& slot = slots.at(frame % slots.size());
+        collect(slot);
+
+        // 비동기로 읽기. 결과는 이 슬롯을 다시 쓸 때 꺼냄
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, platform::framebuffer());
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        glReadPixels(0, 0, size.w, size.h, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        slot.frame = frame;
+
+        frame++;
+    }
+
+    void finish()
+    {
+        if (!running) return;
+        running = false;
+
+        // 남은 PBO 는 프레임 순서대로
+        for (int i = 0; i < static_cast<int>(slots.size()); i++)
+        {
+            collect(slots.at((frame + i) % slots.size()));
+        }
+
+        {
+            std::lock_guard __lock(jobLock);
+            stopping = true;
+        }
+        jobAdded.notify_all();
+
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+        workers.clear();
+
+        for (auto& slot : slots)
+        {
+            glDeleteBuffers(1, &slot.pbo);
+        }
+
+        if (stream != nullptr)
+        {
+            closeOutput(path, stream);
+            stream = nullptr;
+        }
+
+        const double seconds = std::chrono::duration<double>(clock::now() - startClock).count();
+        std::cout << "exporter : done. frames: " << frame << ", " << seconds << " s (" << (seconds > 0 ? frame / seconds : 0) << " fps)" << std::endl;
+    }
+
+    /**************************************************************************************************************/
+    // 여러 프로세스로 나눠 내보내기
+
+    // 명령줄 인자 하나를 큰따옴표로 감쌈
+    std::string quoteArg(const std::string& arg)
+    {
+        std::string out = "\"";
+        for (const char c : arg)
+        {
+#ifdef _WIN32
+            if (c == '"') out += '\\';
+#else
+            if (c == '"' || c == '\\' || c == '$' || c == '`') out += '\\';
+#endif
+            out += c;
+        }
+        out += '"';
+        return out;
+    }
+
+    int coordinate()
+    {
+        const auto& opt = args::get();
+        const int count = opt.exportProcesses;
+        const auto fmt = parseFormat(opt);
+        FramePattern pattern;
+        const bool perFrame = isPerFrameFile(opt.exportPath, fmt, pattern);
+
+        // 자식 프로세스 공통 인자. 출력과 조각 관련 인자는 따로 붙임
+        std::string common = quoteArg(opt.program);
+        for (const auto& arg : opt.rawArgs)
+        {
+            if (arg.rfind("--export=",           0) == 0 ||
+                arg.rfind("--export-format=",    0) == 0 ||
+                arg.rfind("--export-processes=", 0) == 0 ||
+                arg.rfind("--shard=",            0) == 0 ||
+                arg.rfind("--trace=",            0) == 0)
+            {
+                continue;
+            }
+            common += " " + quoteArg(arg);
+        }
+        if (opt.backend == "window") common += " --headless";
+        common += std::string(" --export-format=") + (fmt == Format::Y4M ? "y4m" : "png");
+
+        // 프레임마다 파일이면 번호가 겹치지 않으니 그대로 쓰고, 아니면 조각마다 임시 파일에 쓴 뒤 합침
+        const std::string partBase = opt.exportPath.front() == '|' ? EXPORT_SHARD_TEMP_PATH : opt.exportPath;
+
+        std::vector<std::string> parts;
+        std::vector<std::thread> processes;
+        std::vector<int> results(count);
+
+        const auto startClock = clock::now();
+
+        for (int i = 0; i < count; i++)
+        {
+            parts.push_back(perFrame ? opt.exportPath : partBase + ".part" + std::to_string(i));
+
+            const std::string cmd = common
+                + " " + quoteArg("--export=" + parts.back())
+                + " --shard=" + std::to_string(i) + "/" + std::to_string(count);
+
+            std::cout << "exporter : shard " << i << ". " << cmd << std::endl;
+            processes.emplace_back([cmd, i, &results]() { results.at(i) = std::system(shellCommand(cmd).c_str()); });
+        }
+
+        for (auto& process : processes)
+        {
+            process.join();
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            if (results.at(i) != 0)
+            {
+                std::cout << "exporter : shard " << i << " failed. code: " << results.at(i) << std::endl;
+
+                // 합치지 않을 임시 조각은 지움. 프레임마다 파일이면 이미 쓴 프레임은 남겨둠
+                if (!perFrame)
+                {
+                    for (const auto& part : parts)
+                    {
+                        std::remove(part.c_str());
+                    }
+                }
+                return 1;
+            }
+        }
+
+        // 순서대로 이어붙임. Y4M 헤더는 첫 조각 것만 씀
+        if (!perFrame)
+        {
+            FILE* out = openOutput(opt.exportPath);
+            std::vector<char> buff(EXPORT_CONCAT_BUFFER);
+
+            for (int i = 0; i < count; i++)
+            {
+                std::ifstream fs(parts.at(i), std::ios::binary);
+
+                if (fmt == Format::Y4M && i > 0)
+                {
+                    std::string header;
+                    std::getline(fs, header);
+                }
+
+                while (fs)
+                {
+                    fs.read(buff.data(), buff.size());
+                    std::fwrite(buff.data(), 1, static_cast<size_t>(fs.gcount()), out);
+                }
+
+                fs.close();
+                std::remove(parts.at(i).c_str());
+            }
+
+            closeOutput(opt.exportPath, out);
+        }
+
+        const double seconds = std::chrono::duration<double>(clock::now() - startClock).count();
+        std::cout << "exporter : done. processes: " << count << ", frames: " << opt.exportFrames << ", " << seconds << " s (" << opt.exportFrames / seconds << " fps)" << std::endl;
+
+        return 0;
+    }
+}
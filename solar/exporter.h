@@ -0,0 +1,34 @@
+﻿// 이미지 시퀀스 / 동영상 내보내기
+// 프레임마다 정해진 일 수만큼 날자를 진행시키며 렌더링하고, PBO 를 몇 개 돌려쓰면서 GPU 를 멈추지 않고 화면을 읽는다.
+// 읽은 화면은 작업 스레드에서 PNG 혹은 Y4M 으로 인코딩해서 파일이나 파이프로 보낸다.
+//
+//   --export=frames/%05d.png          프레임마다 PNG 파일
+//   --export=out.y4m                  Y4M 파일 하나
+//   "--export=|ffmpeg -i - out.mp4"   명령어로 파이프 (--export-format 으로 형식 지정)
+//
+// 프레임은 날자와 카메라만으로 정해지므로 --export-first, --shard 로 범위를 나눠 여러 프로세스에서 따로 그릴 수 있다.
+
+#pragma once
+
+namespace exporter
+{
+    // 명령줄 인자로 내보내기 준비. 출력을 열지 못하면 예외 발생.
+    void init();
+
+    // 내보내는 중인지
+    bool active() noexcept;
+
+    // 모든 프레임을 다 읽었는지
+    bool finished() noexcept;
+
+    // 렌더링 직전, 직후 (화면 갱신 전) 에 호출. 로딩이 끝나기 전에는 아무것도 안 함
+    void beginFrame();
+    void endFrame();
+
+    // 남은 프레임을 기다려서 다 쓰고 출력을 닫음. GL 컨텍스트가 있어야 함
+    void finish();
+
+    // --export-processes=N : 자기 자신을 창 없이 N 개 띄워서 --shard=i/N 으로 범위를 나눠 그리게 하고
+    // 끝나면 결과를 순서대로 합친다. GL 초기화 없이 호출. 반환값은 종료 코드
+    int coordinate();
+}
@@ -2,19 +2,24 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cmath>
 #include <filesystem>
 #include <fstream>
 #include <future>
 #include <iostream>
+#include <iterator>
 #include <ostream>
 #include <queue>
 #include <sstream>
+#include <stdexcept>
 #include <vector>
 
+#ifdef _WIN32
 #include <Windows.h>
 #include <ole2.h>
 #include <gdiplus.h>
+#endif
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -22,6 +27,8 @@
 #include <glm/glm.hpp>
 
 #include "defer.h"
+#include "image.h"
+#include "trace.h"
 #include "utils.h"
 
 namespace glext
@@ -39,6 +46,8 @@ namespace glext
 
     void dispatchInvoke()
     {
+        TRACE_SCOPE("dispatchInvoke");
+
         std::lock_guard __lock(taskLock);
 
         while (taskQueue.size() > 0)
@@ -60,14 +69,38 @@ namespace glext
             taskQueue.push(std::packaged_task<void()>(std::move(task)));
         }
 
-        // 대기하고
-        fut.wait();
+        // 대기하고. 메인 스레드에서 던진 예외는 여기서 다시 던짐
+        fut.get();
     }
 
-    unsigned int loadTexture(const std::string& textureName)
+    // 로딩 스레드에서도 올리기 때문에 atomic
+    std::atomic_uint64_t drawCalls     = 0;
+    std::atomic_uint64_t bytesUploaded = 0;
+
+    void countDraw(uint64_t calls)
     {
-        std::cout << "loadTexture textureName: " << textureName << std::endl;
+        drawCalls += calls;
+    }
 
+    void countUpload(uint64_t bytes)
+    {
+        bytesUploaded += bytes;
+    }
+
+    Counters counters()
+    {
+        return Counters{ drawCalls.load(), bytesUploaded.load() };
+    }
+
+    void resetCounters()
+    {
+        drawCalls = 0;
+        bytesUploaded = 0;
+    }
+
+#ifdef _WIN32
+    void readImage(const std::string& textureName, const std::function<void(const uint8_t* bgra, v::Size2i size, int stride)>& func)
+    {
         auto path = getTexturePath(textureName);
         const auto wpath = utils::str2wcs(path); // wstring 으로 변경
 
@@ -127,29 +160,86 @@ namespace glext
         }
         defer(bitmap->UnlockBits(const_cast<Gdiplus::BitmapData*>(&bitmapData))); // LockBits 후 객체 해제하는 과정
 
+        func(
+            static_cast<const uint8_t*>(bitmapData.Scan0),
+            v::Size2i(static_cast<int>(bitmapData.Width), static_cast<int>(bitmapData.Height)),
+            bitmapData.Stride
+        );
+    }
+#else
+    void readImage(const std::string& textureName, const std::function<void(const uint8_t* bgra, v::Size2i size, int stride)>& func)
+    {
+        const auto path = getTexturePath(textureName);
+
+        // GDI+ 가 없으니 PNG 만 읽음 (image.h)
+        std::ifstream fs(path, std::ios::binary);
+        if (!fs.is_open())
+        {
+            throw std::runtime_error("Failed to load bitmap. path: " + path);
+        }
+
+        const std::vector<uint8_t> data((std::istreambuf_iterator<char>(fs)), std::istreambuf_iterator<char>());
+
+        std::vector<uint8_t> rgba;
+        v::Size2i size;
+        if (!image::decodePNG(data, rgba, size))
+        {
+            throw std::invalid_argument("Failed to decode bitmap. path: " + path);
+        }
+
+        // GDI+ 와 같게 위쪽 줄부터, BGRA 로
+        const size_t stride = static_cast<size_t>(size.w) * 4;
+        std::vector<uint8_t> bgra(rgba.size());
+        for (int y = 0; y < size.h; y++)
+        {
+            const uint8_t* src = &rgba[stride * (size.h - 1 - y)];
+            uint8_t*       dst = &bgra[stride * y];
+            for (int x = 0; x < size.w; x++)
+            {
+                dst[x * 4 + 0] = src[x * 4 + 2];
+                dst[x * 4 + 1] = src[x * 4 + 1];
+                dst[x * 4 + 2] = src[x * 4 + 0];
+                dst[x * 4 + 3] = src[x * 4 + 3];
+            }
+        }
+
+        func(bgra.data(), size, static_cast<int>(stride));
+    }
+#endif
+
+    unsigned int loadTexture(const std::string& textureName)
+    {
+        std::cout << "loadTexture textureName: " << textureName << std::endl;
+
         // 텍스쳐 생성하기.
         unsigned int textureId;
-        dispatch([&]() {
-            glGenTextures(1, &textureId);
-            
-            glBindTexture(GL_TEXTURE_2D, textureId); // 텍스쳐 바인딩
-            defer(glBindTexture(GL_TEXTURE_2D, 0));
-
-            // 텍스쳐 설정
-            glTexImage2D(
-                GL_TEXTURE_2D,
-                0, // 자동
-                GL_RGBA,
-                bitmap->GetWidth(),
-                bitmap->GetHeight(),
-                0, // 여백
-                GL_BGRA,
-                GL_UNSIGNED_BYTE,
-                bitmapData.Scan0
-            );
-
-            // Mipmap 생성
-            glGenerateMipmap(GL_TEXTURE_2D);
+        readImage(textureName, [&](const uint8_t* bgra, v::Size2i size, int stride) {
+            dispatch([&]() {
+                glGenTextures(1, &textureId);
+
+                glBindTexture(GL_TEXTURE_2D, textureId); // 텍스쳐 바인딩
+                defer(glBindTexture(GL_TEXTURE_2D, 0));
+
+                glPixelStorei(GL_UNPACK_ROW_LENGTH, stride / 4);
+                defer(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+
+                // 텍스쳐 설정
+                glTexImage2D(
+                    GL_TEXTURE_2D,
+                    0, // 자동
+                    GL_RGBA,
+                    size.w,
+                    size.h,
+                    0, // 여백
+                    GL_BGRA,
+                    GL_UNSIGNED_BYTE,
+                    bgra
+                );
+                countUpload(static_cast<uint64_t>(size.w) * size.h * 4);
+
+                // Mipmap 생성
+                glGenerateMipmap(GL_TEXTURE_2D);
+            });
         });
 
         return textureId;
@@ -175,6 +265,9 @@ namespace glext
         // 파일 읽기
         str.assign((std::istreambuf_iterator<char>(fs)), std::istreambuf_iterator<char>());
 
+        // UTF-8 BOM 이 있으면 Mesa 의 GLSL 컴파일러는 첫 줄 #version 을 읽지 못함
+        if (str.compare(0, 3, "\xEF\xBB\xBF") == 0) str.erase(0, 3);
+
         return str;
     };
 
@@ -212,7 +305,7 @@ namespace glext
         return shader;
     }
 
-    unsigned int glext::loadShader(const std::string& shaderName)
+    unsigned int loadShader(const std::string& shaderName)
     {
         std::cout << "shader load. shaderName: " << shaderName << std::endl;
 
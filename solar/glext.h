@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <functional>
 
 #include <glad/glad.h>
@@ -29,10 +30,28 @@ namespace glext
     5. C# 의 Invoke 및 Dispatcher 에서 영감을 받아
     5. openGL 메인 스레드에서 실행해야 하는 부분들을 특정 큐에 집어넣어
     6. 이를 메인 스레드에서 실행하게 하여 이러한 문제를 해결해보고자 하였음.
+
+    func 에서 던진 예외는 dispatch 를 부른 스레드로 다시 던진다.
     */
     void dispatch(std::function<void()> const& func);
 
+    // 그리기 호출, 업로드 크기 집계. 벤치마크에서 프레임마다 초기화해서 사용함
+    struct Counters
+    {
+        uint64_t drawCalls;     // glDraw* 호출 수
+        uint64_t bytesUploaded; // 버퍼, 텍스쳐로 올린 크기
+    };
+
+    void countDraw(uint64_t calls = 1);
+    void countUpload(uint64_t bytes);
+
+    Counters counters();
+    void resetCounters();
+
     GLuint loadTexture(const std::string& textureName); // 텍스쳐 가져오는 함수
     GLuint loadShader (const std::string& shaderName); // 셰이더 컴파일해서 가져오는 함수
+
+    // 텍스쳐 이미지만 읽기. func 안에서만 유효한 BGRA 픽셀 (위쪽 줄부터) 을 넘겨줌
+    void readImage(const std::string& textureName, const std::function<void(const uint8_t* bgra, v::Size2i size, int stride)>& func);
 }
 
@@ -0,0 +1,571 @@
+﻿#include "image.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+
+namespace image
+{
+    constexpr std::array<uint8_t, 8> PNG_SIGNATURE = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+    constexpr size_t DEFLATE_STORED_MAX = 65535; // 압축하지 않은 deflate 블록 하나의 최대 크기
+
+    std::array<uint32_t, 256> makeCRCTable()
+    {
+        std::array<uint32_t, 256> table{};
+        for (uint32_t i = 0; i < table.size(); i++)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++)
+            {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        return table;
+    }
+
+    const std::array<uint32_t, 256> crcTable = makeCRCTable();
+
+    uint32_t crc32(uint32_t crc, const uint8_t* data, size_t len)
+    {
+        crc = ~crc;
+        for (size_t i = 0; i < len; i++)
+        {
+            crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    uint32_t adler32(const uint8_t* data, size_t len)
+    {
+        uint32_t a = 1, b = 0;
+        for (size_t i = 0; i < len; i++)
+        {
+            a = (a + data[i]) % 65521;
+            b = (b + a) % 65521;
+        }
+        return (b << 16) | a;
+    }
+
+    inline void pushBE32(std::vector<uint8_t>& out, uint32_t value)
+    {
+        out.push_back(static_cast<uint8_t>(value >> 24));
+        out.push_back(static_cast<uint8_t>(value >> 16));
+        out.push_back(static_cast<uint8_t>(value >>  8));
+        out.push_back(static_cast<uint8_t>(value      ));
+    }
+
+    // 길이, 타입, 데이터, CRC
+    void pushChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data)
+    {
+        pushBE32(out, static_cast<uint32_t>(data.size()));
+
+        const auto typeOffset = out.size();
+        out.insert(out.end(), type, type + 4);
+        out.insert(out.end(), data.begin(), data.end());
+
+        pushBE32(out, crc32(0, out.data() + typeOffset, out.size() - typeOffset));
+    }
+
+    void encodePNG(const uint8_t* rgba, v::Size2i size, std::vector<uint8_t>& out)
+    {
+        out.clear();
+        out.insert(out.end(), PNG_SIGNATURE.begin(), PNG_SIGNATURE.end());
+
+        // IHDR. 8bit RGB, 압축 0, 필터 0, 인터레이스 없음
+        std::vector<uint8_t> header;
+        pushBE32(header, size.w);
+        pushBE32(header, size.h);
+        header.insert(header.end(), { 8, 2, 0, 0, 0 });
+        pushChunk(out, "IHDR", header);
+
+        // 줄마다 필터 바이트 (0) + RGB. 위쪽 줄부터
+        const size_t stride = static_cast<size_t>(size.w) * 3 + 1;
+
+        std::vector<uint8_t> raw(stride * size.h);
+        for (int y = 0; y < size.h; y++)
+        {
+            const uint8_t* src = rgba + static_cast<size_t>(size.h - 1 - y) * size.w * 4;
+            uint8_t* dst = raw.data() + stride * y;
+
+            *dst++ = 0;
+            for (int x = 0; x < size.w; x++, src += 4)
+            {
+                *dst++ = src[0];
+                *dst++ = src[1];
+                *dst++ = src[2];
+            }
+        }
+
+        // zlib 스트림. 압축하지 않은 블록을 이어붙임
+        std::vector<uint8_t> zlib;
+        zlib.reserve(raw.size() + raw.size() / DEFLATE_STORED_MAX * 5 + 16);
+        zlib.push_back(0x78);
+        zlib.push_back(0x01);
+
+        size_t offset = 0;
+        do
+        {
+            const auto len = std::min(DEFLATE_STORED_MAX, raw.size() - offset);
+            const bool last = offset + len == raw.size();
+
+            zlib.push_back(last ? 1 : 0);
+            zlib.push_back(static_cast<uint8_t>( len       & 0xFF));
+            zlib.push_back(static_cast<uint8_t>((len >> 8) & 0xFF));
+            zlib.push_back(static_cast<uint8_t>(~len       & 0xFF));
+            zlib.push_back(static_cast<uint8_t>((~len >> 8) & 0xFF));
+            zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + len);
+
+            offset += len;
+        } while (offset < raw.size());
+
+        pushBE32(zlib, adler32(raw.data(), raw.size()));
+
+        pushChunk(out, "IDAT", zlib);
+        pushChunk(out, "IEND", {});
+    }
+
+    /**************************************************************************************************************/
+    // inflate (RFC 1951). 다른 도구로 다시 저장한 이미지도 읽을 수 있도록 압축된 블록도 지원
+
+    class BitReader
+    {
+    private:
+        const uint8_t* data;
+        size_t size;
+        size_t pos = 0;
+        uint32_t buff = 0;
+        int count = 0;
+
+    public:
+        bool overflow = false;
+
+        BitReader(const uint8_t* data, size_t size) : data(data), size(size) { }
+
+        int bits(int n)
+        {
+            while (this->count < n)
+            {
+                if (this->pos >= this->size)
+                {
+                    this->overflow = true;
+                    return 0;
+                }
+                this->buff |= static_cast<uint32_t>(this->data[this->pos++]) << this->count;
+                this->count += 8;
+            }
+
+            const int value = static_cast<int>(this->buff & ((1u << n) - 1));
+            this->buff >>= n;
+            this->count -= n;
+            return value;
+        }
+
+        // 남은 비트를 버리고 바이트 단위로 읽기
+        void align()
+        {
+            this->buff = 0;
+            this->count = 0;
+        }
+
+        bool readBytes(std::vector<uint8_t>& out, size_t len)
+        {
+            if (this->pos + len > this->size) return false;
+            out.insert(out.end(), this->data + this->pos, this->data + this->pos + len);
+            this->pos += len;
+            return true;
+        }
+    };
+
+    // 정규 허프만 코드. 길이별 코드 수와 길이순 심볼
+    struct Huffman
+    {
+        std::array<uint16_t, 16> counts{};
+        std::vector<uint16_t> symbols;
+
+        void build(const uint8_t* lengths, int n)
+        {
+            this->counts.fill(0);
+            for (int i = 0; i < n; i++) this->counts[lengths[i]]++;
+            this->counts[0] = 0;
+
+            std::array<uint16_t, 16> offsets{};
+            for (int len = 1; len < 15; len++) offsets[len + 1] = offsets[len] + this->counts[len];
+
+            this->symbols.assign(n, 0);
+            for (int i = 0; i < n; i++)
+            {
+                if (lengths[i] != 0) this->symbols[offsets[lengths[i]]++] = static_cast<uint16_t>(i);
+            }
+        }
+
+        int decode(BitReader& br) const
+        {
+            int code = 0, first = 0, index = 0;
+            for (int len = 1; len < 16; len++)
+            {
+                code |= br.bits(1);
+                const int count = this->counts[len];
+                if (code - count < first) return this->symbols[index + (code - first)];
+
+                index += count;
+                first = (first + count) << 1;
+                code <<= 1;
+            }
+            return -1;
+        }
+    };
+
+    constexpr std::array<uint16_t, 29> LENGTH_BASE  = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    constexpr std::array<uint8_t,  29> LENGTH_EXTRA = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    constexpr std::array<uint16_t, 30> DIST_BASE    = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    constexpr std::array<uint8_t,  30> DIST_EXTRA   = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+    constexpr std::array<uint8_t, 19> CODE_LENGTH_ORDER = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+    bool inflateBlock(BitReader& br, const Huffman& lit, const Huffman& dist, std::vector<uint8_t>& out)
+    {
+        while (!br.overflow)
+        {
+            const int sym = lit.decode(br);
+            if (sym < 0) return false;
+            if (sym < 256)
+            {
+                out.push_back(static_cast<uint8_t>(sym));
+                continue;
+            }
+            if (sym == 256) return true;
+
+            const int li = sym - 257;
+            if (li >= static_cast<int>(LENGTH_BASE.size())) return false;
+            const int len = LENGTH_BASE[li] + br.bits(LENGTH_EXTRA[li]);
+
+            const int di = dist.decode(br);
+            if (di < 0 || di >= static_cast<int>(DIST_BASE.size())) return false;
+            const size_t d = DIST_BASE[di] + br.bits(DIST_EXTRA[di]);
+            if (d > out.size()) return false;
+
+            // 겹칠 수 있으니 한 바이트씩
+            for (int i = 0; i < len; i++) out.push_back(out[out.size() - d]);
+        }
+        return false;
+    }
+
+    bool inflate(const uint8_t* data, size_t size, std::vector<uint8_t>& out)
+    {
+        // zlib 헤더 (CMF, FLG). 사전 (FDICT) 은 지원하지 않음
+        if (size < 2 || (data[0] & 0x0F) != 8 || ((data[0] << 8) | data[1]) % 31 != 0 || (data[1] & 0x20) != 0) return false;
+
+        BitReader br(data + 2, size - 2);
+
+        Huffman lit, dist;
+        std::array<uint8_t, 320> lengths{};
+
+        bool last = false;
+        while (!last)
+        {
+            last = br.bits(1) != 0;
+            const int type = br.bits(2);
+
+            if (type == 0)
+            {
+                br.align();
+
+                std::vector<uint8_t> header;
+                if (!br.readBytes(header, 4)) return false;
+
+                const size_t len = header[0] | (header[1] << 8);
+                if (!br.readBytes(out, len)) return false;
+            }
+            else if (type == 1)
+            {
+                // 고정 허프만
+                std::fill(lengths.begin(),       lengths.begin() + 144, static_cast<uint8_t>(8));
+                std::fill(lengths.begin() + 144, lengths.begin() + 256, static_cast<uint8_t>(9));
+                std::fill(lengths.begin() + 256, lengths.begin() + 280, static_cast<uint8_t>(7));
+                std::fill(lengths.begin() + 280, lengths.begin() + 288, static_cast<uint8_t>(8));
+                lit.build(lengths.data(), 288);
+
+                std::fill(lengths.begin(), lengths.begin() + 30, static_cast<uint8_t>(5));
+                dist.build(lengths.data(), 30);
+
+                if (!inflateBlock(br, lit, dist, out)) return false;
+            }
+            else if (type == 2)
+            {
+                // 동적 허프만. 코드 길이를 다시 허프만으로 읽음
+                const int nlen  = br.bits(5) + 257;
+                const int ndist = br.bits(5) + 1;
+                const int ncode = br.bits(4) + 4;
+                if (nlen > 286 || ndist > 30) return false;
+
+                lengths.fill(0);
+                for (int i = 0; i < ncode; i++) lengths[CODE_LENGTH_ORDER[i]] = static_cast<uint8_t>(br.bits(3));
+
+                Huffman code;
+                code.build(lengths.data(), 19);
+
+                int i = 0;
+                while (i < nlen + ndist)
+                {
+                    const int sym = code.decode(br);
+                    if (sym < 0 || br.overflow) return false;
+
+                    if (sym < 16)
+                    {
+                        lengths[i++] = static_cast<uint8_t>(sym);
+                        continue;
+                    }
+
+                    uint8_t value = 0;
+                    int repeat;
+                    if (sym == 16)
+                    {
+                        if (i == 0) return false;
+                        value = lengths[i - 1];
+                        repeat = 3 + br.bits(2);
+                    }
+                    else if (sym == 17) repeat = 3  + br.bits(3);
+                    else                repeat = 11 + br.bits(7);
+
+                    if (i + repeat > nlen + ndist) return false;
+                    while (repeat-- > 0) lengths[i++] = value;
+                }
+
+                lit.build(lengths.data(), nlen);
+                dist.build(lengths.data() + nlen, ndist);
+
+                if (!inflateBlock(br, lit, dist, out)) return false;
+            }
+            else
+            {
+                return false;
+            }
+
+            if (br.overflow) return false;
+        }
+
+        return true;
+    }
+
+    inline uint32_t readBE32(const uint8_t* p)
+    {
+        return (static_cast<uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+    }
+
+    inline uint8_t paeth(int a, int b, int c)
+    {
+        const int p  = a + b - c;
+        const int pa = std::abs(p - a);
+        const int pb = std::abs(p - b);
+        const int pc = std::abs(p - c);
+
+        if (pa <= pb && pa <= pc) return static_cast<uint8_t>(a);
+        if (pb <= pc)             return static_cast<uint8_t>(b);
+        return static_cast<uint8_t>(c);
+    }
+
+    bool decodePNG(const std::vector<uint8_t>& data, std::vector<uint8_t>& rgba, v::Size2i& size)
+    {
+        if (data.size() < PNG_SIGNATURE.size() || !std::equal(PNG_SIGNATURE.begin(), PNG_SIGNATURE.end(), data.begin())) return false;
+
+        int colorType = -1;
+        std::vector<uint8_t> zlib;
+
+        // 팔레트 (color type 3). tRNS 가 없으면 불투명
+        std::array<uint8_t, 256 * 4> palette{};
+        for (size_t i = 3; i < palette.size(); i += 4) palette[i] = 255;
+
+        size_t pos = PNG_SIGNATURE.size();
+        while (pos + 12 <= data.size())
+        {
+            const size_t len = readBE32(&data[pos]);
+            const auto type = &data[pos + 4];
+            const auto body = &data[pos + 8];
+            if (pos + 12 + len > data.size()) return false;
+
+            if (std::equal(type, type + 4, "IHDR"))
+            {
+                if (len < 13) return false;
+                size.w = static_cast<int>(readBE32(body));
+                size.h = static_cast<int>(readBE32(body + 4));
+                colorType = body[9];
+
+                // 8bit, 인터레이스 없음. 회색 (0), RGB (2), 팔레트 (3), 회색+알파 (4), RGBA (6)
+                if (body[8] != 8 || body[12] != 0 || colorType == 1 || colorType == 5 || colorType > 6) return false;
+            }
+            else if (std::equal(type, type + 4, "PLTE"))
+            {
+                for (size_t i = 0; i < len / 3 && i < 256; i++)
+                {
+                    palette[i * 4 + 0] = body[i * 3 + 0];
+                    palette[i * 4 + 1] = body[i * 3 + 1];
+                    palette[i * 4 + 2] = body[i * 3 + 2];
+                }
+            }
+            else if (std::equal(type, type + 4, "tRNS"))
+            {
+                // 팔레트 알파만 처리. 회색, RGB 의 투명색 지정은 쓰지 않음
+                if (colorType == 3)
+                {
+                    for (size_t i = 0; i < len && i < 256; i++) palette[i * 4 + 3] = body[i];
+                }
+            }
+            else if (std::equal(type, type + 4, "IDAT"))
+            {
+                zlib.insert(zlib.end(), body, body + len);
+            }
+            else if (std::equal(type, type + 4, "IEND"))
+            {
+                break;
+            }
+
+            pos += 12 + len;
+        }
+
+        if (colorType == -1 || size.w <= 0 || size.h <= 0) return false;
+
+        std::vector<uint8_t> raw;
+        if (!inflate(zlib.data(), zlib.size(), raw)) return false;
+
+        size_t bpp = 0;
+        switch (colorType)
+        {
+        case 0: bpp = 1; break;
+        case 2: bpp = 3; break;
+        case 3: bpp = 1; break;
+        case 4: bpp = 2; break;
+        case 6: bpp = 4; break;
+        }
+        const size_t stride = bpp * size.w;
+        if (raw.size() < (stride + 1) * size.h) return false;
+
+        // 필터 되돌리기
+        std::vector<uint8_t> prev(stride, 0);
+        rgba.resize(static_cast<size_t>(size.w) * size.h * 4);
+
+        for (int y = 0; y < size.h; y++)
+        {
+            uint8_t* row = &raw[(stride + 1) * y];
+            const uint8_t filter = *row++;
+
+            for (size_t i = 0; i < stride; i++)
+            {
+                const int a = i >= bpp ? row[i - bpp] : 0;
+                const int b = prev[i];
+                const int c = i >= bpp ? prev[i - bpp] : 0;
+
+                switch (filter)
+                {
+                case 0:                                                         break;
+                case 1: row[i] = static_cast<uint8_t>(row[i] + a);             break;
+                case 2: row[i] = static_cast<uint8_t>(row[i] + b);             break;
+                case 3: row[i] = static_cast<uint8_t>(row[i] + (a + b) / 2);   break;
+                case 4: row[i] = static_cast<uint8_t>(row[i] + paeth(a, b, c)); break;
+                default: return false;
+                }
+            }
+            std::copy(row, row + stride, prev.begin());
+
+            // 아래쪽 줄부터
+            uint8_t* dst = &rgba[static_cast<size_t>(size.h - 1 - y) * size.w * 4];
+            for (int x = 0; x < size.w; x++)
+            {
+                const uint8_t* src = &row[x * bpp];
+                switch (colorType)
+                {
+                case 0: dst[x * 4 + 0] = dst[x * 4 + 1] = dst[x * 4 + 2] = src[0]; dst[x * 4 + 3] = 255;    break;
+                case 4: dst[x * 4 + 0] = dst[x * 4 + 1] = dst[x * 4 + 2] = src[0]; dst[x * 4 + 3] = src[1]; break;
+                case 3: std::copy_n(&palette[src[0] * 4], 4, &dst[x * 4]);                                 break;
+                default:
+                    dst[x * 4 + 0] = src[0];
+                    dst[x * 4 + 1] = src[1];
+                    dst[x * 4 + 2] = src[2];
+                    dst[x * 4 + 3] = bpp == 4 ? src[3] : 255;
+                    break;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    /**************************************************************************************************************/
+
+    std::string headerY4M(v::Size2i size, int fps)
+    {
+        return "YUV4MPEG2 W" + std::to_string(size.w) + " H" + std::to_string(size.h) + " F" + std::to_string(fps) + ":1 Ip A1:1 C420jpeg\n";
+    }
+
+    inline uint8_t clampByte(float value)
+    {
+        return static_cast<uint8_t>(std::clamp(std::lround(value), 0l, 255l));
+    }
+
+    void encodeY4M(const uint8_t* rgba, v::Size2i size, std::vector<uint8_t>& out)
+    {
+        constexpr char FRAME_HEADER[] = "FRAME\n";
+
+        const size_t cw = (size.w + 1) / 2;
+        const size_t ch = (size.h + 1) / 2;
+
+        const size_t sizeY = static_cast<size_t>(size.w) * size.h;
+        const size_t sizeC = cw * ch;
+
+        out.resize(sizeof(FRAME_HEADER) - 1 + sizeY + sizeC * 2);
+        std::copy(FRAME_HEADER, FRAME_HEADER + sizeof(FRAME_HEADER) - 1, out.begin());
+
+        uint8_t* planeY = out.data() + sizeof(FRAME_HEADER) - 1;
+        uint8_t* planeU = planeY + sizeY;
+        uint8_t* planeV = planeU + sizeC;
+
+        // 위쪽 줄부터
+        const auto pixel = [&](int x, int y) {
+            return rgba + (static_cast<size_t>(size.h - 1 - y) * size.w + x) * 4;
+        };
+
+        for (int y = 0; y < size.h; y++)
+        {
+            for (int x = 0; x < size.w; x++)
+            {
+                const auto p = pixel(x, y);
+                planeY[static_cast<size_t>(y) * size.w + x] = clampByte(0.299f * p[0] + 0.587f * p[1] + 0.114f * p[2]);
+            }
+        }
+
+        // 2x2 평균
+        for (size_t cy = 0; cy < ch; cy++)
+        {
+            for (size_t cx = 0; cx < cw; cx++)
+            {
+                float r = 0, g = 0, b = 0;
+                int n = 0;
+
+                for (int dy = 0; dy < 2; dy++)
+                {
+                    for (int dx = 0; dx < 2; dx++)
+                    {
+                        const int x = static_cast<int>(cx * 2) + dx;
+                        const int y = static_cast<int>(cy * 2) + dy;
+                        if (x >= size.w || y >= size.h) continue;
+
+                        const auto p = pixel(x, y);
+                        r += p[0];
+                        g += p[1];
+                        b += p[2];
+                        n++;
+                    }
+                }
+
+                r /= n;
+                g /= n;
+                b /= n;
+
+                planeU[cy * cw + cx] = clampByte(128 - 0.168736f * r - 0.331264f * g + 0.5f      * b);
+                planeV[cy * cw + cx] = clampByte(128 + 0.5f      * r - 0.418688f * g - 0.081312f * b);
+            }
+        }
+    }
+}
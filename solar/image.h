@@ -0,0 +1,25 @@
+﻿// 화면 내보내기, 비교용 이미지 인코딩
+// glReadPixels 로 읽은 RGBA 버퍼 (아래쪽 줄부터) 를 받아서 위쪽 줄부터 저장한다.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "v.h"
+
+namespace image
+{
+    // PNG (RGB 8bit). 외부 라이브러리 없이 쓰기 위해 압축하지 않은 deflate 블록으로 저장함
+    void encodePNG(const uint8_t* rgba, v::Size2i size, std::vector<uint8_t>& out);
+
+    // PNG 읽기. 8bit, 인터레이스 없는 것만 지원 (회색, RGB, 팔레트, 알파 포함). 결과는 RGBA 이고 encodePNG 와 같이 아래쪽 줄부터
+    bool decodePNG(const std::vector<uint8_t>& data, std::vector<uint8_t>& rgba, v::Size2i& size);
+
+    // YUV4MPEG2 스트림 헤더. 4:2:0, BT.601 full range (C420jpeg)
+    std::string headerY4M(v::Size2i size, int fps);
+
+    // YUV4MPEG2 프레임 하나. FRAME 헤더 포함
+    void encodeY4M(const uint8_t* rgba, v::Size2i size, std::vector<uint8_t>& out);
+}
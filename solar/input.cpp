@@ -1,7 +1,9 @@
 ﻿#include "input.h"
 
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <condition_variable>
 #include <functional>
 #include <iostream>
 #include <mutex>
@@ -14,6 +16,7 @@
 #include "config.h"
 #include "ui.h"
 #include "planet.h"
+#include "trace.h"
 
 namespace input
 {
@@ -118,13 +121,84 @@ namespace input
     v::Point2f  mousePosition;   // 마우스 버튼을 누른 위치
     clock_point mousePressed; // 마우스 버튼 누른 시간
 
+    // 이벤트를 처리하면서 기록해둔 상태. 처리하는 스레드에서만 씀
+    std::array<bool, GLFW_KEY_LAST + 1>          keyPressed{};    // 눌린 키
+    std::array<bool, GLFW_MOUSE_BUTTON_LAST + 1> buttonPressed{}; // 눌린 마우스 버튼
+    v::Point2f                                   cursorPosition;  // 마지막 커서 위치
+
+    /**************************************************************************************************************/
+    // 입력 대기열
+    // GLFW 콜백은 메인 스레드에서 불리므로 여기서는 쌓기만 하고, 그리는 스레드에서 processEvents 로 꺼내서 처리한다.
+
+    struct Event
+    {
+        enum class Type
+        {
+            Key,
+            CursorPos,
+            MouseButton,
+            Scroll,
+        };
+
+        Type        type;
+        clock_point time;   // 콜백이 불린 시간
+
+        int         key;    // 키, 마우스 버튼
+        int         action;
+        int         mods;
+        v::Point2f  pos;    // 커서 위치
+        float       offset; // 휠
+    };
+
+    std::mutex              queueLock;
+    std::condition_variable queueChanged;
+    std::vector<Event>      queue;
+    std::vector<Event>      processing; // 처리중인 것. 버퍼 재사용
+    bool                    notified = false;
+
+    void push(const Event& e)
+    {
+        {
+            std::lock_guard<std::mutex> __lock(queueLock);
+            queue.push_back(e);
+        }
+        queueChanged.notify_all();
+
+        render::invalidate();
+    }
+
+    void notify()
+    {
+        {
+            std::lock_guard<std::mutex> __lock(queueLock);
+            notified = true;
+        }
+        queueChanged.notify_all();
+    }
+
+    bool waitEvents(double timeout)
+    {
+        std::unique_lock<std::mutex> __lock(queueLock);
+
+        const bool woken = queueChanged.wait_for(
+            __lock,
+            std::chrono::duration<double>(timeout),
+            [] { return notified || !queue.empty(); }
+        );
+        notified = false;
+
+        return woken;
+    }
+
+    /**************************************************************************************************************/
+
     // 반복키 처리
-    void handleKeyRepeat(GLFWwindow* window, float deltaSeconds)
+    void handleKeyRepeat(float deltaSeconds)
     {
         for (auto& b : keyboard)
         {
             // 반복키로 설정되어 있고 현재 눌린 키는 처리
-            if (b.action == GLFW_REPEAT && glfwGetKey(window, b.key) == GLFW_PRESS)
+            if (b.action == GLFW_REPEAT && keyPressed.at(b.key))
             {
                 b.func(deltaSeconds);
             }
@@ -145,10 +219,17 @@ namespace input
         }
     }
 
-    void cbKey(GLFWwindow* window, int key, int scancode, int action, int mods)
+    void onKey(const Event& e)
     {
-        std::cout << "cbKey key: " << key << " scancode: " << scancode << " action : " << action << " mods : " << mods << std::endl;
-        handle(keyboard, key, action);
+        std::cout << "cbKey key: " << e.key << " action : " << e.action << " mods : " << e.mods << std::endl;
+
+        if (0 <= e.key && e.key <= GLFW_KEY_LAST)
+        {
+            if (e.action == GLFW_PRESS)   keyPressed.at(e.key) = true;
+            if (e.action == GLFW_RELEASE) keyPressed.at(e.key) = false;
+        }
+
+        handle(keyboard, e.key, e.action);
     }
 
     // 마우스 이동 처리하는 함수.
@@ -198,28 +279,31 @@ namespace input
         }
     }
 
-    void cbCursorPos(GLFWwindow* window, double xpos, double ypos)
+    void onCursorPos(const Event& e)
     {
+        cursorPosition = e.pos;
+
         // 마우스를 누르고 있으면 내부 연산 처리
         if (mouseDown)
         {
-            onMouseMove(v::Point2d(xpos, ypos));
+            onMouseMove(e.pos);
         }
     }
 
-    void cbMouseButton(GLFWwindow* window, int button, int action, int mods)
+    void onMouseButton(const Event& e)
     {
-        std::cout << "cbMouseButton button: " << button << " action: " << action << " mods: " << mods << std::endl;
+        std::cout << "cbMouseButton button: " << e.key << " action: " << e.action << " mods: " << e.mods << std::endl;
 
-        // 현재 마우스 커서 위치 가져오는 부분
-        double x, y;
-        glfwGetCursorPos(window, &x, &y);
-        const v::Point2f pos(
-            static_cast<float>(x),
-            static_cast<float>(y)
-        );
+        const auto button = e.key;
+        const auto pos    = e.pos;
 
-        switch (action)
+        cursorPosition = pos;
+        if (0 <= button && button <= GLFW_MOUSE_BUTTON_LAST)
+        {
+            buttonPressed.at(button) = e.action == GLFW_PRESS;
+        }
+
+        switch (e.action)
         {
         case GLFW_PRESS: // onMouseDown
             // UI 영역인지 확인
@@ -240,8 +324,8 @@ namespace input
                         camera::moveDeltaStart(pos);
                     }
 
-                    // 누른 시간 기록하기
-                    mousePressed = clock::now();
+                    // 누른 시간 기록하기. 처리가 늦어져도 길게 누른 것으로 보지 않도록 콜백이 불린 시간으로
+                    mousePressed = e.time;
 
                     return;
                 }
@@ -255,15 +339,15 @@ namespace input
                 if (!mouseDrag) // 드래그 작업을 하지 않아야만 버튼 작업으로 처리
                 {
                     // 누른 시간 확인하기
-                    const float deltaSeconds = std::chrono::duration<float, std::milli>(clock::now() - mousePressed).count();
+                    const float deltaSeconds = std::chrono::duration<float, std::milli>(e.time - mousePressed).count();
                     if (deltaSeconds > WINDOW_LONG_PRESSED_TIME)
                     {
                         // 오른쪽을 길게 누르는 작업 별도 분리
-                        handle(mouse, button | LONG_PRESS, action);
+                        handle(mouse, button | LONG_PRESS, e.action);
                     }
                     else
                     {
-                        handle(mouse, button, action);
+                        handle(mouse, button, e.action);
                     }
                 }
                 mouseDown = false;
@@ -276,19 +360,101 @@ namespace input
         }
     }
 
-    void cbScroll(GLFWwindow* window, double xoffset, double yoffset)
+    void onScroll(const Event& e)
     {
-        std::cout << "cbScroll xoffset: " << xoffset << " yoffset: " << yoffset << std::endl;
+        std::cout << "cbScroll offset: " << e.offset << " mods: " << e.mods << std::endl;
 
         // Alt + Scroll
-        if (glfwGetKey(window, GLFW_KEY_LEFT_ALT) == GLFW_PRESS)
+        if (e.mods & GLFW_MOD_ALT)
         {
-            config::speedDelta(static_cast<float>(yoffset), true);
+            config::speedDelta(e.offset, true);
         }
         else
         {
-            camera::zoomDelta(static_cast<float>(yoffset), true);
+            camera::zoomDelta(e.offset, true);
+        }
+    }
+
+    void processEvents()
+    {
+        TRACE_SCOPE("input::processEvents");
+
+        {
+            std::lock_guard<std::mutex> __lock(queueLock);
+            std::swap(queue, processing);
         }
+
+        for (const auto& e : processing)
+        {
+            switch (e.type)
+            {
+            case Event::Type::Key:         onKey(e);         break;
+            case Event::Type::CursorPos:   onCursorPos(e);   break;
+            case Event::Type::MouseButton: onMouseButton(e); break;
+            case Event::Type::Scroll:      onScroll(e);      break;
+            }
+        }
+
+        processing.clear();
+    }
+
+    v::Point2f cursor() noexcept
+    {
+        return cursorPosition;
+    }
+
+    bool buttonDown(int button) noexcept
+    {
+        return 0 <= button && button <= GLFW_MOUSE_BUTTON_LAST && buttonPressed[button];
+    }
+
+    /**************************************************************************************************************/
+    // GLFW 콜백. 메인 스레드
+
+    void cbKey(GLFWwindow*, int key, int, int action, int mods)
+    {
+        Event e{};
+        e.type   = Event::Type::Key;
+        e.time   = clock::now();
+        e.key    = key;
+        e.action = action;
+        e.mods   = mods;
+        push(e);
+    }
+
+    void cbCursorPos(GLFWwindow*, double xpos, double ypos)
+    {
+        Event e{};
+        e.type = Event::Type::CursorPos;
+        e.time = clock::now();
+        e.pos  = v::Point2f(static_cast<float>(xpos), static_cast<float>(ypos));
+        push(e);
+    }
+
+    void cbMouseButton(GLFWwindow* window, int button, int action, int mods)
+    {
+        // 현재 마우스 커서 위치 가져오는 부분. GLFW 함수라 여기서
+        double x, y;
+        glfwGetCursorPos(window, &x, &y);
+
+        Event e{};
+        e.type   = Event::Type::MouseButton;
+        e.time   = clock::now();
+        e.key    = button;
+        e.action = action;
+        e.mods   = mods;
+        e.pos    = v::Point2f(static_cast<float>(x), static_cast<float>(y));
+        push(e);
+    }
+
+    void cbScroll(GLFWwindow* window, double, double yoffset)
+    {
+        Event e{};
+        e.type   = Event::Type::Scroll;
+        e.time   = clock::now();
+        e.mods   = glfwGetKey(window, GLFW_KEY_LEFT_ALT) == GLFW_PRESS ? GLFW_MOD_ALT : 0;
+        e.offset = static_cast<float>(yoffset);
+        push(e);
     }
 
     std::wstring helpString;
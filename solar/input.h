@@ -1,4 +1,5 @@
 ﻿// 키보드 및 마우스 이벤트 처리
+// GLFW 콜백은 이벤트를 시간과 함께 대기열에 쌓기만 하고, 그리는 스레드에서 processEvents 로 처리한다.
 
 #pragma once
 
@@ -7,9 +8,18 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include "v.h"
+
 namespace input
 {
-    void handleKeyRepeat(GLFWwindow* window, float deltaSeconds); // 반복키 처리
+    void processEvents(); // 쌓인 이벤트 처리. 그리는 스레드에서 호출
+    void handleKeyRepeat(float deltaSeconds); // 반복키 처리. 키 상태는 processEvents 에서 기록한 것
+
+    bool waitEvents(double timeout); // 이벤트가 쌓이거나 notify 할 때 까지 최대 timeout 초 대기. 그리는 스레드용
+    void notify(); // waitEvents 로 기다리는 스레드 깨우기
+
+    v::Point2f cursor() noexcept; // 마지막 커서 위치. processEvents 에서 기록한 것
+    bool buttonDown(int button) noexcept; // 마우스 버튼이 눌려있는지
 
     void cbKey(GLFWwindow* window, int key, int scancode, int action, int mods); // 키보드 처리
 
@@ -1,66 +1,43 @@
 ﻿#include <exception>
-
-#include <Windows.h>
+#include <fstream>
+#include <iostream>
+#include <thread>
 
 #include <glad/glad.h>
-#include <glad/glad_wgl.h>
 #include <GLFW/glfw3.h>
-#define GLFW_EXPOSE_NATIVE_WIN32
-#include <GLFW/glfw3native.h>
 
+#include "args.h"
+#include "benchmark.h"
 #include "camera.h"
 #include "config.h"
 #include "constants.h"
+#include "defer.h"
+#include "ephemeris.h"
+#include "exporter.h"
 #include "glext.h"
 #include "input.h"
+#include "model_text.h"
+#include "planet.h"
+#include "platform.h"
+#include "regress.h"
 #include "render.h"
-
-// 생성된 윈도우
-GLFWwindow* window;
+#include "simulation.h"
+#include "trace.h"
+#include "vtexture.h"
 
 // opengl 라이브러리 초기화
 inline void initOpenGL()
 {
     /**************************************************************************************************************/
 
-    // glfw 초기화
-    if (glfwInit() != GLFW_TRUE)
-    {
-        throw std::runtime_error(std::string("Failed to initialize GLFW. error-code :") + std::to_string(glfwGetError(nullptr)));
-    }
+    const auto& opt = args::get();
 
-    // 사용할 OpenGL 버전 명시.
-    glfwWindowHint(GLFW_SAMPLES,               OPENGL_MSAA_SAMPLES     ); // 안티엘리어싱
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3                       ); // OpenGL 3.3
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3                       );
-    glfwWindowHint(GLFW_OPENGL_PROFILE,        GLFW_OPENGL_CORE_PROFILE); // deprecated API 사용하지 않기
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE                 ); // deprecated API 제외하기
-
-    // glfw 윈도우 생성
-    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
-    window = glfwCreateWindow(WINDOW_SIZE.w, WINDOW_SIZE.h, WINDOW_CAPTION, nullptr, nullptr);
-    if (window == nullptr)
-    {
-        throw std::runtime_error("Failed to create GLFW window.");
-    }
-    glfwMakeContextCurrent(window);
-
-    // glad 초기화
-    if (!gladLoadGL())
-    {
-        throw std::runtime_error("Failed to initialize Glad");
-    }
-    
-    // glad-wsl 초기화
-    if (!gladLoadWGL(GetDC(glfwGetWin32Window(window))))
-    {
-        throw std::runtime_error("Failed to initialize Glad-WGL");
-    }
+    // 창 혹은 창 없는 컨텍스트 생성
+    platform::init(platform::parseBackend(opt.backend), opt.size);
 
     /**************************************************************************************************************/
     // opengl 라이브러리 버전 출력
     std::cout << "----- VERSION -----" << std::endl;
-    std::cout << "GLFW version : " << glfwGetVersionString() << std::endl;
     std::cout << "GLAD version : " << GLVersion.major << "." << GLVersion.minor << std::endl;
 
     std::cout << "OpenGL version  : " << glGetString(GL_VERSION)  << std::endl;
@@ -75,9 +52,15 @@ inline void initOpenGL()
 // 콜백함수 등록
 inline void setCallback()
 {
+    const auto window = platform::window();
+    const auto size = platform::size();
+
+    // 창이 없으면 크기만 설정
+    camera::cbFramebufferSize(window, size.w, size.h);
+    if (window == nullptr) return;
+
     // 화면 크기 변경
     glfwSetFramebufferSizeCallback(window, camera::cbFramebufferSize);
-    camera::cbFramebufferSize(window, WINDOW_SIZE.w, WINDOW_SIZE.h);
 
     // 키보드 마우스
     glfwSetInputMode          (window, GLFW_STICKY_KEYS, GL_TRUE); // 입력받음.
@@ -85,15 +68,27 @@ inline void setCallback()
     glfwSetCursorPosCallback  (window, input::cbCursorPos       ); // 마우스 이동
     glfwSetMouseButtonCallback(window, input::cbMouseButton     ); // 마우스 버튼
     glfwSetScrollCallback     (window, input::cbScroll          ); // 마우스 휠
+
+    glfwSetWindowRefreshCallback(window, [](GLFWwindow*) { render::invalidate(); }); // 창이 가려졌다 보이는 등 다시 그려야 할 때
 }
 
-// glfw 메인 루프
-inline void mainLoop()
+// 렌더링 루프. threaded 면 렌더링 스레드에서 돌고, 이벤트는 메인 스레드가 받아서 input 대기열에 쌓아줌
+inline void renderLoop(bool threaded)
 {
     auto lastRenderClock = render::clock::now(); // 마지막 렌더링 시간
 
+    // 창이 없으면 로딩이 끝난 뒤 정해진 프레임 수만큼만 그림
+    int headlessFrames = args::get().frames;
+
+    const bool bench = benchmark::active();
+    const bool exporting = exporter::active();
+    const bool regressing = regress::active();
+
+    // 창에 그리는 평소 상태에서만 필요할 때만 그리기
+    const bool onDemand = platform::window() != nullptr && !bench && !exporting && !regressing;
+
     // 화면이 닫히지 않는 한 계속 반복함.
-    while (!glfwWindowShouldClose(window))
+    while (!platform::shouldClose())
     {
         glext::dispatchInvoke();
 
@@ -104,30 +99,211 @@ inline void mainLoop()
         const float deltaSeconds = std::chrono::duration<float>(renderStartClock - lastRenderClock).count();
         lastRenderClock = renderStartClock;
 
-        // 키 입력 처리
-        input::handleKeyRepeat(window, deltaSeconds);
+        TRACE_SCOPE("frame");
 
-        // 렌더링
-        render::render(window, renderStartClock, deltaSeconds);
+        // 입력 처리. 화면 갱신을 기다린 다음이라 카메라는 그리기 직전의 입력까지 반영됨
+        input::processEvents();
+        input::handleKeyRepeat(deltaSeconds);
+
+        // 바뀐 게 없으면 그리지 않고 이벤트가 올 때까지 기다림
+        if (onDemand && !render::needsRedraw(renderStartClock))
+        {
+            TRACE_SCOPE("idle");
+            if (threaded)
+            {
+                input::waitEvents(RENDER_IDLE_WAIT_SECONDS);
+            }
+            else
+            {
+                platform::waitEvents(RENDER_IDLE_WAIT_SECONDS);
+            }
+            lastRenderClock = render::clock::now();
+            continue;
+        }
+
+        // 렌더링. 벤치마크 중에는 고정된 간격 사용
+        if (bench)
+        {
+            benchmark::beginFrame();
+            render::render(renderStartClock, benchmark::frameSeconds());
+            benchmark::endFrame();
+        }
+        else if (exporting)
+        {
+            // 날자는 exporter 가 프레임마다 정함
+            exporter::beginFrame();
+            render::render(renderStartClock, 0);
+            exporter::endFrame();
+        }
+        else if (regressing)
+        {
+            // 장면마다 날자가 고정됨
+            regress::beginFrame();
+            render::render(renderStartClock, 0);
+            regress::endFrame();
+        }
+        else
+        {
+            render::render(renderStartClock, deltaSeconds);
+        }
 
         // 화면 갱신
-        glfwSwapBuffers(window);
+        {
+            TRACE_SCOPE("swapBuffers");
+            platform::swapBuffers();
+        }
 
         // 이벤트 처리
-        glfwPollEvents();
+        if (!threaded)
+        {
+            platform::pollEvents();
+        }
+
+        if (bench)
+        {
+            if (benchmark::finished()) break;
+        }
+        else if (exporting)
+        {
+            if (exporter::finished()) break;
+        }
+        else if (regressing)
+        {
+            if (regress::finished()) break;
+        }
+        else if (platform::headless() && render::loaded() && --headlessFrames <= 0)
+        {
+            break;
+        }
+    }
+}
+
+// 메인 루프. 반환값은 종료 코드
+inline int mainLoop()
+{
+    const bool bench = benchmark::active();
+    const bool exporting = exporter::active();
+    const bool regressing = regress::active();
+
+    // 창에 그리는 평소 상태
+    const bool interactive = platform::window() != nullptr && !bench && !exporting && !regressing;
+
+    // 천체 위치는 따로 계산. 프레임마다 날자가 정해지는 경우는 렌더링하면서 바로 계산함
+    if (interactive)
+    {
+        simulation::start(0);
     }
 
-    // glfw 종료
-    glfwTerminate();
+    // 처음 보는 글자는 백그라운드에서 그리고 그 동안 네모로 표시. 결과가 정해져 있어야 하는 경우는 기다림
+    model::Text::instance().setAsyncMisses(interactive);
+
+    // 큰 텍스쳐 타일도 마찬가지
+    vtexture::setAsync(interactive);
+
+    // 창을 옮기거나 크기를 바꾸는 동안 이벤트 처리가 멈춰도 렌더링은 계속되도록 GL 컨텍스트를 렌더링 스레드로 넘김
+    if (interactive && !args::get().singleThread)
+    {
+        std::exception_ptr error;
+
+        platform::detachContext();
+        std::thread renderThread([&error]() {
+            trace::setThreadName("render");
+
+            platform::attachContext();
+            defer(platform::detachContext());
+
+            try
+            {
+                renderLoop(true);
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+                platform::requestClose();
+            }
+        });
+
+        // 메인 스레드는 이벤트만 받음. 콜백이 input 대기열에 쌓음
+        while (!platform::shouldClose())
+        {
+            platform::waitEvents(RENDER_IDLE_WAIT_SECONDS);
+            input::notify();
+        }
+
+        input::notify();
+        renderThread.join();
+        platform::attachContext();
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+    else
+    {
+        renderLoop(false);
+    }
+
+    // 벤치마크 결과. GL 컨텍스트가 있어야 해서 종료 전에
+    if (bench)
+    {
+        const auto& path = args::get().benchmarkOut;
+        if (path.empty())
+        {
+            benchmark::report(std::cout);
+        }
+        else
+        {
+            std::ofstream fs(path, std::ios::trunc);
+            benchmark::report(fs);
+            std::cout << "benchmark : report saved. path: " << path << std::endl;
+        }
+    }
+
+    simulation::stop();
+    vtexture::stop();
+
+    // 남은 프레임 쓰기
+    exporter::finish();
+
+    // 회귀 테스트 결과
+    const int exitCode = regressing ? regress::report() : 0;
+
+    // CPU 구간 기록
+    if (!args::get().trace.empty())
+    {
+        trace::dump(args::get().trace);
+    }
+
+    // 종료
+    platform::terminate();
+
+    return exitCode;
 }
 
-inline void mainBody()
+inline int mainBody()
 {
     initOpenGL();
 
+    // 천체 목록
+    planet::init();
+
+    // 벤치마크, 회귀 테스트 스크립트. 천체 이름을 찾아야 해서 목록 읽은 다음에
+    if (!args::get().benchmark.empty())
+    {
+        benchmark::load(args::get().benchmark);
+    }
+    if (!args::get().regress.empty())
+    {
+        regress::load(args::get().regress);
+    }
+
     input::init();
-    render::init(window);
-    ui::init(window);
+    render::init();
+    if (platform::window() != nullptr)
+    {
+        ui::init(platform::window());
+    }
 
     // 리셋 및 초기화
     camera::reset();
@@ -135,28 +311,57 @@ inline void mainBody()
 
     setCallback();
 
-    mainLoop();
+    // 내보내기. 화면 크기를 알아야 해서 콜백 등록 다음에
+    exporter::init();
+
+    return mainLoop();
 }
 
 int main(int argc, char** argv)
 {
+    args::parse(argc, argv);
+    trace::setThreadName("main");
+
+    // 여러 프로세스로 나눠 내보내기. 이 프로세스는 창 없이 자식을 띄우고 결과만 합침
+    if (!args::get().exportPath.empty() && args::get().exportProcesses > 1 && args::get().shardCount == 1)
+    {
+        return exporter::coordinate();
+    }
+
+    // 급수 벤치마크. 창 없이 계산만
+    if (args::get().benchEphemeris)
+    {
+        planet::init();
+        ephemeris::load();
+        ephemeris::benchmark(std::cout);
+        return 0;
+    }
+
+    // 글씨 벤치마크. 글리프 텍스쳐를 만들어야 해서 컨텍스트만 만듦
+    if (args::get().benchText)
+    {
+        initOpenGL();
+        model::Text::instance().init();
+        model::Text::instance().benchmark(std::cout);
+        platform::terminate();
+        return 0;
+    }
+
     // 디버그 모드면 오류 핸들링 하지 않고 다시 던지기 (디버거에 break 걸리게)
     if constexpr (IS_DEBUG)
     {
-        mainBody();
+        return mainBody();
     }
     else
     {
         try
         {
-            mainBody();
+            return mainBody();
         }
         catch (const std::exception& e)
         {
-            MessageBoxA(NULL, e.what(), WINDOW_CAPTION, MB_OK | MB_ICONERROR);
+            platform::showError(e.what());
             return 1;
         }
     }
-
-    return 0;
 }
@@ -0,0 +1,303 @@
+﻿#include "minorbody.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include "args.h"
+#include "constants.h"
+#include "utils.h"
+
+// 참고자료
+// MPCORB.DAT 형식 : https://www.minorplanetcenter.net/iau/info/MPOrbitFormat.html
+// 압축된 날자 형식 : https://www.minorplanetcenter.net/iau/info/PackedDates.html
+
+namespace minorbody
+{
+    constexpr uint32_t BINARY_MAGIC   = 0x424D5353; // "SSMB"
+    constexpr uint32_t BINARY_VERSION = 1;
+
+    // MPCORB.DAT 의 각 항목 위치. 1 부터 시작하는 문서 기준 열 번호
+    struct Column
+    {
+        int start;
+        int end;
+    };
+    constexpr Column MPC_H     = {   9,  13 };
+    constexpr Column MPC_EPOCH = {  21,  25 };
+    constexpr Column MPC_M     = {  27,  35 };
+    constexpr Column MPC_PERI  = {  38,  46 };
+    constexpr Column MPC_NODE  = {  49,  57 };
+    constexpr Column MPC_INCL  = {  60,  68 };
+    constexpr Column MPC_E     = {  71,  79 };
+    constexpr Column MPC_N     = {  81,  91 };
+    constexpr Column MPC_A     = {  93, 103 };
+
+    void Elements::reserve(size_t count)
+    {
+        for (int c = 0; c < ELEMENTS_COLUMNS; c++)
+        {
+            column(*this, c).reserve(count);
+        }
+    }
+
+    void Elements::clear()
+    {
+        for (int c = 0; c < ELEMENTS_COLUMNS; c++)
+        {
+            column(*this, c).clear();
+        }
+    }
+
+    std::vector<float>& column(Elements& elements, int index)
+    {
+        switch (index)
+        {
+        case 0: return elements.a;
+        case 1: return elements.e;
+        case 2: return elements.i;
+        case 3: return elements.node;
+        case 4: return elements.peri;
+        case 5: return elements.M;
+        case 6: return elements.n;
+        case 7: return elements.H;
+        }
+
+        throw std::out_of_range("minorbody column");
+    }
+    const std::vector<float>& column(const Elements& elements, int index)
+    {
+        return column(const_cast<Elements&>(elements), index);
+    }
+
+    // 줄에서 해당 열의 숫자 읽기. 비어있으면 false
+    bool readColumn(const std::string& line, Column col, double& value)
+    {
+        if (line.size() < static_cast<size_t>(col.end)) return false;
+
+        // 옆 항목까지 읽지 않도록 잘라서 읽는다.
+        std::array<char, 32> buff{};
+        const auto len = std::min<size_t>(col.end - col.start + 1, buff.size() - 1);
+        std::memcpy(buff.data(), line.data() + col.start - 1, len);
+
+        char* end = nullptr;
+        value = std::strtod(buff.data(), &end);
+
+        return end != buff.data();
+    }
+
+    // 압축된 날자 한 글자 -> 숫자. 1-9, A=10, B=11...
+    int unpackDigit(char c)
+    {
+        if ('0' <= c && c <= '9') return c - '0';
+        if ('A' <= c && c <= 'Z') return c - 'A' + 10;
+        return -1;
+    }
+
+    // 1970-01-01 부터 지난 일 수
+    // http://howardhinnant.github.io/date_algorithms.html#days_from_civil
+    long long daysFromCivil(long long y, unsigned m, unsigned d)
+    {
+        y -= m <= 2;
+        const long long era = (y >= 0 ? y : y - 399) / 400;
+        const unsigned yoe = static_cast<unsigned>(y - era * 400);
+        const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + static_cast<long long>(doe) - 719468;
+    }
+
+    // 압축된 날자 (K2555 = 2025-05-05) 를 J2000 기준 일 수로 변환
+    bool unpackEpoch(const std::string& line, double& days)
+    {
+        if (line.size() < static_cast<size_t>(MPC_EPOCH.end)) return false;
+
+        const char* p = line.data() + MPC_EPOCH.start - 1;
+
+        int century = 0;
+        switch (p[0])
+        {
+        case 'I': century = 1800; break;
+        case 'J': century = 1900; break;
+        case 'K': century = 2000; break;
+        default: return false;
+        }
+
+        const int yy    = unpackDigit(p[1]) * 10 + unpackDigit(p[2]);
+        const int month = unpackDigit(p[3]);
+        const int day   = unpackDigit(p[4]);
+        if (yy < 0 || month < 1 || month > 12 || day < 1 || day > 31) return false;
+
+        // J2000 = 2000-01-01 12:00, 궤도 요소의 epoch 는 0 시 기준.
+        constexpr long long J2000_FROM_UNIX = 10957;
+        days = static_cast<double>(daysFromCivil(century + yy, month, day) - J2000_FROM_UNIX) - 0.5;
+
+        return true;
+    }
+
+    size_t parseMPC(const std::string& path, Elements& elements)
+    {
+        std::ifstream fs(path);
+        if (!fs.is_open()) return 0;
+
+        // 대략적인 크기로 미리 할당. 한 줄에 203 바이트 정도
+        {
+            std::error_code ec;
+            const auto fileSize = std::filesystem::file_size(path, ec);
+            if (!ec) elements.reserve(static_cast<size_t>(fileSize / 203));
+        }
+
+        constexpr double DEG2RAD = glm::pi<double>() / 180;
+        constexpr double PI2     = glm::two_pi<double>();
+
+        size_t count = 0;
+        bool header = true;
+
+        std::string line;
+        line.reserve(256);
+
+        while (std::getline(fs, line))
+        {
+            // 머리말은 ----- 줄까지
+            if (header)
+            {
+                if (line.compare(0, 5, "-----") == 0) header = false;
+                continue;
+            }
+
+            double H = 0, M = 0, peri = 0, node = 0, incl = 0, e = 0, n = 0, a = 0, epoch = 0;
+
+            // 빈 줄이나 잘못된 줄은 무시
+            if (!readColumn(line, MPC_M,    M   ) ||
+                !readColumn(line, MPC_PERI, peri) ||
+                !readColumn(line, MPC_NODE, node) ||
+                !readColumn(line, MPC_INCL, incl) ||
+                !readColumn(line, MPC_E,    e   ) ||
+                !readColumn(line, MPC_N,    n   ) ||
+                !readColumn(line, MPC_A,    a   ) ||
+                !unpackEpoch(line, epoch))
+            {
+                continue;
+            }
+
+            // 등급 없는 천체도 있음
+            if (!readColumn(line, MPC_H, H)) H = MINORBODY_MAGNITUDE_DEFAULT;
+
+            // 타원 궤도만
+            if (e >= 1 || a <= 0) continue;
+
+            // epoch 의 평균 근점이각을 J2000 기준으로 옮겨둔다.
+            // 셰이더에서는 M(t) = M + n * t 만 계산하면 됨.
+            double M2000 = std::fmod((M - n * epoch) * DEG2RAD, PI2);
+            if (M2000 < 0) M2000 += PI2;
+
+            elements.a   .push_back(static_cast<float>(a));
+            elements.e   .push_back(static_cast<float>(e));
+            elements.i   .push_back(static_cast<float>(incl * DEG2RAD));
+            elements.node.push_back(static_cast<float>(node * DEG2RAD));
+            elements.peri.push_back(static_cast<float>(peri * DEG2RAD));
+            elements.M   .push_back(static_cast<float>(M2000));
+            elements.n   .push_back(static_cast<float>(n * DEG2RAD));
+            elements.H   .push_back(static_cast<float>(H));
+
+            count++;
+        }
+
+        return count;
+    }
+
+    bool readBinary(const std::string& path, Elements& elements)
+    {
+        std::ifstream fs(path, std::ios::binary);
+        if (!fs.is_open()) return false;
+
+        uint32_t magic = 0, version = 0, count = 0;
+        fs.read(reinterpret_cast<char*>(&magic),   sizeof(magic));
+        fs.read(reinterpret_cast<char*>(&version), sizeof(version));
+        fs.read(reinterpret_cast<char*>(&count),   sizeof(count));
+
+        if (!fs || magic != BINARY_MAGIC || version != BINARY_VERSION) return false;
+
+        // 머리말의 개수만큼 할당하기 전에 파일 크기와 맞는지 확인. 잘리거나 깨진 캐시는 원본에서 다시 만듦
+        std::error_code ec;
+        const auto fileSize = std::filesystem::file_size(path, ec);
+        const auto expected = sizeof(magic) + sizeof(version) + sizeof(count) + static_cast<uintmax_t>(count) * ELEMENTS_COLUMNS * sizeof(float);
+        if (ec || fileSize != expected) return false;
+
+        // 항목별로 통째로 읽기
+        for (int c = 0; c < ELEMENTS_COLUMNS; c++)
+        {
+            auto& col = column(elements, c);
+            col.resize(count);
+            fs.read(reinterpret_cast<char*>(col.data()), count * sizeof(float));
+        }
+
+        if (!fs)
+        {
+            elements.clear();
+            return false;
+        }
+
+        return true;
+    }
+
+    void writeBinary(const std::string& path, const Elements& elements)
+    {
+        std::ofstream fs(path, std::ios::binary | std::ios::trunc);
+        if (!fs.is_open())
+        {
+            std::cout << "minorbody : failed to write cache. path: " << path << std::endl;
+            return;
+        }
+
+        const uint32_t count = static_cast<uint32_t>(elements.size());
+        fs.write(reinterpret_cast<const char*>(&BINARY_MAGIC),   sizeof(BINARY_MAGIC));
+        fs.write(reinterpret_cast<const char*>(&BINARY_VERSION), sizeof(BINARY_VERSION));
+        fs.write(reinterpret_cast<const char*>(&count),          sizeof(count));
+
+        for (int c = 0; c < ELEMENTS_COLUMNS; c++)
+        {
+            const auto& col = column(elements, c);
+            fs.write(reinterpret_cast<const char*>(col.data()), count * sizeof(float));
+        }
+    }
+
+    bool load(Elements& elements)
+    {
+        const auto& source = args::get().mpcorb;
+        const auto  cache  = std::filesystem::path(source).replace_extension(MINORBODY_CACHE_EXT).string();
+
+        // 원본이 캐시보다 오래되었으면 캐시 사용
+        if (utils::isCacheFresh(cache, source))
+        {
+            if (readBinary(cache, elements))
+            {
+                std::cout << "minorbody : loaded cache. count: " << elements.size() << std::endl;
+                return true;
+            }
+        }
+
+        std::error_code ec;
+        if (!std::filesystem::exists(source, ec))
+        {
+            std::cout << "minorbody : not found. path: " << source << std::endl;
+            return false;
+        }
+
+        const auto count = parseMPC(source, elements);
+        std::cout << "minorbody : parsed " << source << ". count: " << count << std::endl;
+
+        if (count == 0) return false;
+
+        writeBinary(cache, elements);
+        return true;
+    }
+}
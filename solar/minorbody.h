@@ -0,0 +1,48 @@
+﻿// 소행성, 카이퍼 벨트 천체 등 소천체 궤도 요소
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace minorbody
+{
+    // 소천체 궤도 요소. GPU 로 그대로 올릴 수 있도록 항목별로 나누어 저장함 (SoA)
+    // 각도는 전부 radian, 기준은 J2000 황도.
+    struct Elements
+    {
+        std::vector<float> a;    // 장반경 (AU)
+        std::vector<float> e;    // 이심률
+        std::vector<float> i;    // 기울기
+        std::vector<float> node; // 승교점 경도
+        std::vector<float> peri; // 근일점 인수
+        std::vector<float> M;    // J2000 시점의 평균 근점이각
+        std::vector<float> n;    // 평균 운동 (rad/day)
+        std::vector<float> H;    // 절대 등급
+
+        size_t size() const noexcept { return this->a.size(); }
+
+        void reserve(size_t count);
+        void clear();
+    };
+
+    // 항목 수. 바이너리 파일, 버텍스 attribute 순서와 같음
+    constexpr int ELEMENTS_COLUMNS = 8;
+
+    // Elements 의 항목을 순서대로 가져오는 함수
+    std::vector<float>& column(Elements& elements, int index);
+    const std::vector<float>& column(const Elements& elements, int index);
+
+    // MPC 형식의 궤도 요소 파일 (MPCORB.DAT) 을 한 줄씩 읽어서 elements 에 추가한다.
+    // 읽은 천체 수를 반환함.
+    size_t parseMPC(const std::string& path, Elements& elements);
+
+    // 변환해둔 바이너리 파일 읽고 쓰기
+    bool readBinary(const std::string& path, Elements& elements);
+    void writeBinary(const std::string& path, const Elements& elements);
+
+    // 바이너리 캐시가 원본보다 최신이면 캐시를, 아니면 원본을 읽고 캐시를 새로 만든다.
+    // 파일이 없으면 false
+    bool load(Elements& elements);
+}
@@ -88,6 +88,7 @@ namespace model
             glGenBuffers(1, &this->vbo);
             glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
             glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+            glext::countUpload(sizeof(vertices));
 
             glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(0 * sizeof(float))); glEnableVertexAttribArray(0);
             glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float))); glEnableVertexAttribArray(1);
@@ -124,6 +125,7 @@ namespace model
             glUniformMatrix4fv(this->uniformModelMatrix,      1, GL_FALSE, glm::value_ptr(modelMatrix     ));
 
             glDrawArrays(GL_TRIANGLES, 0, 36);
+            glext::countDraw();
         }
     };
 }
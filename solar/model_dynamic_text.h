@@ -0,0 +1,352 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "constants.h"
+#include "defer.h"
+#include "glext.h"
+#include "model_text.h"
+#include "v.h"
+
+namespace model
+{
+    // fps, 속도, 날자 처럼 자주 바뀌지만 쓰는 글자가 정해져 있는 한 줄짜리 글씨
+    // 글자들은 텍스쳐 하나에 모아두고 글자 사각형은 셰이더 uniform 에 넣어두므로,
+    // 내용이 바뀌면 (펜 위치, 글자 번호) 배열만 올리고 버텍스 셰이더가 사각형으로 펼친다.
+    // 문자열을 만들지 않고 put 으로 바로 배열에 씀.
+    //
+    //   text.begin(); text.put("fps : "); text.put(fps, 1); text.end();
+    //   text.draw(screen, location, color);
+    class DynamicText
+    {
+    private:
+        // 글자 하나. 버텍스 셰이더에 instance 로 넘김
+        struct Instance
+        {
+            float x;     // 펜 위치
+            float y;
+            float glyph; // 글자 번호
+        };
+
+        GLuint shader = 0;
+
+        GLuint textureId = 0;
+
+        GLuint vao = 0;
+        GLuint vbo = 0;
+
+        int uniformProjection = 0;
+        int uniformOrigin     = 0;
+        int uniformTextColor  = 0;
+
+        // 글자별 정보
+        std::array<int8_t, 128> indexOf{};  // ASCII -> 글자 번호. 없으면 -1
+        std::vector<float>      advance;    // 글자별 다음 글자까지 거리
+        float                   spaceAdvance = 0; // 없는 글자는 공백으로
+
+        int lineHeight = 0;
+
+        // 이번에 쓰는 것, 올려둔 것
+        std::array<Instance, DYNAMIC_TEXT_MAX_GLYPHS> writing{};
+        std::array<Instance, DYNAMIC_TEXT_MAX_GLYPHS> uploaded{};
+        size_t writingCount  = 0;
+        size_t uploadedCount = 0;
+        float  pen = 0;
+
+        v::Size2f size = 0;    // 올려둔 글씨 크기
+        uint64_t  version = 0; // 내용이 바뀔 때 마다 증가
+        bool      dirty = false;
+
+        // 셰이더에 ortho 매트릭스 넘겨야 하는데, 윈도우 크기 달라지면 한번만 업데이트
+        std::mutex matrixOrthoLock;
+        glm::mat4  matrixOrtho = glm::mat4(0);
+        v::Size2f  matrixOrthoSize = -1;
+
+        void putGlyph(char c)
+        {
+            const auto code = static_cast<unsigned char>(c);
+            const int index = code < this->indexOf.size() ? this->indexOf[code] : -1;
+
+            if (index < 0)
+            {
+                this->pen += this->spaceAdvance;
+                return;
+            }
+            if (this->writingCount == this->writing.size()) return;
+
+            this->writing[this->writingCount++] = Instance{ this->pen, 0, static_cast<float>(index) };
+            this->pen += this->advance[index];
+        }
+
+    public:
+        v::Size2f getSize()
+        {
+            return this->size;
+        }
+
+        uint64_t getVersion()
+        {
+            return this->version;
+        }
+
+        // alphabet 글자들을 size 크기로 텍스쳐 하나에 모아둠
+        void init(int size, const char* alphabet)
+        {
+            auto& text = Text::instance();
+
+            this->lineHeight = text.lineHeight(size);
+
+            // 글자 그리기. 세로 위치는 Text 와 같게 'H' 기준
+            const auto chH = text.rasterize(size, 'H');
+            this->spaceAdvance = static_cast<float>(text.rasterize(size, ' ').advance >> 6);
+
+            std::vector<Text::Raster> rasters;
+            this->indexOf.fill(-1);
+            for (auto p = alphabet; *p != 0; p++)
+            {
+                const auto code = static_cast<unsigned char>(*p);
+                if (code >= this->indexOf.size() || this->indexOf[code] >= 0) continue;
+                if (rasters.size() == DYNAMIC_TEXT_MAX_ALPHABET)
+                    throw std::runtime_error("Too many glyphs for dynamic text. alphabet: " + std::string(alphabet));
+
+                this->indexOf[code] = static_cast<int8_t>(rasters.size());
+                rasters.push_back(text.rasterize(size, *p));
+            }
+
+            // 가로로 한 줄에 늘어놓음
+            int atlasW = 0, atlasH = 1;
+            for (const auto& r : rasters)
+            {
+                atlasW += r.bitmapSize.w + 1;
+                atlasH = std::max(atlasH, r.bitmapSize.h);
+            }
+            atlasW = std::max(atlasW, 1);
+
+            std::vector<unsigned char> pixels(static_cast<size_t>(atlasW) * atlasH, 0);
+
+            // 글자 사각형 (위치 x, y, 크기 w, h), 텍스쳐 좌표 (u0, v0, u1, v1)
+            std::array<glm::vec4, DYNAMIC_TEXT_MAX_ALPHABET> rects{};
+            std::array<glm::vec4, DYNAMIC_TEXT_MAX_ALPHABET> uvs{};
+
+            this->advance.clear();
+
+            int x = 0;
+            for (size_t i = 0; i < rasters.size(); i++)
+            {
+                const auto& r = rasters[i];
+
+                for (int y = 0; y < r.bitmapSize.h; y++)
+                {
+                    std::copy_n(
+                        r.pixels.data() + static_cast<size_t>(y) * r.bitmapSize.w,
+                        r.bitmapSize.w,
+                        pixels.data() + static_cast<size_t>(y) * atlasW + x
+                    );
+                }
+
+                rects[i] = glm::vec4(
+                    static_cast<float>(r.bearing.x),
+                    static_cast<float>(chH.bearing.y - r.bearing.y),
+                    static_cast<float>(r.bitmapSize.w),
+                    static_cast<float>(r.bitmapSize.h)
+                );
+                uvs[i] = glm::vec4(
+                    static_cast<float>(x) / atlasW,
+                    0.0f,
+                    static_cast<float>(x + r.bitmapSize.w) / atlasW,
+                    static_cast<float>(r.bitmapSize.h) / atlasH
+                );
+
+                this->advance.push_back(static_cast<float>(r.advance >> 6));
+
+                x += r.bitmapSize.w + 1;
+            }
+
+            // 텍스쳐
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+            glGenTextures(1, &this->textureId);
+            glBindTexture(GL_TEXTURE_2D, this->textureId);
+            defer(glBindTexture(GL_TEXTURE_2D, 0));
+
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, atlasW, atlasH, 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+            glext::countUpload(pixels.size());
+
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+            // 셰이더. 글자 사각형은 한번만 넘김
+            this->shader = glext::loadShader(DYNAMIC_TEXT_SHADER);
+
+            glUseProgram(this->shader);
+            defer(glUseProgram(0));
+
+            glUniform1i(glGetUniformLocation(this->shader, "text"), 0);
+            glUniform4fv(glGetUniformLocation(this->shader, "glyphRect"), static_cast<GLsizei>(rects.size()), glm::value_ptr(rects[0]));
+            glUniform4fv(glGetUniformLocation(this->shader, "glyphUV"  ), static_cast<GLsizei>(uvs.size()),   glm::value_ptr(uvs[0]));
+
+            this->uniformProjection = glGetUniformLocation(this->shader, "projection");
+            this->uniformOrigin     = glGetUniformLocation(this->shader, "origin");
+            this->uniformTextColor  = glGetUniformLocation(this->shader, "textColor");
+
+            // 글자마다 하나씩 (instance)
+            glGenVertexArrays(1, &this->vao);
+            glBindVertexArray(this->vao);
+            defer(glBindVertexArray(0));
+
+            glGenBuffers(1, &this->vbo);
+            glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
+            defer(glBindBuffer(GL_ARRAY_BUFFER, 0));
+
+            glBufferData(GL_ARRAY_BUFFER, sizeof(this->uploaded), NULL, GL_DYNAMIC_DRAW);
+
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)0); glEnableVertexAttribArray(0);
+            glVertexAttribDivisor(0, 1);
+        }
+
+        // 새로 쓰기 시작
+        void begin()
+        {
+            this->writingCount = 0;
+            this->pen = 0;
+        }
+
+        void put(char c)
+        {
+            this->putGlyph(c);
+        }
+
+        void put(const char* str)
+        {
+            for (auto p = str; *p != 0; p++) this->putGlyph(*p);
+        }
+
+        // 정수. width 보다 짧으면 앞에 0 을 채움
+        void put(int64_t value, int width = 0)
+        {
+            if (value < 0)
+            {
+                this->putGlyph('-');
+                value = -value;
+            }
+
+            std::array<char, 20> digits;
+            int n = 0;
+            do
+            {
+                digits[n++] = static_cast<char>('0' + value % 10);
+                value /= 10;
+            } while (value > 0 && n < static_cast<int>(digits.size()));
+
+            for (int i = n; i < width; i++) this->putGlyph('0');
+            while (n > 0) this->putGlyph(digits[--n]);
+        }
+        void put(int value, int width = 0)
+        {
+            this->put(static_cast<int64_t>(value), width);
+        }
+
+        // 소수점 아래 decimals 자리까지 반올림
+        void put(double value, int decimals)
+        {
+            if (!std::isfinite(value))
+            {
+                this->put("-");
+                return;
+            }
+
+            int64_t scale = 1;
+            for (int i = 0; i < decimals; i++) scale *= 10;
+
+            auto scaled = static_cast<int64_t>(std::llround(std::abs(value) * scale));
+            if (value < 0 && scaled != 0) this->putGlyph('-');
+
+            this->put(scaled / scale);
+            if (decimals > 0)
+            {
+                this->putGlyph('.');
+                this->put(scaled % scale, decimals);
+            }
+        }
+
+        // 다 썼음. 지난번과 같으면 아무것도 하지 않음
+        void end()
+        {
+            const bool same =
+                this->writingCount == this->uploadedCount &&
+                std::equal(
+                    this->writing.begin(), this->writing.begin() + this->writingCount, this->uploaded.begin(),
+                    [](const Instance& a, const Instance& b) { return a.x == b.x && a.y == b.y && a.glyph == b.glyph; }
+                );
+            if (same) return;
+
+            std::copy_n(this->writing.begin(), this->writingCount, this->uploaded.begin());
+            this->uploadedCount = this->writingCount;
+
+            this->size = v::Size2f(this->pen, static_cast<float>(this->lineHeight));
+            this->version++;
+            this->dirty = true;
+        }
+
+        // location 은 글씨 왼쪽 위
+        void draw(v::Size2f windowSize, v::Point2f location, v::Color color)
+        {
+            if (this->uploadedCount == 0) return;
+
+            glUseProgram(this->shader);
+            defer(glUseProgram(0));
+
+            // 매트릭스 업데이트
+            {
+                std::lock_guard<std::mutex> _lock(this->matrixOrthoLock);
+                if (this->matrixOrthoSize != windowSize)
+                {
+                    this->matrixOrthoSize = windowSize;
+
+                    this->matrixOrtho = glm::ortho(0.0f, windowSize.w, windowSize.h, 0.0f);
+                }
+
+                glUniformMatrix4fv(this->uniformProjection, 1, GL_FALSE, glm::value_ptr(this->matrixOrtho));
+            }
+
+            glUniform2f(this->uniformOrigin, location.x, location.y);
+            glUniform4fv(this->uniformTextColor, 1, color);
+
+            glBindVertexArray(this->vao);
+            defer(glBindVertexArray(0));
+
+            // 바뀐 경우에만 올림
+            if (this->dirty)
+            {
+                glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
+                glBufferSubData(GL_ARRAY_BUFFER, 0, this->uploadedCount * sizeof(Instance), this->uploaded.data());
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+                glext::countUpload(this->uploadedCount * sizeof(Instance));
+
+                this->dirty = false;
+            }
+
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, this->textureId);
+            defer(glBindTexture(GL_TEXTURE_2D, 0));
+
+            // 글자마다 사각형 하나 (triangle strip 4개)
+            glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(this->uploadedCount));
+            glext::countDraw();
+        }
+    };
+}
@@ -0,0 +1,297 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "constants.h"
+#include "model_dynamic_text.h"
+#include "model_renderbuffer.h"
+#include "model_sprite.h"
+#include "model_text.h"
+#include "v.h"
+
+namespace model
+{
+    // 화면 위에 쓰는 글씨들 (날자, 속도, fps, 도움말 ...) 을 화면 크기의 레이어 하나에 모아두고 그리는 모델
+    // 프레임마다 위젯 내용을 넘겨주면 지난 프레임과 달라진 위젯만 레이어에 다시 쓰고, 화면에는 레이어를 사각형 하나로 그린다.
+    //
+    //   hud.begin(screen);
+    //   hud.text(WidgetDate, ...);
+    //   hud.end(); // 바뀐 위젯만 다시 쓰고 레이어 그리기
+    class Hud
+    {
+    private:
+        struct Widget
+        {
+            bool submitted = false; // 이번 프레임에 넘겨받음
+            bool visible   = false; // 레이어에 그려져 있음
+            bool changed   = false; // 내용이 바뀌어서 다시 써야 함
+
+            int sprite = -1; // 아틀라스에 그려둔 그림 번호. 없으면 글씨
+
+            DynamicText* dynamic = nullptr; // 숫자 글씨. 없으면 글씨
+            uint64_t     dynamicVersion = 0;
+
+            std::string  str;
+            std::wstring wstr;
+            bool         wide  = false;
+            int          size  = 0;
+            v::Color     color = 0;
+            v::Size2f    measured = 0; // 글씨 크기. 내용이 바뀔 때만 다시 잼
+
+            v::Rect2f area = 0;                 // 정렬 기준 영역
+            Alignment horizontal = Alignment::Near;
+            Alignment vertical   = Alignment::Near;
+
+            v::Rect2f rect      = 0; // 이번 프레임에 그릴 영역
+            v::Rect2f drawnRect = 0; // 레이어에 그려져 있는 영역
+        };
+
+        RenderBuffer layer;
+        SpriteAtlas* atlas = nullptr; // 그림 위젯이 쓰는 아틀라스
+        bool         layerReady   = false;
+        bool         layerCleared = false; // 크기가 바뀌어서 전부 다시 써야 함
+
+        v::Size2f screen = 0;
+
+        std::vector<Widget>    widgets;
+        std::vector<v::Rect2f> dirty;
+
+        Widget& get(int id)
+        {
+            if (static_cast<size_t>(id) >= this->widgets.size())
+            {
+                this->widgets.resize(id + 1);
+            }
+            return this->widgets[id];
+        }
+
+        // 위젯 위치 설정. 위치나 정렬이 바뀌었으면 다시 써야 함
+        void place(Widget& w, v::Rect2f area, Alignment horizontal, Alignment vertical, v::Size2f size)
+        {
+            const auto rect = RenderBuffer::align(area, size, horizontal, vertical);
+
+            if (!w.visible ||
+                w.drawnRect.x != rect.x || w.drawnRect.y != rect.y || w.drawnRect.w != rect.w || w.drawnRect.h != rect.h)
+            {
+                w.changed = true;
+            }
+
+            w.submitted  = true;
+            w.area       = area;
+            w.horizontal = horizontal;
+            w.vertical   = vertical;
+            w.rect       = rect;
+        }
+
+        static bool intersects(const v::Rect2f& a, const v::Rect2f& b)
+        {
+            return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+        }
+
+        static v::Rect2f inflate(const v::Rect2f& r)
+        {
+            return v::Rect2f(
+                r.x - WINDOW_HUD_DIRTY_MARGIN,
+                r.y - WINDOW_HUD_DIRTY_MARGIN,
+                r.w + WINDOW_HUD_DIRTY_MARGIN * 2,
+                r.h + WINDOW_HUD_DIRTY_MARGIN * 2
+            );
+        }
+
+        void drawWidget(const Widget& w)
+        {
+            if (w.sprite >= 0)
+            {
+                // 그림은 모아뒀다가 한번에 그림
+                this->atlas->queue(w.sprite, w.area, w.horizontal, w.vertical);
+            }
+            else if (w.dynamic != nullptr)
+            {
+                w.dynamic->draw(this->screen, v::Point2f(w.rect.x, w.rect.y), w.color);
+            }
+            else if (w.wide)
+            {
+                Text::instance().draw(this->screen, w.area, w.horizontal, w.vertical, w.size, w.color, w.wstr);
+            }
+            else
+            {
+                Text::instance().draw(this->screen, w.area, w.horizontal, w.vertical, w.size, w.color, w.str);
+            }
+        }
+
+    public:
+        // 프레임 시작. 화면 크기가 바뀌었으면 레이어를 전부 다시 씀
+        void begin(v::Size2f screen)
+        {
+            if (this->screen != screen)
+            {
+                this->screen = screen;
+
+                const v::Size2i size(static_cast<int>(screen.w), static_cast<int>(screen.h));
+                if (!this->layerReady)
+                {
+                    this->layer.init(size);
+                    this->layerReady = true;
+                }
+                else
+                {
+                    this->layer.resize(size);
+                }
+
+                for (auto& w : this->widgets)
+                {
+                    w.visible = false;
+                }
+                this->layerCleared = true;
+            }
+
+            for (auto& w : this->widgets)
+            {
+                w.submitted = false;
+                w.changed   = false;
+            }
+        }
+
+        // 글씨 위젯. 그려질 영역을 반환 (Text::draw 와 같음)
+        v::Rect2f text(int id, v::Rect2f area, Alignment horizontal, Alignment vertical, int size, v::Color color, const char* str)
+        {
+            auto& w = this->get(id);
+            if (w.sprite >= 0 || w.dynamic != nullptr || w.wide || w.size != size || w.color != color || w.str != str)
+            {
+                w.sprite  = -1;
+                w.dynamic = nullptr;
+                w.wide    = false;
+                w.size   = size;
+                w.color  = color;
+                w.str    = str;
+
+                w.measured = Text::instance().measure(size, w.str);
+                w.changed  = true;
+            }
+
+            this->place(w, area, horizontal, vertical, w.measured);
+            return w.rect;
+        }
+
+        v::Rect2f text(int id, v::Rect2f area, Alignment horizontal, Alignment vertical, int size, v::Color color, const std::wstring& wstr)
+        {
+            auto& w = this->get(id);
+            if (w.sprite >= 0 || w.dynamic != nullptr || !w.wide || w.size != size || w.color != color || w.wstr != wstr)
+            {
+                w.sprite  = -1;
+                w.dynamic = nullptr;
+                w.wide    = true;
+                w.size   = size;
+                w.color  = color;
+                w.wstr   = wstr;
+
+                w.measured = Text::instance().measure(size, w.wstr);
+                w.changed  = true;
+            }
+
+            this->place(w, area, horizontal, vertical, w.measured);
+            return w.rect;
+        }
+
+        // 아틀라스에 그려둔 그림 위젯
+        v::Rect2f sprite(int id, v::Rect2f area, Alignment horizontal, Alignment vertical, SpriteAtlas& atlas, int sprite)
+        {
+            auto& w = this->get(id);
+            if (w.sprite != sprite || w.dynamic != nullptr)
+            {
+                w.sprite  = sprite;
+                w.dynamic = nullptr;
+                w.changed = true;
+            }
+            this->atlas = &atlas;
+
+            this->place(w, area, horizontal, vertical, atlas.getSize(sprite));
+            return w.rect;
+        }
+
+        // 숫자 글씨 위젯. 글씨는 미리 begin ~ end 로 써둠
+        v::Rect2f dynamic(int id, v::Rect2f area, Alignment horizontal, Alignment vertical, v::Color color, DynamicText& text)
+        {
+            auto& w = this->get(id);
+            if (w.dynamic != &text || w.dynamicVersion != text.getVersion() || w.color != color)
+            {
+                w.sprite         = -1;
+                w.dynamic        = &text;
+                w.dynamicVersion = text.getVersion();
+                w.color          = color;
+                w.changed        = true;
+            }
+
+            this->place(w, area, horizontal, vertical, text.getSize());
+            return w.rect;
+        }
+
+        // 바뀐 위젯만 레이어에 다시 쓰고 화면에 레이어를 그림
+        void end()
+        {
+            // 다시 쓸 영역. 사라진 위젯은 지난 영역, 바뀐 위젯은 지난 영역과 새 영역
+            this->dirty.clear();
+            if (this->layerCleared)
+            {
+                this->dirty.emplace_back(0.0f, 0.0f, this->screen.w, this->screen.h);
+                this->layerCleared = false;
+            }
+            for (auto& w : this->widgets)
+            {
+                const bool show = w.submitted;
+                if (w.visible && (!show || w.changed))
+                {
+                    this->dirty.push_back(inflate(w.drawnRect));
+                }
+                if (show && (!w.visible || w.changed))
+                {
+                    this->dirty.push_back(inflate(w.rect));
+                }
+            }
+
+            if (!this->dirty.empty())
+            {
+                this->layer.drawStart(this->dirty);
+
+                // 지운 영역에 걸친 위젯은 바뀌지 않았어도 다시 씀
+                for (const auto& w : this->widgets)
+                {
+                    if (!w.submitted) continue;
+
+                    for (const auto& d : this->dirty)
+                    {
+                        if (intersects(inflate(w.rect), d))
+                        {
+                            this->drawWidget(w);
+                            break;
+                        }
+                    }
+                }
+                if (this->atlas != nullptr)
+                {
+                    this->atlas->flush(this->screen);
+                }
+
+                this->layer.drawEnd();
+
+                glViewport(0, 0, static_cast<GLsizei>(this->screen.w), static_cast<GLsizei>(this->screen.h));
+            }
+
+            for (auto& w : this->widgets)
+            {
+                w.visible   = w.submitted;
+                w.drawnRect = w.rect;
+            }
+
+            this->layer.draw(
+                this->screen,
+                v::Rect2f(0, 0, this->screen.w, this->screen.h),
+                Alignment::Near,
+                Alignment::Near
+            );
+        }
+    };
+}
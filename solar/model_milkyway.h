@@ -26,7 +26,8 @@ namespace model
         GLuint textureId = 0;
 
         // 버텍스 갯수
-        int indicesCount = 0;
+        int    indicesCount = 0;
+        GLenum indexType    = GL_UNSIGNED_INT;
 
         // 셰이더 데이터
         GLuint vao = 0;
@@ -49,40 +50,31 @@ namespace model
 
             glext::dispatch([&]() {
                 // 버텍스 생성하기
-                std::vector<GLfloat> vertices;;
-                std::vector<GLuint> indices;
+                SphereMesh mesh;
                 initSphere(
-                    MILKYWAY_MODEL_RADIUS,
                     MILKYWAY_MODEL_STACKS,
                     MILKYWAY_MODEL_SLICES,
-                    vertices,
-                    indices,
-                    false
+                    mesh
                 );
 
-                this->indicesCount = indices.size();
+                this->indicesCount = mesh.indices.size();
 
                 // VertexArray 생성
                 glGenVertexArrays(1, &this->vao);
                 glBindVertexArray(this->vao); defer(glBindVertexArray(0));
 
-                // 버텍스 저장
-                glGenBuffers(1, &this->vbo);
-                glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
-                glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
-
-                // 인덱스 저장
-                glGenBuffers(1, &this->ebo);
-                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ebo);
-                glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
-
-                // attri 사용 설정
-                glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(0 * sizeof(float))); glEnableVertexAttribArray(0);
-                glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float))); glEnableVertexAttribArray(1);
+                // 버텍스, 인덱스 저장
+                this->indexType = uploadSphere(mesh, this->vbo, this->ebo, true);
 
                 this->uniformProjectionMatrix  = glGetUniformLocation(this->shader, "projectionMatrix");
                 this->uniformViewMatrix        = glGetUniformLocation(this->shader, "viewMatrix"      );
                 this->uniformTexture           = glGetUniformLocation(this->shader, "shaderTexture"   );
+
+                // 셰이더 설정
+                glUseProgram(this->shader);
+                defer(glUseProgram(0));
+
+                glUniform1f(glGetUniformLocation(this->shader, "radius"), MILKYWAY_MODEL_RADIUS);
             });
         }
 
@@ -113,7 +105,8 @@ namespace model
             glEnableVertexAttribArray(1);
 
             // 렌더링
-            glDrawElements(GL_TRIANGLES, this->indicesCount, GL_UNSIGNED_INT, nullptr);
+            glDrawElements(GL_TRIANGLES, this->indicesCount, this->indexType, nullptr);
+            glext::countDraw();
         }
     };
 }
@@ -0,0 +1,130 @@
+﻿#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/mat4x4.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "constants.h"
+#include "defer.h"
+#include "glext.h"
+#include "minorbody.h"
+
+namespace model
+{
+    // 소행성대, 카이퍼 벨트 점 구름
+    // 천체별 궤도 요소만 올려두고 위치 계산은 버텍스 셰이더에서 한다. 매 프레임 CPU 에서는 하는 일 없음.
+    class MinorBodies
+    {
+    private:
+        // 셰이더
+        GLuint shader = 0;
+
+        // 셰이더 데이터
+        // 항목별로 나누어 저장 (SoA) : a a a ... | e e e ... | ...
+        GLuint vao = 0;
+        GLuint vbo = 0;
+
+        // 천체 수
+        GLsizei count = 0;
+
+        // 셰이더에 넘겨줄 값들
+        // 셰이더 참조.
+        GLuint uniformProjectionMatrix = 0;
+        GLuint uniformViewMatrix       = 0;
+        GLuint uniformModelMatrix      = 0;
+        GLuint uniformDays             = 0;
+
+    public:
+        // model 초기화. 데이터가 없으면 아무것도 안 함.
+        void init()
+        {
+            minorbody::Elements elements;
+            if (!minorbody::load(elements)) return;
+
+            this->shader = glext::loadShader(MINORBODY_SHADER);
+
+            this->count = static_cast<GLsizei>(elements.size());
+
+            glext::dispatch([&]() {
+                // VertexArray 생성
+                glGenVertexArrays(1, &this->vao);
+                glBindVertexArray(this->vao); defer(glBindVertexArray(0));
+
+                // 버텍스 저장
+                const GLsizeiptr columnSize = this->count * sizeof(GLfloat);
+
+                glGenBuffers(1, &this->vbo);
+                glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
+                defer(glBindBuffer(GL_ARRAY_BUFFER, 0));
+
+                glBufferData(GL_ARRAY_BUFFER, columnSize * minorbody::ELEMENTS_COLUMNS, nullptr, GL_STATIC_DRAW);
+
+                // attri 사용 설정. 항목 하나당 attribute 하나
+                for (int c = 0; c < minorbody::ELEMENTS_COLUMNS; c++)
+                {
+                    glBufferSubData(GL_ARRAY_BUFFER, columnSize * c, columnSize, minorbody::column(elements, c).data());
+                    glext::countUpload(columnSize);
+
+                    glVertexAttribPointer(c, 1, GL_FLOAT, GL_FALSE, sizeof(GLfloat), (void*)(columnSize * c)); glEnableVertexAttribArray(c);
+                }
+
+                // 셰이더 설정
+                glUseProgram(this->shader);
+                defer(glUseProgram(0));
+
+                this->uniformProjectionMatrix = glGetUniformLocation(this->shader, "projectionMatrix");
+                this->uniformViewMatrix       = glGetUniformLocation(this->shader, "viewMatrix"      );
+                this->uniformModelMatrix      = glGetUniformLocation(this->shader, "modelMatrix"     );
+                this->uniformDays             = glGetUniformLocation(this->shader, "days"            );
+
+                glUniform1f (glGetUniformLocation(this->shader, "auScale"      ), static_cast<float>(au2unit(1)));
+                glUniform1f (glGetUniformLocation(this->shader, "pointSize"    ), MINORBODY_POINT_SIZE);
+                glUniform2f (glGetUniformLocation(this->shader, "magnitude"    ), MINORBODY_MAGNITUDE_BRIGHT, MINORBODY_MAGNITUDE_FAINT);
+                glUniform2f (glGetUniformLocation(this->shader, "alpha"        ), MINORBODY_ALPHA_MIN, MINORBODY_ALPHA_MAX);
+                glUniform2f (glGetUniformLocation(this->shader, "beltDistance" ), MINORBODY_INNER_AU, MINORBODY_OUTER_AU);
+                glUniform4fv(glGetUniformLocation(this->shader, "colorInner"   ), 1, MINORBODY_COLOR_INNER.raw);
+                glUniform4fv(glGetUniformLocation(this->shader, "colorOuter"   ), 1, MINORBODY_COLOR_OUTER.raw);
+            });
+        }
+
+        bool loaded() const noexcept
+        {
+            return this->count > 0;
+        }
+
+        // 렌더링
+        // modelMatrix : 태양 위치, days : J2000 기준 일 수
+        void draw(
+            const glm::mat4 projectionMatrix,
+            const glm::mat4 viewMatrix,
+            const glm::mat4 modelMatrix,
+            const double days
+        )
+        {
+            if (!this->loaded()) return;
+
+            // 셰이더 설정
+            glUseProgram(this->shader);
+            defer(glUseProgram(0));
+
+            // uniform 입력 정보 업데이트
+            glUniformMatrix4fv(this->uniformProjectionMatrix, 1, GL_FALSE, glm::value_ptr(projectionMatrix));
+            glUniformMatrix4fv(this->uniformViewMatrix,       1, GL_FALSE, glm::value_ptr(viewMatrix      ));
+            glUniformMatrix4fv(this->uniformModelMatrix,      1, GL_FALSE, glm::value_ptr(modelMatrix     ));
+            glUniform1f(this->uniformDays, static_cast<float>(days));
+
+            // 반투명한 점이라 깊이는 쓰지 않음
+            glDepthMask(GL_FALSE);
+            defer(glDepthMask(GL_TRUE));
+
+            // 버텍스 어레이 설정
+            glBindVertexArray(this->vao);
+            defer(glBindVertexArray(0));
+
+            glDrawArrays(GL_POINTS, 0, this->count);
+            glext::countDraw();
+        }
+    };
+}
@@ -1,5 +1,8 @@
 ﻿#pragma once
 
+#include <algorithm>
+#include <vector>
+
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
@@ -14,117 +17,202 @@
 namespace model
 {
     // 궤도 그리는 모델
-    class Orbit
+    // 모든 궤도를 하나의 버텍스 버퍼에 담아두고, 궤도별 정보는 UBO 로 넘겨서 glMultiDrawArrays 한번으로 그린다.
+    class Orbits
     {
+    public:
+        // 궤도 하나당 셰이더에 넘겨줄 정보.
+        // orbit.vert 의 OrbitInfo 와 std140 레이아웃을 맞춰야 함.
+        struct Instance
+        {
+            glm::mat4 modelMatrix;     // 부모 행성의 위치
+            float     color[4];        // 궤도 색
+            float     angleCurrent[4]; // x : 현재 진근점이각. -1 이면 그라디언트 사용 안 함.
+        };
+
     private:
+        // 궤도 종류별로 버퍼 내의 위치
+        struct Range
+        {
+            std::vector<GLint>   first; // 시작 버텍스
+            std::vector<GLsizei> count; // 버텍스 갯수
+        };
+
         // 셰이더
         GLuint shader = 0;
 
-        // 셰이더 데이터
-        GLuint vaoSolid = 0;
-        GLuint vboSolid = 0;
-
-        GLuint vaoDotted = 0;
-        GLuint vboDotted = 0;
+        // 셰이더 데이터. 실선, 점선 모두 하나의 버퍼에 들어있음.
+        GLuint vao = 0;
+        GLuint vbo = 0;
+        GLuint ubo = 0;
 
         // 셰이더에 넘겨줄 값들
         // 셰이더 참조.
         GLuint uniformProjectionMatrix = 0;
         GLuint uniformViewMatrix       = 0;
-        GLuint uniformModelMatrix      = 0;
 
-        GLuint uniformAngleCurrent = 0;
-        GLuint uniformColor = 0;
+        // 버텍스 데이터. 업로드 후 비움
+        // X Y Z ANGLE SLOT | X Y Z ANGLE SLOT | ...
+        std::vector<GLfloat> vertices;
 
-        v::Color planetColor = 0;
+        Range rangeSolid;  // 실선 궤도
+        Range rangeDotted; // 점선 궤도
 
-        // 현재 정보들...
-        int verticesCountSolid = 0; // 버텍스 갯수
-        int verticesCountDotted = 0; // 버텍스 갯수
+        std::vector<int>      planets;     // 궤도 순서 -> 행성 index
+        std::vector<int>      slots;       // 행성 index -> 궤도 순서
+        std::vector<v::Color> colors;      // 궤도 고유 색
+        std::vector<Instance> instances;   // 매 프레임 UBO 로 올라가는 값
 
-        int generate(const planet::Planet& planet, float step, GLuint* vao, GLuint* vbo)
+        // 궤도 하나 버텍스 생성.
+        void generate(const planet::Planet& planet, float step, int slot, Range& range)
         {
-            int verticesCount = 0;
+            range.first.push_back(static_cast<GLint>(this->vertices.size() / ORBIT_VERTEX_STRIDE));
 
-            std::vector<GLfloat> vertices;
+            GLsizei verticesCount = 0;
+            for (float day = 0; day <= planet.resolutionPeriod(); day += step)
             {
-                // 미리 어느정도 할당
-                vertices.reserve(300 * 7);
+                verticesCount++;
+                const auto pos = orbital::getCurrentPosition(planet._index, day);
 
-                for (float day = 0; day <= planet._resolutionPeriod; day += step)
-                {
-                    verticesCount++;
-                    const auto pos = orbital::getCurrentPosition(planet._index, day);
-
-                    // 버텍스
-                    vertices.push_back(pos.x);
-                    vertices.push_back(pos.y);
-                    vertices.push_back(pos.z);
-                    vertices.push_back(pos.w);
-                }
+                // 버텍스
+                this->vertices.push_back(pos.x);
+                this->vertices.push_back(pos.y);
+                this->vertices.push_back(pos.z);
+                this->vertices.push_back(pos.w);
+
+                // UBO 내의 위치
+                this->vertices.push_back(static_cast<GLfloat>(slot % ORBIT_BATCH_SIZE));
+            }
+
+            range.count.push_back(verticesCount);
+        }
+
+        // 궤도 종류 하나를 배치 단위로 렌더링
+        void drawRange(GLenum mode, const Range& range)
+        {
+            for (size_t start = 0; start < this->planets.size(); start += ORBIT_BATCH_SIZE)
+            {
+                const auto count = std::min<size_t>(ORBIT_BATCH_SIZE, this->planets.size() - start);
+
+                // 이번 배치에 해당하는 궤도 정보 올리기
+                glBufferSubData(GL_UNIFORM_BUFFER, 0, count * sizeof(Instance), &this->instances.at(start));
+                glext::countUpload(count * sizeof(Instance));
+
+                glMultiDrawArrays(mode, &range.first.at(start), &range.count.at(start), static_cast<GLsizei>(count));
+                glext::countDraw();
+            }
+        }
+
+    public:
+        // 궤도 하나 추가. 버텍스 데이터만 만들어 둔다.
+        void add(const planet::Planet& planet)
+        {
+            // 공전하지 않는 천체는 없음
+            if (planet.parentIndex() == -1) return;
+
+            const int slot = static_cast<int>(this->planets.size());
+
+            if (this->slots.size() <= static_cast<size_t>(planet._index))
+            {
+                this->slots.resize(planet._index + 1, -1);
             }
+            this->slots.at(planet._index) = slot;
+
+            this->planets.push_back(planet._index);
+            this->colors.push_back(planet.color());
+
+            // 버텍스 생성
+            // 선이랑 점이랑 단위가 다르므로 따로 만들어두기.
+            this->generate(planet, ORBIT_SOLID_DAY_PER_VERTEX,  slot, this->rangeSolid );
+            this->generate(planet, ORBIT_DOTTED_DAY_PER_VERTEX, slot, this->rangeDotted);
+        }
+
+        // 초기화. add 로 추가한 궤도들을 한번에 올린다.
+        void init()
+        {
+            this->shader = glext::loadShader(ORBIT_SHADER);
+
+            this->instances.resize(this->planets.size());
 
             glext::dispatch([&]() {
                 // 버텍스 생성하기
-                glGenVertexArrays(1, vao);
+                glGenVertexArrays(1, &this->vao);
 
-                glBindVertexArray(*vao);
+                glBindVertexArray(this->vao);
                 defer(glBindVertexArray(0));
 
-                glGenBuffers(1, vbo);
-                glBindBuffer(GL_ARRAY_BUFFER, *vbo);
+                glGenBuffers(1, &this->vbo);
+                glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
                 defer(glBindBuffer(GL_ARRAY_BUFFER, 0));
 
                 // 할당
-                glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_DYNAMIC_DRAW);
+                glBufferData(GL_ARRAY_BUFFER, this->vertices.size() * sizeof(GLfloat), this->vertices.data(), GL_STATIC_DRAW);
+                glext::countUpload(this->vertices.size() * sizeof(GLfloat));
 
                 // attri 사용 설정
-                glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0); glEnableVertexAttribArray(0);
-            });
+                glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, ORBIT_VERTEX_STRIDE * sizeof(float), (void*)(0 * sizeof(float))); glEnableVertexAttribArray(0);
+                glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, ORBIT_VERTEX_STRIDE * sizeof(float), (void*)(4 * sizeof(float))); glEnableVertexAttribArray(1);
 
-            return verticesCount;
-        }
+                // 궤도별 정보 담을 UBO
+                glGenBuffers(1, &this->ubo);
+                glBindBuffer(GL_UNIFORM_BUFFER, this->ubo);
+                defer(glBindBuffer(GL_UNIFORM_BUFFER, 0));
 
-    public:
-        // 초기화
-        void init(const planet::Planet& planet)
-        {
-            // 태양은 없음
-            if (planet._index == planet::PlanetIndex::Sun) return;
+                glBufferData(GL_UNIFORM_BUFFER, ORBIT_BATCH_SIZE * sizeof(Instance), nullptr, GL_DYNAMIC_DRAW);
 
-            this->planetColor = planet._color;
+                // 셰이더 설정
+                glUseProgram(this->shader);
+                defer(glUseProgram(0));
 
-            this->shader = glext::loadShader(ORBIT_SHADER);
+                glUniformBlockBinding(this->shader, glGetUniformBlockIndex(this->shader, "OrbitBlock"), ORBIT_UBO_BINDING);
 
-            // 버텍스 생성
-            // 선이랑 점이랑 단위가 다르므로 따로 만들어두기.
-            this->verticesCountDotted = this->generate(planet, ORBIT_DOTTED_DAY_PER_VERTEX, &this->vaoDotted, &this->vboDotted);
-            this->verticesCountSolid  = this->generate(planet, ORBIT_SOLID_DAY_PER_VERTEX,  &this->vaoSolid,  &this->vboSolid );
+                this->uniformProjectionMatrix = glGetUniformLocation(this->shader, "projectionMatrix");
+                this->uniformViewMatrix       = glGetUniformLocation(this->shader, "viewMatrix"      );
 
-            this->uniformProjectionMatrix = glGetUniformLocation(this->shader, "projectionMatrix");
-            this->uniformViewMatrix       = glGetUniformLocation(this->shader, "viewMatrix"      );
-            this->uniformModelMatrix      = glGetUniformLocation(this->shader, "modelMatrix"     );
+                glUniform1f(glGetUniformLocation(this->shader, "angleVisible"), ORBIT_GRADIENT_START_ANGLE);
+                glUniform1f(glGetUniformLocation(this->shader, "alphaGradient"), ORBIT_GRADIENT_ALPHA_MAX);
+            });
 
-            this->uniformAngleCurrent = glGetUniformLocation(this->shader, "angleCurrent");
-            this->uniformColor        = glGetUniformLocation(this->shader, "color");
+            // 올렸으니 메모리 해제
+            std::vector<GLfloat>().swap(this->vertices);
+        }
 
-            // 셰이더 설정
-            glUseProgram(this->shader);
-            defer(glUseProgram(0));
+        // 궤도 위치 정보 갱신. 부모 행성의 위치랑 행성의 현재 진근점이각
+        void update(int planetIndex, const glm::mat4& modelMatrix, float angle)
+        {
+            if (planetIndex < 0 || static_cast<size_t>(planetIndex) >= this->slots.size()) return;
+
+            const auto slot = this->slots.at(planetIndex);
+            if (slot == -1) return;
 
-            glUniform1f(glGetUniformLocation(this->shader, "angleVisible"), ORBIT_GRADIENT_START_ANGLE);
-            glUniform1f(glGetUniformLocation(this->shader, "alphaGradient"), ORBIT_GRADIENT_ALPHA_MAX);
+            auto& instance = this->instances.at(slot);
+            instance.modelMatrix     = modelMatrix;
+            instance.angleCurrent[0] = angle;
         }
 
         // 렌더링
         void draw(
             const glm::mat4 projectionMatrix,
             const glm::mat4 viewMatrix,
-            const glm::mat4 modelMatrix,
-            const config::Config cfg,
-            const float angle
+            const config::Config cfg
         )
         {
+            if (this->planets.empty()) return;
+
+            // 설정값 반영
+            for (size_t i = 0; i < this->instances.size(); i++)
+            {
+                auto& instance = this->instances.at(i);
+
+                const v::Color color = cfg.showOrbitColored ? this->colors.at(i) : ORBIT_COLOR;
+                std::copy(std::begin(color.raw), std::end(color.raw), std::begin(instance.color));
+
+                if (!cfg.showOrbitGradient)
+                {
+                    instance.angleCurrent[0] = -1;
+                }
+            }
+
             // 셰이더 설정
             glUseProgram(this->shader);
             defer(glUseProgram(0));
@@ -132,37 +220,28 @@ namespace model
             // uniform 입력 정보 업데이트
             glUniformMatrix4fv(this->uniformProjectionMatrix, 1, GL_FALSE, glm::value_ptr(projectionMatrix));
             glUniformMatrix4fv(this->uniformViewMatrix,       1, GL_FALSE, glm::value_ptr(viewMatrix      ));
-            glUniformMatrix4fv(this->uniformModelMatrix,      1, GL_FALSE, glm::value_ptr(modelMatrix     ));
 
-            glUniform1f(this->uniformAngleCurrent, cfg.showOrbitGradient ? angle : -1);
-            
-            glUniform4fv(this->uniformColor, 1, cfg.showOrbitColored ? this->planetColor : ORBIT_COLOR);
+            // 궤도별 정보
+            glBindBuffer(GL_UNIFORM_BUFFER, this->ubo);
+            defer(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+
+            glBindBufferBase(GL_UNIFORM_BUFFER, ORBIT_UBO_BINDING, this->ubo);
+
+            // 버텍스 어레이 설정
+            glBindVertexArray(this->vao);
+            defer(glBindVertexArray(0));
 
             // 렌더링
             switch (cfg.showOrbitType)
             {
             case config::OrbitType::Dotted:
-            {
-                // 버텍스 어레이 설정
-                glBindVertexArray(this->vaoDotted);
-                defer(glBindVertexArray(0));
-
-                // 그리기
                 glPointSize(ORBIT_DOTTED_SIZE);
-                glDrawArrays(GL_POINTS, 0, this->verticesCountDotted);
-            }
+                this->drawRange(GL_POINTS, this->rangeDotted);
                 break;
 
             case config::OrbitType::Solid:
-            {
-                // 버텍스 어레이 설정
-                glBindVertexArray(this->vaoSolid);
-                defer(glBindVertexArray(0));
-
-                // 그리기
                 glLineWidth(ORBIT_SOLID_WIDTH);
-                glDrawArrays(GL_LINE_LOOP, 0, this->verticesCountSolid);
-            }
+                this->drawRange(GL_LINE_LOOP, this->rangeSolid);
                 break;
 
             default:
@@ -9,8 +9,9 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "defer.h"
-#include "model_utils.h"
+#include "model_planet_surface.h"
 #include "planet.h"
+#include "vtexture.h"
 
 namespace model
 {
@@ -26,13 +27,11 @@ namespace model
         GLuint textureIdNight = 0;
         GLuint textureIdCloud = 0;
 
-        // 버텍스 갯수
-        int indicesCount = 0;
+        // 큰 텍스쳐 (주간). 없으면 -1
+        int virtualId = -1;
 
-        // 셰이더 데이터
-        GLuint vao = 0;
-        GLuint vbo = 0;
-        GLuint ebo = 0;
+        // 표면
+        PlanetSurface surface;
 
         bool isEarth = false;
 
@@ -51,47 +50,26 @@ namespace model
         {
             this->shaderId = glext::loadShader(PLANET_MODEL_SHADER_NAME);
 
-            this->textureId = glext::loadTexture(planet._name);
+            // 큰 텍스쳐는 타일로 나눠서 필요한 부분만 올림
+            if (planet.hasMaterial(catalog::MaterialVirtual))
+            {
+                this->virtualId = vtexture::load(planet.texture());
+            }
+            else
+            {
+                this->textureId = glext::loadTexture(planet.texture());
+            }
 
-            if (planet._index == planet::PlanetIndex::Earth)
+            if (planet.hasMaterial(catalog::MaterialEarth))
             {
                 this->textureIdSpecular = glext::loadTexture(PLANET_EARTH_SPECULAR_TEXTURE);
                 this->textureIdNight    = glext::loadTexture(PLANET_EARTH_NIGHT_TEXTURE   );
                 this->textureIdCloud    = glext::loadTexture(PLANET_EARTH_CLOUD_TEXTURE   );
             }
 
-            // 버텍스 생성하기
+            // 표면 격자 생성하기
             glext::dispatch([&]() {
-                std::vector<GLfloat> vertices;
-                std::vector<GLuint> indices;
-                model::initSphere(
-                    planet._radius,
-                    PLANET_MODEL_SLICES_AND_STACKS,
-                    PLANET_MODEL_SLICES_AND_STACKS,
-                    vertices,
-                    indices,
-                    true);
-
-                this->indicesCount = indices.size();
-
-                // VertexArray 생성
-                glGenVertexArrays(1, &this->vao);
-                glBindVertexArray(this->vao); defer(glBindVertexArray(0));
-
-                // 버텍스 저장
-                glGenBuffers(1, &this->vbo);
-                glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
-                glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
-
-                // 인덱스 저장
-                glGenBuffers(1, &this->ebo);
-                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ebo);
-                glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
-
-                // attri 사용 설정
-                glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(0 * sizeof(float))); glEnableVertexAttribArray(0);
-                glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float))); glEnableVertexAttribArray(1);
-                glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float))); glEnableVertexAttribArray(2);
+                this->surface.init(this->shaderId, planet.radius());
 
                 // 셰이더에 들어갈 변수 아이디 얻기
                 this->uniformProjectionMatrix  = glGetUniformLocation(this->shaderId, "projectionMatrix");
@@ -107,8 +85,8 @@ namespace model
 
                 glUniform1i(glGetUniformLocation(this->shaderId, "shaderTexture"), 0);
 
-                // 고정 데이터 설정 -> 태양은 무시함
-                if (planet._index != planet::PlanetIndex::Sun)
+                // 고정 데이터 설정 -> 스스로 빛나는 천체는 무시함
+                if (!planet.hasMaterial(catalog::MaterialEmissive))
                 {
                     glUniform3fv(glGetUniformLocation(this->shaderId, "light.color"    ), 1, LIGHT_COLOR    );
                     glUniform1f (glGetUniformLocation(this->shaderId, "light.ambient"  ),    LIGHT_AMBIENT  );
@@ -119,7 +97,7 @@ namespace model
                 }
 
                 // 지구는...
-                if (planet._index == planet::PlanetIndex::Earth)
+                if (planet.hasMaterial(catalog::MaterialEarth))
                 {
                     isEarth = true;
 
@@ -131,6 +109,11 @@ namespace model
                     glUniform1i(glGetUniformLocation(this->shaderId, "shaderTextureNight"    ), 2);
                     glUniform1i(glGetUniformLocation(this->shaderId, "shaderTextureCloud"    ), 3);
                 }
+
+                if (this->virtualId >= 0)
+                {
+                    vtexture::setup(this->virtualId, this->shaderId, 4, 5);
+                }
             });
         }
 
@@ -140,9 +123,27 @@ namespace model
             const glm::mat4 viewMatrix,
             const glm::mat4 modelMatrix,
             const glm::vec3 lightPos,
-            const glm::vec3 cameraPos
+            const glm::vec3 cameraPos,
+            const float screenHeight
         )
         {
+            // 보이는 패치 고르기. 카메라 위치는 행성 로컬 좌표로
+            {
+                const auto modelView = viewMatrix * modelMatrix;
+                const glm::vec3 cameraLocal = glm::inverse(modelView) * glm::vec4(0, 0, 0, 1);
+
+                this->surface.update(
+                    projectionMatrix * modelView,
+                    cameraLocal,
+                    projectionMatrix[1][1] * screenHeight / 2
+                );
+            }
+
+            if (this->virtualId >= 0)
+            {
+                this->surface.request(this->virtualId);
+            }
+
             // 셰이더 설정
             glUseProgram(this->shaderId);
             defer(glUseProgram(0));
@@ -159,6 +160,11 @@ namespace model
                 glActiveTexture(GL_TEXTURE3); glBindTexture(GL_TEXTURE_2D, this->textureIdCloud);
             }
 
+            if (this->virtualId >= 0)
+            {
+                vtexture::bind(this->virtualId, 4, 5);
+            }
+
             // uniform 입력 정보 업데이트
             glUniformMatrix4fv(this->uniformProjectionMatrix, 1, GL_FALSE, glm::value_ptr(projectionMatrix));
             glUniformMatrix4fv(this->uniformViewMatrix,       1, GL_FALSE, glm::value_ptr(viewMatrix      ));
@@ -167,12 +173,8 @@ namespace model
             glUniform3fv(this->uniformLightPos,  1, glm::value_ptr(lightPos ));
             glUniform3fv(this->uniformCameraPos, 1, glm::value_ptr(cameraPos));
 
-            // 버텍스 어레이 설정
-            glBindVertexArray(this->vao);
-            defer(glBindVertexArray(0));
-
             // 렌더링
-            glDrawElements(GL_TRIANGLES, this->indicesCount, GL_UNSIGNED_INT, nullptr);
+            this->surface.draw();
 
             if (this->isEarth)
             {
@@ -183,6 +185,14 @@ namespace model
 
                 glActiveTexture(GL_TEXTURE0);
             }
+
+            if (this->virtualId >= 0)
+            {
+                glActiveTexture(GL_TEXTURE5); glBindTexture(GL_TEXTURE_2D, 0);
+                glActiveTexture(GL_TEXTURE4); glBindTexture(GL_TEXTURE_2D, 0);
+
+                glActiveTexture(GL_TEXTURE0);
+            }
         }
     };
 }
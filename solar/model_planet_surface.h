@@ -0,0 +1,348 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "constants.h"
+#include "defer.h"
+#include "glext.h"
+#include "model_utils.h"
+#include "vtexture.h"
+
+namespace model
+{
+    // 행성 표면. 정육면체 6면을 쿼드트리로 나눠서 구에 붙인다 (cube-sphere)
+    // 격자 한 칸이 화면에서 PLANET_LOD_PIXEL_ERROR 픽셀보다 크면 패치를 4개로 나누고,
+    // 지평선 너머나 화면 밖 패치는 그리지 않는다. 그래서 가까이 가도 그리는 양은 화면에 보이는 넓이만큼만 늘어난다.
+    //
+    // 패치는 모두 같은 격자를 쓰고, 위치 (면, x, y, 크기) 만 instance 로 넘겨서 한번에 그린다.
+    // 격자 둘레에는 아래로 내린 치마를 둘러서 깊이가 다른 패치 사이의 틈을 가린다.
+    //
+    //   surface.init(shader, radius);
+    //   surface.update(projection * view * model, cameraPos, pixelScale); // 보이는 패치 고르기
+    //   surface.request(virtualId); // 큰 텍스쳐를 쓰면 패치가 덮는 영역 요청
+    //   surface.draw();
+    class PlanetSurface
+    {
+    private:
+        // 격자 버텍스. ST (unorm16) 치마 (unorm16) _ (패딩)
+        struct GridVertex
+        {
+            GLushort s, t, skirt, w;
+        };
+
+        // 패치 하나 (instance). 면 번호, 면 안에서의 위치 x y (0 ~ 1), 크기
+        using Patch = glm::vec4;
+
+        GLuint vao = 0;
+        GLuint vboGrid = 0;
+        GLuint eboGrid = 0;
+        GLuint vboPatch = 0;
+
+        int    indicesCount = 0;
+        GLenum indexType    = GL_UNSIGNED_INT;
+
+        size_t patchCapacity = 0; // vboPatch 크기 (패치 개수)
+
+        std::vector<Patch> patches;      // 이번 프레임에 그릴 패치
+        std::vector<float> patchPixels;  // 패치별로 표면 1 라디안이 화면에서 몇 픽셀인지
+
+        // update 에서 쓰는 값들. 전부 행성 로컬 좌표
+        std::array<glm::vec4, 6> planes; // 시야 절두체
+        glm::vec3 camera    = glm::vec3(0);
+        glm::vec3 cameraDir = glm::vec3(0);
+        float     cameraDistance = 0;
+        float     horizon        = 0; // 카메라에서 보이는 가장 먼 곳까지의 각도 (행성 중심 기준)
+        float     pixelScale     = 0; // 거리 1 에서 길이 1 이 몇 픽셀인지
+
+        float radius = 0;
+
+        // 정육면체 면. 오른쪽, 위쪽, 바깥쪽. 오른쪽 x 위쪽 = 바깥쪽이라 반시계가 바깥을 향함
+        static constexpr float FACES[6][3][3] = {
+            { {  0, 0, -1 }, { 0, 1,  0 }, {  1,  0,  0 } }, // +X
+            { {  0, 0,  1 }, { 0, 1,  0 }, { -1,  0,  0 } }, // -X
+            { {  1, 0,  0 }, { 0, 0, -1 }, {  0,  1,  0 } }, // +Y
+            { {  1, 0,  0 }, { 0, 0,  1 }, {  0, -1,  0 } }, // -Y
+            { {  1, 0,  0 }, { 0, 1,  0 }, {  0,  0,  1 } }, // +Z
+            { { -1, 0,  0 }, { 0, 1,  0 }, {  0,  0, -1 } }, // -Z
+        };
+
+        // 면 위의 점 (0 ~ 1) 을 구 위의 방향으로. 셰이더와 같은 계산
+        // 그냥 정규화하면 면 가운데 칸이 커지므로 tan 으로 펴서 칸 크기를 비슷하게 맞춤
+        static glm::vec3 direction(int face, float x, float y)
+        {
+            const float a = std::tan((x * 2 - 1) * (PI / 4));
+            const float b = std::tan((y * 2 - 1) * (PI / 4));
+
+            const auto& f = FACES[face];
+            return glm::normalize(glm::vec3(
+                f[0][0] * a + f[1][0] * b + f[2][0],
+                f[0][1] * a + f[1][1] * b + f[2][1],
+                f[0][2] * a + f[1][2] * b + f[2][2]
+            ));
+        }
+
+        // 방향을 텍스쳐 좌표로. 셰이더 (planet.frag) 와 같은 계산
+        static glm::vec2 texCoords(const glm::vec3& d)
+        {
+            return glm::vec2(
+                std::atan2(d.x, d.z) / (2 * PI),
+                std::acos(std::clamp(d.y, -1.0f, 1.0f)) / PI
+            );
+        }
+
+        void select(int face, float x, float y, float size, int depth)
+        {
+            // 패치 가운데 방향과, 가운데에서 가장 먼 모서리까지의 각도
+            const auto center = direction(face, x + size / 2, y + size / 2);
+
+            float minDot = 1;
+            for (int corner = 0; corner < 4; corner++)
+            {
+                const auto d = direction(face, x + (corner & 1) * size, y + (corner >> 1) * size);
+                minDot = std::min(minDot, glm::dot(center, d));
+            }
+            const float angle = std::acos(std::clamp(minDot, -1.0f, 1.0f));
+
+            // 지평선 너머 (뒷면)
+            if (this->cameraDistance > this->radius)
+            {
+                const float toCamera = std::acos(std::clamp(glm::dot(center, this->cameraDir), -1.0f, 1.0f));
+                if (toCamera - angle > this->horizon) return;
+            }
+
+            // 화면 밖. 패치를 감싸는 구로 검사
+            const auto  centerPos = center * this->radius;
+            const float bound     = 2 * this->radius * std::sin(angle / 2);
+            for (const auto& plane : this->planes)
+            {
+                if (glm::dot(glm::vec3(plane), centerPos) + plane.w < -bound) return;
+            }
+
+            // 격자 한 칸이 화면에서 몇 픽셀인지. 한 변의 각도는 대략 대각선 절반의 √2 배
+            const float cell     = glm::root_two<float>() * angle * this->radius / PLANET_LOD_GRID;
+            const float distance = std::max(glm::length(this->camera - centerPos) - bound, this->radius * 1e-6f);
+
+            if (depth < PLANET_LOD_MAX_DEPTH && cell * this->pixelScale / distance > PLANET_LOD_PIXEL_ERROR)
+            {
+                const float half = size / 2;
+                this->select(face, x,        y,        half, depth + 1);
+                this->select(face, x + half, y,        half, depth + 1);
+                this->select(face, x,        y + half, half, depth + 1);
+                this->select(face, x + half, y + half, half, depth + 1);
+                return;
+            }
+
+            this->patches.emplace_back(static_cast<float>(face), x, y, size);
+            this->patchPixels.push_back(this->pixelScale * this->radius / distance);
+        }
+
+    public:
+        // 격자 만들기. shader 는 planet 셰이더
+        void init(GLuint shader, float radius)
+        {
+            this->radius = radius;
+
+            // 격자. 둘레 한 줄은 치마 (-1, G+1 번째 줄은 0, G 번째 줄과 같은 위치에서 아래로)
+            constexpr int G = PLANET_LOD_GRID;
+            constexpr int N = G + 3;
+
+            std::vector<GridVertex> vertices;
+            vertices.reserve(N * N);
+            for (int j = -1; j <= G + 1; j++)
+            {
+                for (int i = -1; i <= G + 1; i++)
+                {
+                    const int  si    = std::clamp(i, 0, G);
+                    const int  sj    = std::clamp(j, 0, G);
+                    const bool skirt = si != i || sj != j;
+
+                    GridVertex v;
+                    v.s     = static_cast<GLushort>(si * 65535 / G);
+                    v.t     = static_cast<GLushort>(sj * 65535 / G);
+                    v.skirt = skirt ? 65535 : 0;
+                    v.w     = 0;
+                    vertices.push_back(v);
+                }
+            }
+
+            /*
+            p21 - p22
+            |   /   |
+            p11 - p12
+
+            반시계 (바깥쪽)
+            p11 > p12 > p21
+            p21 > p12 > p22
+            */
+            std::vector<GLuint> indices;
+            indices.reserve((N - 1) * (N - 1) * 6);
+            for (int j = 0; j < N - 1; j++)
+            {
+                for (int i = 0; i < N - 1; i++)
+                {
+                    const GLuint p11 = (j + 0) * N + i;
+                    const GLuint p12 = (j + 0) * N + i + 1;
+                    const GLuint p21 = (j + 1) * N + i;
+                    const GLuint p22 = (j + 1) * N + i + 1;
+
+                    // 치마 모서리는 면적이 없음
+                    if ((i == 0 || i == N - 2) && (j == 0 || j == N - 2)) continue;
+
+                    indices.insert(indices.end(), { p11, p12, p21 });
+                    indices.insert(indices.end(), { p21, p12, p22 });
+                }
+            }
+
+            // 모든 패치가 같은 격자를 쓰므로 한번만 정렬해두면 됨
+            optimizeVertexCache(indices, vertices.size());
+
+            this->indicesCount = static_cast<int>(indices.size());
+
+            // VertexArray 생성
+            glGenVertexArrays(1, &this->vao);
+            glBindVertexArray(this->vao); defer(glBindVertexArray(0));
+
+            // 격자 저장
+            glGenBuffers(1, &this->vboGrid);
+            glBindBuffer(GL_ARRAY_BUFFER, this->vboGrid);
+            glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GridVertex), vertices.data(), GL_STATIC_DRAW);
+            glext::countUpload(vertices.size() * sizeof(GridVertex));
+
+            glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(GridVertex), (void*)0); glEnableVertexAttribArray(0);
+
+            // 인덱스 저장. 버텍스가 적어서 16 비트
+            const std::vector<GLushort> indices16(indices.begin(), indices.end());
+            this->indexType = GL_UNSIGNED_SHORT;
+
+            glGenBuffers(1, &this->eboGrid);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->eboGrid);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices16.size() * sizeof(GLushort), indices16.data(), GL_STATIC_DRAW);
+            glext::countUpload(indices16.size() * sizeof(GLushort));
+
+            // 패치 (instance). 크기는 그릴 때 맞춤
+            glGenBuffers(1, &this->vboPatch);
+            glBindBuffer(GL_ARRAY_BUFFER, this->vboPatch);
+
+            glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Patch), (void*)0); glEnableVertexAttribArray(1);
+            glVertexAttribDivisor(1, 1);
+
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+            // 셰이더에 면 정보 넘기기
+            glUseProgram(shader);
+            defer(glUseProgram(0));
+
+            glUniformMatrix3fv(glGetUniformLocation(shader, "faces"), 6, GL_FALSE, &FACES[0][0][0]);
+            glUniform1f(glGetUniformLocation(shader, "radius"    ), radius);
+            glUniform1f(glGetUniformLocation(shader, "skirtDepth"), PLANET_LOD_SKIRT_DEPTH);
+        }
+
+        // 이번 프레임에 그릴 패치 고르기
+        // mvp : projection * view * model, cameraPos : 행성 로컬 좌표의 카메라 위치, pixelScale : 거리 1 에서 길이 1 이 몇 픽셀인지
+        void update(const glm::mat4& mvp, const glm::vec3& cameraPos, float pixelScale)
+        {
+            // 절두체 평면. mvp 의 4 번째 행 +- 1 ~ 3 번째 행
+            for (int i = 0; i < 3; i++)
+            {
+                for (int sign = 0; sign < 2; sign++)
+                {
+                    auto& plane = this->planes[i * 2 + sign];
+                    for (int c = 0; c < 4; c++)
+                    {
+                        plane[c] = mvp[c][3] + (sign == 0 ? mvp[c][i] : -mvp[c][i]);
+                    }
+                    plane /= glm::length(glm::vec3(plane));
+                }
+            }
+
+            this->camera         = cameraPos;
+            this->cameraDistance = glm::length(cameraPos);
+            this->cameraDir      = cameraPos / std::max(this->cameraDistance, 1e-12f);
+            this->horizon        = this->cameraDistance > this->radius ? std::acos(this->radius / this->cameraDistance) : PI;
+            this->pixelScale     = pixelScale;
+
+            this->patches.clear();
+            this->patchPixels.clear();
+            for (int face = 0; face < 6; face++)
+            {
+                this->select(face, 0, 0, 1, 0);
+            }
+        }
+
+        // 고른 패치가 덮는 가상 텍스쳐 영역 요청하기
+        // GPU 에서 읽어오지 않고 패치 위치와 화면 크기로 계산함. 조금 넓게 잡아서 경계가 흐려지지 않게 함
+        void request(int virtualId) const
+        {
+            for (size_t i = 0; i < this->patches.size(); i++)
+            {
+                const auto& patch = this->patches[i];
+                const int   face  = static_cast<int>(patch.x);
+
+                // 3x3 점의 텍스쳐 좌표. u 는 가운데를 기준으로 펴서 0 / 1 경계를 넘어도 이어지게
+                const auto center = texCoords(direction(face, patch.y + patch.w / 2, patch.z + patch.w / 2));
+
+                glm::vec2 uvMin = center;
+                glm::vec2 uvMax = center;
+                for (int j = 0; j <= 2; j++)
+                {
+                    for (int k = 0; k <= 2; k++)
+                    {
+                        auto uv = texCoords(direction(face, patch.y + patch.w * k / 2, patch.z + patch.w * j / 2));
+                        uv.x -= std::round(uv.x - center.x);
+
+                        uvMin = glm::min(uvMin, uv);
+                        uvMax = glm::max(uvMax, uv);
+                    }
+                }
+
+                // 극이 들어있는 패치 (+Y, -Y 면 가운데) 는 경도 전체
+                const bool pole =
+                    (face == 2 || face == 3) &&
+                    patch.y <= 0.5f && 0.5f <= patch.y + patch.w &&
+                    patch.z <= 0.5f && 0.5f <= patch.z + patch.w;
+                if (pole)
+                {
+                    uvMin.x = 0;
+                    uvMax.x = 1;
+                    if (face == 2) uvMin.y = 0;
+                    else           uvMax.y = 1;
+                }
+
+                const auto margin = (uvMax - uvMin) * VTEX_FOOTPRINT_MARGIN;
+
+                // v 1 은 180 도
+                vtexture::request(virtualId, uvMin - margin, uvMax + margin, this->patchPixels[i] * PI);
+            }
+        }
+
+        // 고른 패치 그리기. 셰이더와 텍스쳐는 바인딩 되어 있어야 함
+        void draw()
+        {
+            if (this->patches.empty()) return;
+
+            glBindVertexArray(this->vao);
+            defer(glBindVertexArray(0));
+
+            glBindBuffer(GL_ARRAY_BUFFER, this->vboPatch);
+            defer(glBindBuffer(GL_ARRAY_BUFFER, 0));
+
+            // 버퍼를 새로 잡아서 (orphaning) 이전 프레임이 쓰고 있는 버퍼를 기다리지 않도록 함
+            this->patchCapacity = std::max(this->patchCapacity, this->patches.size());
+            glBufferData(GL_ARRAY_BUFFER, this->patchCapacity * sizeof(Patch), NULL, GL_STREAM_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, this->patches.size() * sizeof(Patch), this->patches.data());
+            glext::countUpload(this->patches.size() * sizeof(Patch));
+
+            glDrawElementsInstanced(GL_TRIANGLES, this->indicesCount, this->indexType, nullptr, static_cast<GLsizei>(this->patches.size()));
+            glext::countDraw();
+        }
+    };
+}
@@ -1,6 +1,8 @@
 ﻿#pragma once
 
+#include <cmath>
 #include <string>
+#include <vector>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -10,6 +12,7 @@
 #include "defer.h"
 #include "glext.h"
 #include "model_text.h"
+#include "platform.h"
 #include "v.h"
 
 namespace model
@@ -23,7 +26,6 @@ namespace model
         GLuint textureId = 0;
 
         GLuint fbo = 0;
-        GLuint rbo = 0;
 
         GLuint vao = 0;
         GLuint vbo = 0;
@@ -44,6 +46,30 @@ namespace model
             return this->size;
         }
 
+        // rect 안에 size 크기를 정렬했을 때의 위치. rect 의 w, h 가 -1 이면 size 를 그대로 씀
+        static v::Rect2f align(v::Rect2f rect, v::Size2f size, Alignment horizontalAlignment, Alignment verticalAlignment)
+        {
+            float x = 0, y = 0;
+
+            if (rect.w == -1) rect.w = size.w;
+            switch (horizontalAlignment)
+            {
+            case Alignment::Near:   x = rect.x;                        break;
+            case Alignment::Middle: x = rect.x + (rect.w - size.w) / 2; break;
+            case Alignment::Far:    x = rect.x + (rect.w - size.w);     break;
+            }
+
+            if (rect.h == -1) rect.h = size.h;
+            switch (verticalAlignment)
+            {
+            case Alignment::Near:   y = rect.y;                        break;
+            case Alignment::Middle: y = rect.y + (rect.h - size.h) / 2; break;
+            case Alignment::Far:    y = rect.y + (rect.h - size.h);     break;
+            }
+
+            return v::Rect2f(x, y, size.w, size.h);
+        }
+
         void init(v::Size2i size)
         {
             this->size = size;
@@ -83,7 +109,7 @@ namespace model
             glGenFramebuffers(1, &this->fbo);
 
             glBindFramebuffer(GL_FRAMEBUFFER, this->fbo);
-            defer(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+            defer(glBindFramebuffer(GL_FRAMEBUFFER, platform::framebuffer()));
 
             /**************************************************/
             // 프레임버퍼랑 텍스쳐랑 묶는 부분
@@ -100,27 +126,58 @@ namespace model
             // 텍스쳐를 프레이버퍼로 묶어버리기
             glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->textureId, 0);
 
-            /**************************************************/
-            // 렌더러 버퍼 생성 및 바인딩
-            glGenRenderbuffers(1, &this->rbo);
-
-            glBindRenderbuffer(GL_RENDERBUFFER, this->rbo);
-            defer(glBindRenderbuffer(GL_RENDERBUFFER, 0));
-
-            // 렌더러 버퍼 초기화. 높이버퍼 없이 색상만 쓰기.
-            glRenderbufferStorage(GL_RENDERBUFFER, GL_COLOR_ATTACHMENT0, this->size.w, this->size.h);
+            // 높이버퍼 없이 색상 (텍스쳐) 만 쓰므로 렌더 버퍼는 만들지 않음
 
             const auto frameBufferStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
             if (frameBufferStatus != GL_FRAMEBUFFER_COMPLETE)
                 throw std::runtime_error(std::string("Framebuffer is not complete!") + std::to_string(frameBufferStatus));
         }
 
+        // 크기 변경. 내용은 지워짐
+        void resize(v::Size2i size)
+        {
+            this->size = size;
+
+            glBindTexture(GL_TEXTURE_2D, this->textureId);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, this->size.w, this->size.h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+
+        // 일부분만 다시 그릴 수 있도록 프레임 버퍼 설정. dirty 영역만 지우고 나머지는 그대로 둔다.
+        // 영역은 화면 좌표 (위쪽이 0). 지운 영역 밖에 그린 것도 그대로 남으므로 다시 그릴 것만 그려야 함
+        void drawStart(const std::vector<v::Rect2f>& dirty)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, this->fbo);
+            glBindTexture(GL_TEXTURE_2D, this->textureId);
+
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+            glViewport(0, 0, this->size.w, this->size.h);
+
+            // 영역별로 지우기
+            glClearColor(0, 0, 0, 0);
+            glEnable(GL_SCISSOR_TEST);
+            for (const auto& rect : dirty)
+            {
+                glScissor(
+                    static_cast<GLint>(std::floor(rect.x)),
+                    static_cast<GLint>(std::floor(this->size.h - rect.y - rect.h)),
+                    static_cast<GLsizei>(std::ceil(rect.w)),
+                    static_cast<GLsizei>(std::ceil(rect.h))
+                );
+                glClear(GL_COLOR_BUFFER_BIT);
+            }
+            glDisable(GL_SCISSOR_TEST);
+
+            glDisable(GL_BLEND);
+        }
+
         // 버퍼에 그릴 수 있도록 프레임 버퍼 설정
         void drawStart()
         {
             // 프레임버퍼 생성 및 바인딩
             glBindFramebuffer(GL_FRAMEBUFFER, this->fbo);
-            glBindRenderbuffer(GL_RENDERBUFFER, this->rbo);
             glBindTexture(GL_TEXTURE_2D, this->textureId);
 
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -140,8 +197,7 @@ namespace model
         {
             glEnable(GL_BLEND);
             glBindTexture(GL_TEXTURE_2D, 0);
-            glBindRenderbuffer(GL_RENDERBUFFER, 0);
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glBindFramebuffer(GL_FRAMEBUFFER, platform::framebuffer());
         }
 
         void draw(v::Size2f windowSize, v::Rect2f rect, Alignment horizontalAlignment, Alignment verticalAlignment)
@@ -186,25 +242,12 @@ namespace model
             defer(glDisable(GL_SCISSOR_TEST));
 
             // 그릴 좌표 계산
-            float x = 0, y = 0;
-
-            if (rect.w == -1) rect.w = static_cast<float>(this->size.w);
-            switch (horizontalAlignment)
-            {
-            case Alignment::Near:   x = rect.x;                               break;
-            case Alignment::Middle: x = rect.x + (rect.w - this->size.w) / 2; break;
-            case Alignment::Far:    x = rect.x + (rect.w - this->size.w);     break;
-            }
+            const auto placed = align(rect, this->size, horizontalAlignment, verticalAlignment);
 
-            if (rect.h == -1) rect.h = static_cast<float>(this->size.h);
-            switch (verticalAlignment)
-            {
-            case Alignment::Near:   y = rect.y;                               break;
-            case Alignment::Middle: y = rect.y + (rect.h - this->size.h) / 2; break;
-            case Alignment::Far:    y = rect.y + (rect.h - this->size.h);     break;
-            }
-            float w = static_cast<float>(this->size.w);
-            float h = static_cast<float>(this->size.h);
+            const float x = placed.x;
+            const float y = placed.y;
+            const float w = placed.w;
+            const float h = placed.h;
 
             std::array<float, 24> vertices = {
                 x,     y + h,   0.0f, 0.0f,
@@ -226,9 +269,11 @@ namespace model
 
             // vbo 업데이트
             glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(float), vertices.data());
+            glext::countUpload(vertices.size() * sizeof(float));
 
             // 렌더링
             glDrawArrays(GL_TRIANGLES, 0, 6);
+            glext::countDraw();
         }
     };
 }
@@ -57,14 +57,14 @@ namespace model
                 for (int i = 0; i <= PLANET_SATURN_RING_PARTICLES; i++)
                 {
                     const auto theta = -PI_2 + PI2 * i / PLANET_SATURN_RING_PARTICLES;
-                    const auto c = std::cosf(theta);
-                    const auto s = std::sinf(theta);
+                    const auto c = std::cos(theta);
+                    const auto s = std::sin(theta);
 
-                    const float xout = planet._radius * PLANET_STAURN_RING_RAIDUS_MUL_OUT * c;
-                    const float yout = planet._radius * PLANET_STAURN_RING_RAIDUS_MUL_OUT * s;
+                    const float xout = planet.radius() * PLANET_STAURN_RING_RAIDUS_MUL_OUT * c;
+                    const float yout = planet.radius() * PLANET_STAURN_RING_RAIDUS_MUL_OUT * s;
 
-                    float xin = planet._radius * PLANET_STAURN_RING_RAIDUS_MUL_IN * c;
-                    float yin = planet._radius * PLANET_STAURN_RING_RAIDUS_MUL_IN * s;
+                    float xin = planet.radius() * PLANET_STAURN_RING_RAIDUS_MUL_IN * c;
+                    float yin = planet.radius() * PLANET_STAURN_RING_RAIDUS_MUL_IN * s;
 
                     //////////////////////////////////////////////////
 
@@ -117,11 +117,13 @@ namespace model
                 glGenBuffers(1, &this->vbo);
                 glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
                 glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
+                glext::countUpload(vertices.size() * sizeof(GLfloat));
 
                 // 인덱스 저장
                 glGenBuffers(1, &this->ebo);
                 glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ebo);
                 glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+                glext::countUpload(indices.size() * sizeof(GLuint));
 
                 // attri 사용 설정
                 glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(0 * sizeof(float))); glEnableVertexAttribArray(0);
@@ -166,6 +168,7 @@ namespace model
 
             // 렌더링
             glDrawElements(GL_TRIANGLES, this->indicesCount, GL_UNSIGNED_INT, nullptr);
+            glext::countDraw();
         }
     };
 }
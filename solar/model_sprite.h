@@ -0,0 +1,284 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "constants.h"
+#include "defer.h"
+#include "glext.h"
+#include "model_renderbuffer.h"
+#include "model_text.h"
+#include "platform.h"
+#include "v.h"
+
+namespace model
+{
+    // 도움말, 워터마크처럼 한번 그려두고 계속 쓰는 그림들을 텍스쳐 하나에 모아두는 모델
+    // 그림마다 프레임버퍼, 텍스쳐, 셰이더를 따로 두지 않고, 그릴 때도 모아뒀다가 한번에 그린다.
+    //
+    //   auto id = atlas.add(size);
+    //   auto rect = atlas.drawStart(id); Text::draw(atlas.getAtlasSize(), rect, ...); atlas.drawEnd();
+    //
+    //   atlas.queue(id, area, ...);         // 그릴 위치만 모아두고
+    //   atlas.flush(screen);                // 한번에 그리기
+    class SpriteAtlas
+    {
+    private:
+        struct Sprite
+        {
+            v::Rect2f rect = 0; // 아틀라스 안의 영역 (위쪽이 0)
+        };
+
+        GLuint shader = 0;
+
+        GLuint textureId = 0;
+        GLuint fbo       = 0;
+
+        GLuint vao = 0;
+        GLuint vbo = 0;
+        size_t vboCapacity = 0; // vbo 크기 (float 개수)
+
+        v::Size2i size = 0;
+
+        // 선반 단위로 쌓음. 줄 높이는 그 줄에서 가장 높은 그림
+        int shelfX = 0;
+        int shelfY = 0;
+        int shelfH = 0;
+
+        std::vector<Sprite> sprites;
+        std::vector<float>  vertices; // 이번에 그릴 사각형들
+
+        // 셰이더 데이터
+        GLuint uniformProjection = 0;
+
+        // 셰이더에 ortho 매트릭스 넘겨야 하는데, 윈도우 크기 달라지면 한번만 업데이트
+        std::mutex matrixOrthoLock;
+        glm::mat4  matrixOrtho = glm::mat4(0);
+        v::Size2f  matrixOrthoSize = -1;
+
+    public:
+        v::Size2f getAtlasSize()
+        {
+            return v::Size2f(static_cast<float>(this->size.w), static_cast<float>(this->size.h));
+        }
+
+        v::Size2f getSize(int id)
+        {
+            const auto& rect = this->sprites.at(id).rect;
+            return v::Size2f(rect.w, rect.h);
+        }
+
+        void init(v::Size2i size)
+        {
+            this->size = size;
+
+            // 셰이더 불러오고 기본 설정
+            this->shader = glext::loadShader(GeoMetry2D_TEX_SHADER);
+
+            {
+                glUseProgram(this->shader);
+                defer(glUseProgram(0));
+
+                glUniform1i(glGetUniformLocation(this->shader, "shaderTexture"), 0);
+
+                this->uniformProjection = glGetUniformLocation(this->shader, "projectionMatrix");
+
+                // vbo vao 초기화
+                glGenVertexArrays(1, &this->vao);
+
+                glBindVertexArray(this->vao);
+                defer(glBindVertexArray(0));
+
+                // 어레이 버퍼. 크기는 그릴 때 맞춤
+                glGenBuffers(1, &this->vbo);
+                glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
+                defer(glBindBuffer(GL_ARRAY_BUFFER, 0));
+
+                // attribute 활성화
+                glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(0 * sizeof(float))); glEnableVertexAttribArray(0);
+                glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float))); glEnableVertexAttribArray(1);
+            }
+
+            /**************************************************/
+
+            // 프레임버퍼 생성 및 바인딩
+            glGenFramebuffers(1, &this->fbo);
+
+            glBindFramebuffer(GL_FRAMEBUFFER, this->fbo);
+            defer(glBindFramebuffer(GL_FRAMEBUFFER, platform::framebuffer()));
+
+            // 텍스쳐 생성 및 바인딩
+            glGenTextures(1, &this->textureId);
+
+            glBindTexture(GL_TEXTURE_2D, this->textureId);
+            defer(glBindTexture(GL_TEXTURE_2D, 0));
+
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, this->size.w, this->size.h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+            // 텍스쳐를 프레이버퍼로 묶어버리기
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->textureId, 0);
+
+            const auto frameBufferStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+            if (frameBufferStatus != GL_FRAMEBUFFER_COMPLETE)
+                throw std::runtime_error(std::string("Framebuffer is not complete!") + std::to_string(frameBufferStatus));
+
+            // 처음엔 비어있음
+            glClearColor(0, 0, 0, 0);
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
+
+        // 아틀라스에 자리 잡기. 그림 번호를 반환
+        int add(v::Size2f size)
+        {
+            const int w = static_cast<int>(std::ceil(size.w));
+            const int h = static_cast<int>(std::ceil(size.h));
+
+            // 이번 줄에 안 들어가면 다음 줄로
+            if (this->shelfX + w > this->size.w)
+            {
+                this->shelfX = 0;
+                this->shelfY += this->shelfH + WINDOW_SPRITE_PADDING;
+                this->shelfH = 0;
+            }
+
+            if (w > this->size.w || this->shelfY + h > this->size.h)
+                throw std::runtime_error("Sprite atlas is full! " + std::to_string(w) + "x" + std::to_string(h));
+
+            Sprite sprite;
+            sprite.rect = v::Rect2f(
+                static_cast<float>(this->shelfX),
+                static_cast<float>(this->shelfY),
+                static_cast<float>(w),
+                static_cast<float>(h)
+            );
+            this->sprites.push_back(sprite);
+
+            this->shelfX += w + WINDOW_SPRITE_PADDING;
+            this->shelfH = std::max(this->shelfH, h);
+
+            return static_cast<int>(this->sprites.size() - 1);
+        }
+
+        // 그림 영역에 그릴 수 있도록 프레임 버퍼 설정. 그릴 영역을 반환
+        // 아틀라스 전체가 화면인 것 처럼 그리면 됨 (windowSize 는 getAtlasSize())
+        v::Rect2f drawStart(int id)
+        {
+            const auto& rect = this->sprites.at(id).rect;
+
+            glBindFramebuffer(GL_FRAMEBUFFER, this->fbo);
+            glViewport(0, 0, this->size.w, this->size.h);
+
+            // 그림 영역만 지우기
+            glClearColor(0, 0, 0, 0);
+            glEnable(GL_SCISSOR_TEST);
+            glScissor(
+                static_cast<GLint>(rect.x),
+                static_cast<GLint>(this->size.h - rect.y - rect.h),
+                static_cast<GLsizei>(rect.w),
+                static_cast<GLsizei>(rect.h)
+            );
+            glClear(GL_COLOR_BUFFER_BIT);
+            glDisable(GL_SCISSOR_TEST);
+
+            glDisable(GL_BLEND);
+
+            return rect;
+        }
+
+        // 렌더링 끝.
+        void drawEnd()
+        {
+            glEnable(GL_BLEND);
+            glBindFramebuffer(GL_FRAMEBUFFER, platform::framebuffer());
+        }
+
+        // 그릴 위치 추가. 실제로 그린 영역을 반환
+        v::Rect2f queue(int id, v::Rect2f rect, Alignment horizontalAlignment, Alignment verticalAlignment)
+        {
+            const auto& src = this->sprites.at(id).rect;
+            const auto placed = RenderBuffer::align(rect, v::Size2f(src.w, src.h), horizontalAlignment, verticalAlignment);
+
+            const float x = placed.x;
+            const float y = placed.y;
+            const float w = placed.w;
+            const float h = placed.h;
+
+            // 텍스쳐는 아래쪽이 0 이라 뒤집힘
+            const float u0 = src.x / this->size.w;
+            const float u1 = (src.x + src.w) / this->size.w;
+            const float v0 = 1.0f - (src.y + src.h) / this->size.h;
+            const float v1 = 1.0f - src.y / this->size.h;
+
+            const std::array<float, 24> quad = {
+                x,     y + h,   u0, v0,
+                x + w, y,       u1, v1,
+                x,     y,       u0, v1,
+
+                x,     y + h,   u0, v0,
+                x + w, y + h,   u1, v0,
+                x + w, y,       u1, v1,
+            };
+            this->vertices.insert(this->vertices.end(), quad.begin(), quad.end());
+
+            return placed;
+        }
+
+        // 모아둔 것 한번에 그리기
+        void flush(v::Size2f windowSize)
+        {
+            if (this->vertices.empty()) return;
+            defer(this->vertices.clear());
+
+            // 셰이더 활성화
+            glUseProgram(this->shader);
+            defer(glUseProgram(0));
+
+            // 매트릭스 업데이트
+            {
+                std::lock_guard<std::mutex> _lock(this->matrixOrthoLock);
+                if (this->matrixOrthoSize != windowSize)
+                {
+                    this->matrixOrthoSize = windowSize;
+
+                    this->matrixOrtho = glm::ortho(0.0f, windowSize.w, windowSize.h, 0.0f);
+                }
+
+                glUniformMatrix4fv(this->uniformProjection, 1, GL_FALSE, glm::value_ptr(this->matrixOrtho));
+            }
+
+            // 텍스쳐 바인딩
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, this->textureId);
+            defer(glBindTexture(GL_TEXTURE_2D, 0));
+
+            glBindVertexArray(this->vao);
+            defer(glBindVertexArray(0));
+
+            glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
+            defer(glBindBuffer(GL_ARRAY_BUFFER, 0));
+
+            // 버퍼를 새로 잡아서 (orphaning) 이전 프레임이 쓰고 있는 버퍼를 기다리지 않도록 함
+            this->vboCapacity = std::max(this->vboCapacity, this->vertices.size());
+            glBufferData(GL_ARRAY_BUFFER, this->vboCapacity * sizeof(float), NULL, GL_STREAM_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, this->vertices.size() * sizeof(float), this->vertices.data());
+            glext::countUpload(this->vertices.size() * sizeof(float));
+
+            // 렌더링
+            glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(this->vertices.size() / 4));
+            glext::countDraw();
+        }
+    };
+}
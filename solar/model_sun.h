@@ -28,7 +28,8 @@ namespace model
         GLuint textureId = 0;
 
         // 버텍스 갯수
-        int indicesCount = 0;
+        int    indicesCount = 0;
+        GLenum indexType    = GL_UNSIGNED_INT;
 
         // 셰이더 데이터
         GLuint vao = 0;
@@ -57,40 +58,25 @@ namespace model
         {
             this->shaderId = glext::loadShader(SUN_SHADER);
 
-            this->textureId = glext::loadTexture(planet._name);
+            this->textureId = glext::loadTexture(planet.texture());
 
-            this->radius = planet._radius / 4;
+            this->radius = planet.radius() / 4;
 
             // 버텍스 생성하기
-            std::vector<GLfloat> vertices;
-            std::vector<GLuint> indices;
+            model::SphereMesh mesh;
             model::initSphere(
-                planet._radius * 2,
                 PLANET_MODEL_SLICES_AND_STACKS,
                 PLANET_MODEL_SLICES_AND_STACKS,
-                vertices,
-                indices,
-                false,
-                false);
+                mesh);
 
-            this->indicesCount = indices.size();
+            this->indicesCount = mesh.indices.size();
 
             // VertexArray 생성
             glGenVertexArrays(1, &this->vao);
             glBindVertexArray(this->vao); defer(glBindVertexArray(0));
 
-            // 버텍스 저장
-            glGenBuffers(1, &this->vbo);
-            glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
-            glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
-
-            // 인덱스 저장
-            glGenBuffers(1, &this->ebo);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ebo);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
-
-            // attri 사용 설정
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)(0 * sizeof(float))); glEnableVertexAttribArray(0);
+            // 버텍스, 인덱스 저장
+            this->indexType = model::uploadSphere(mesh, this->vbo, this->ebo, false);
 
             // 셰이더에 들어갈 변수 아이디 얻기
             this->uniformProjectionMatrix = glGetUniformLocation(this->shaderId, "projectionMatrix");
@@ -108,6 +94,7 @@ namespace model
             defer(glUseProgram(0));
 
             glUniform1i(glGetUniformLocation(this->shaderId, "shaderTexture"), 0);
+            glUniform1f(glGetUniformLocation(this->shaderId, "radius"       ), planet.radius() * 2);
         }
 
         // model 그리기
@@ -151,7 +138,8 @@ namespace model
             defer(glBindVertexArray(0));
 
             // 렌더링
-            glDrawElements(GL_TRIANGLES, this->indicesCount, GL_UNSIGNED_INT, nullptr);
+            glDrawElements(GL_TRIANGLES, this->indicesCount, this->indexType, nullptr);
+            glext::countDraw();
         }
     };
 }
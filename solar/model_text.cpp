@@ -1,7 +1,13 @@
 ﻿#include "model_text.h"
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
 #include <exception>
-#include <sstream>
+#include <iostream>
+#include <iterator>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -10,6 +16,8 @@
 #include "constants.h"
 #include "defer.h"
 #include "glext.h"
+#include "platform.h"
+#include "trace.h"
 
 namespace model
 {
@@ -34,7 +42,9 @@ namespace model
         glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
         defer(glBindBuffer(GL_ARRAY_BUFFER, 0));
 
-        glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 5, NULL, GL_DYNAMIC_DRAW);
+        // 처음에는 64 글자 크기. 더 긴 줄이 오면 drawLine 에서 늘림
+        this->vboSize = sizeof(float) * 6 * 5 * 64;
+        glBufferData(GL_ARRAY_BUFFER, this->vboSize, NULL, GL_DYNAMIC_DRAW);
 
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(0 * sizeof(float))); glEnableVertexAttribArray(0);
         glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float))); glEnableVertexAttribArray(1);
@@ -63,6 +73,7 @@ namespace model
 
         // 크기 선택
         FT_Set_Pixel_Sizes(fc->tfFace, 0, size);
+        fc->pixelSize = size;
 
         // 추가
         this->faces.insert(std::make_pair(size, std::move(fc)));
@@ -70,111 +81,516 @@ namespace model
         return this->faces.find(size)->second.get();
     }
 
-    Text::Face::CharInfo Text::Face::getChar(wchar_t c)
+    const Text::Face::CharInfo* Text::Face::peek(uint32_t code)
     {
+        if (code < this->ascii.size())
+        {
+            return this->ascii[code].load(std::memory_order_acquire);
+        }
+        else if (code <= 0xFFFF)
+        {
+            const auto page = this->pages[code >> 8].load(std::memory_order_acquire);
+            if (page != nullptr) return page->slots[code & 0xFF].load(std::memory_order_acquire);
+        }
+        return nullptr;
+    }
+
+    const Text::Face::CharInfo& Text::Face::getChar(wchar_t c, bool wait)
+    {
+        // 잠그지 않고 찾기
+        const auto info = this->peek(static_cast<uint32_t>(c));
+        if (info != nullptr) return *info;
+
+        return this->loadChar(c, wait);
+    }
+
+    const Text::Face::CharInfo& Text::Face::insert(uint32_t code, const CharInfo& info)
+    {
+        // 넣을 칸. 이미 있으면 그걸 반환
+        Slot* slot = nullptr;
+        if (code < this->ascii.size())
+        {
+            slot = &this->ascii[code];
+        }
+        else if (code <= 0xFFFF)
+        {
+            auto page = this->pages[code >> 8].load(std::memory_order_relaxed);
+            if (page == nullptr)
+            {
+                this->pageStorage.push_back(std::make_unique<Page>());
+                page = this->pageStorage.back().get();
+                this->pages[code >> 8].store(page, std::memory_order_release);
+            }
+            slot = &page->slots[code & 0xFF];
+        }
+        else
+        {
+            auto f = this->others.find(code);
+            if (f != this->others.end()) return *f->second;
+        }
+
+        if (slot != nullptr)
+        {
+            const auto exists = slot->load(std::memory_order_relaxed);
+            if (exists != nullptr) return *exists;
+        }
+
+        this->storage.push_back(info);
+        const CharInfo* stored = &this->storage.back();
+
+        // 다 채운 다음에 공개
+        if (slot != nullptr) slot->store(stored, std::memory_order_release);
+        else                 this->others.insert(std::make_pair(code, stored));
+
+        return *stored;
+    }
+
+    const Text::Face::CharInfo& Text::Face::loadChar(wchar_t c, bool wait)
+    {
+        const auto code = static_cast<uint32_t>(c);
+
         // 중복실행 방지
         std::lock_guard<std::mutex> _lock(this->lock);
 
-        // 있으면 반환
-        auto f = this->info.find(c);
-        if (f != this->info.end()) return f->second;
+        // 기다리는 동안 다른 스레드가 넣었으면 그걸 반환
+        if (code > 0xFFFF)
+        {
+            auto f = this->others.find(code);
+            if (f != this->others.end()) return *f->second;
+        }
+        else
+        {
+            const auto info = this->peek(code);
+            if (info != nullptr) return *info;
+        }
+
+        // 백그라운드에서 그리고 그 동안은 네모
+        if (!wait && Text::instance().asyncMisses)
+        {
+            Text::instance().request(this->pixelSize, c);
+
+            if (this->fallback.TextureID == 0)
+            {
+                const int w = std::max(2, this->pixelSize / 2);
+                const int h = std::max(2, this->pixelSize * 2 / 3);
+
+                std::vector<unsigned char> box(static_cast<size_t>(w) * h, 0);
+                for (int y = 0; y < h; y++)
+                {
+                    for (int x = 0; x < w; x++)
+                    {
+                        if (x == 0 || y == 0 || x == w - 1 || y == h - 1) box[static_cast<size_t>(y) * w + x] = 0xFF;
+                    }
+                }
+
+                this->fallback = Text::instance().createTexture(v::Size2i(w, h), v::Point2i(1, h), static_cast<FT_Pos>(w + 2) << 6, box.data());
+            }
+            return this->fallback;
+        }
 
         // 캐릭터 글리프 가져오기
         if (FT_Load_Char(this->tfFace, c, FT_LOAD_RENDER))
             throw std::runtime_error("Could not load char.");
 
-        // disable byte-alignment restriction
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
-        GLuint textureId = 0;
-
-        // generate textureId
-        glGenTextures(1, &textureId);
-        glBindTexture(GL_TEXTURE_2D, textureId);
-        glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            GL_RED,
-            this->tfFace->glyph->bitmap.width,
-            this->tfFace->glyph->bitmap.rows,
-            0,
-            GL_RED,
-            GL_UNSIGNED_BYTE,
-            this->tfFace->glyph->bitmap.buffer
+        const auto glyph = this->tfFace->glyph;
+
+        return this->insert(
+            code,
+            Text::instance().createTexture(
+                v::Size2i(glyph->bitmap.width, glyph->bitmap.rows),
+                v::Point2i(glyph->bitmap_left, glyph->bitmap_top),
+                glyph->advance.x,
+                glyph->bitmap.buffer
+            )
         );
+    }
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    Text::Face::CharInfo Text::createTexture(v::Size2i size, v::Point2i bearing, FT_Pos advance, const unsigned char* pixels)
+    {
+        // 지금 줄에 자리가 없으면 다음 줄로, 아래에도 자리가 없으면 새 아틀라스
+        const auto fits = [&](const Atlas& atlas)
+        {
+            return atlas.x + size.w <= FONT_ATLAS_SIZE && atlas.y + size.h <= FONT_ATLAS_SIZE;
+        };
 
-        glBindTexture(GL_TEXTURE_2D, 0);
+        if (!this->atlases.empty() && !fits(this->atlases.back()))
+        {
+            auto& atlas = this->atlases.back();
+            atlas.x = 0;
+            atlas.y += atlas.rowHeight + FONT_ATLAS_PADDING;
+            atlas.rowHeight = 0;
+        }
 
-        auto chInfo = CharInfo
+        if (this->atlases.empty() || !fits(this->atlases.back()))
         {
-            textureId,
-            v::Size2i(this->tfFace->glyph->bitmap.width, this->tfFace->glyph->bitmap.rows),
-            v::Point2i(this->tfFace->glyph->bitmap_left, this->tfFace->glyph->bitmap_top),
-            tfFace->glyph->advance.x
+            Atlas atlas;
+            glGenTextures(1, &atlas.textureId);
+            glBindTexture(GL_TEXTURE_2D, atlas.textureId);
+
+            // 글자 사이 간격이 비어있도록 0 으로 채워서 만듦
+            const std::vector<unsigned char> empty(static_cast<size_t>(FONT_ATLAS_SIZE) * FONT_ATLAS_SIZE, 0);
+
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, FONT_ATLAS_SIZE, FONT_ATLAS_SIZE, 0, GL_RED, GL_UNSIGNED_BYTE, empty.data());
+            glext::countUpload(empty.size());
+
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+            glBindTexture(GL_TEXTURE_2D, 0);
+
+            this->atlases.push_back(atlas);
+        }
+
+        auto& atlas = this->atlases.back();
+
+        if (size.w > 0 && size.h > 0 && pixels != nullptr)
+        {
+            // disable byte-alignment restriction
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+            glBindTexture(GL_TEXTURE_2D, atlas.textureId);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, atlas.x, atlas.y, size.w, size.h, GL_RED, GL_UNSIGNED_BYTE, pixels);
+            glext::countUpload(static_cast<uint64_t>(size.w) * size.h);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+
+        constexpr float scale = 1.0f / FONT_ATLAS_SIZE;
+
+        const Face::CharInfo info
+        {
+            atlas.textureId,
+            size,
+            bearing,
+            advance,
+            v::Rect2f(atlas.x * scale, atlas.y * scale, size.w * scale, size.h * scale),
         };
-        this->info.insert(std::make_pair(c, chInfo));
 
-        return chInfo;
+        atlas.x += size.w + FONT_ATLAS_PADDING;
+        atlas.rowHeight = std::max(atlas.rowHeight, size.h);
+
+        return info;
     }
 
-    template <typename T>
-    Text::MeasureDetail Text::measureDetail(Face* face, const std::basic_string<T>& str)
+    /**************************************************************************************************************/
+    // 글자 미리 그리기
+
+    Text::~Text()
     {
-        MeasureDetail r{};
-        
         {
-            std::basic_stringstream<T> ss(str);
-            std::basic_string<T> line;
+            std::lock_guard<std::mutex> _lock(this->warmLock);
+            this->warmStopping = true;
+        }
+        this->warmCv.notify_all();
 
-            const auto chH = face->getChar('H');
+        for (auto& worker : this->warmWorkers)
+        {
+            worker.join();
+        }
+    }
 
-            while (std::getline(ss, line))
-            {
-                int width = 0;
-                int height = 0;
+    void Text::request(int size, wchar_t c)
+    {
+        {
+            std::lock_guard<std::mutex> _lock(this->warmLock);
+
+            if (!this->warmRequested.insert(std::make_pair(size, static_cast<uint32_t>(c))).second) return;
+            this->warmRequests.emplace_back(size, c);
 
-                // 빈 줄이면...??
-                // 높이를 H 문자 기준으로 계산하기
-                if (line.size() == 0)
+            // 처음 요청할 때 스레드 시작
+            if (this->warmWorkers.empty())
+            {
+                for (int i = 0; i < TEXT_WARMUP_WORKERS; i++)
                 {
-                    //height = glm::max(height, chH.Size.h);
-                    height = (static_cast<int>(face->tfFace->size->metrics.height >> 6) + 1) * 2 / 3;
+                    this->warmWorkers.emplace_back(&Text::warmLoop, this);
                 }
-                else
-                {
-                    for (auto c : line)
-                    {
-                        const auto ch = face->getChar(c);
+            }
+        }
+        this->warmCv.notify_one();
+    }
 
-                        width += (ch.Advance >> 6);
+    void Text::warmLoop()
+    {
+        trace::setThreadName("glyph");
 
-                        //height = glm::max(height, ch.Size.h + chH.Bearing.y - ch.Bearing.y);
-                        height = glm::max(height, static_cast<int>(face->tfFace->size->metrics.height >> 6) + 1);
-                    }
+        FT_Library library = nullptr;
+        if (FT_Init_FreeType(&library))
+        {
+            std::cout << "text : could not init FreeType for glyph worker." << std::endl;
+            return;
+        }
+        defer(FT_Done_FreeType(library));
+
+        // 크기별로 열어둔 폰트. FT_Face 는 스레드끼리 나눠 쓸 수 없음
+        std::map<int, FT_Face> faces;
+        deferf([&]() { for (auto& f : faces) FT_Done_Face(f.second); });
+
+        while (true)
+        {
+            std::pair<int, wchar_t> job;
+            {
+                std::unique_lock<std::mutex> _lock(this->warmLock);
+                this->warmCv.wait(_lock, [&] { return this->warmStopping || !this->warmRequests.empty(); });
+                if (this->warmStopping) return;
+
+                job = this->warmRequests.front();
+                this->warmRequests.pop_front();
+            }
+
+            TRACE_SCOPE("Text::rasterize");
+
+            auto f = faces.find(job.first);
+            if (f == faces.end())
+            {
+                FT_Face face = nullptr;
+                if (FT_New_Face(library, FONT_PATH, 0, &face)) continue;
+
+                FT_Set_Pixel_Sizes(face, 0, job.first);
+                f = faces.emplace(job.first, face).first;
+            }
+
+            Raster r{};
+            r.size = job.first;
+            r.c    = job.second;
+
+            // 못 그리는 글자는 빈 글자로
+            if (!FT_Load_Char(f->second, job.second, FT_LOAD_RENDER))
+            {
+                copyGlyph(f->second->glyph, r);
+            }
+
+            {
+                std::lock_guard<std::mutex> _lock(this->warmLock);
+                this->warmDone.push_back(std::move(r));
+                this->warmReady = this->warmDone.size();
+            }
+        }
+    }
+
+    void Text::copyGlyph(FT_GlyphSlot glyph, Raster& r)
+    {
+        r.bitmapSize = v::Size2i(glyph->bitmap.width, glyph->bitmap.rows);
+        r.bearing    = v::Point2i(glyph->bitmap_left, glyph->bitmap_top);
+        r.advance    = glyph->advance.x;
+
+        // 줄 간격 (pitch) 을 빼고 복사
+        r.pixels.resize(static_cast<size_t>(glyph->bitmap.width) * glyph->bitmap.rows);
+        for (unsigned int y = 0; y < glyph->bitmap.rows; y++)
+        {
+            std::memcpy(
+                r.pixels.data() + static_cast<size_t>(y) * glyph->bitmap.width,
+                glyph->bitmap.buffer + static_cast<ptrdiff_t>(y) * glyph->bitmap.pitch,
+                glyph->bitmap.width
+            );
+        }
+    }
+
+    Text::Raster Text::rasterize(int size, wchar_t c)
+    {
+        auto face = this->getFace(size);
+
+        // tfFace 는 글자 불러올 때도 쓰므로 잠금
+        std::lock_guard<std::mutex> _lock(face->lock);
+
+        Raster r{};
+        r.size = size;
+        r.c    = c;
+
+        if (FT_Load_Char(face->tfFace, c, FT_LOAD_RENDER))
+            throw std::runtime_error("Could not load char.");
+
+        copyGlyph(face->tfFace->glyph, r);
+        return r;
+    }
+
+    int Text::lineHeight(int size)
+    {
+        return static_cast<int>(this->getFace(size)->tfFace->size->metrics.height >> 6) + 1;
+    }
+
+    void Text::warmUp(const std::vector<int>& sizes, const std::wstring& chars)
+    {
+        TRACE_SCOPE("Text::warmUp");
+
+        size_t requested = 0;
+        for (const auto size : sizes)
+        {
+            auto face = this->getFace(size);
+
+            for (const auto c : chars)
+            {
+                if (c == '\n' || face->peek(static_cast<uint32_t>(c)) != nullptr) continue;
+
+                this->request(size, c);
+                requested++;
+            }
+        }
+
+        std::cout << "text : warming up glyphs. sizes: " << sizes.size() << ", requests: " << requested << std::endl;
+    }
+
+    size_t Text::upload(size_t count)
+    {
+        if (this->warmReady == 0) return 0;
+
+        TRACE_SCOPE("Text::upload");
+
+        // 한번에 너무 많이 올리면 프레임이 밀리므로 count 개씩
+        std::vector<Raster> batch;
+        {
+            std::lock_guard<std::mutex> _lock(this->warmLock);
+
+            const auto first = this->warmDone.end() - static_cast<ptrdiff_t>(std::min(count, this->warmDone.size()));
+            batch.assign(std::make_move_iterator(first), std::make_move_iterator(this->warmDone.end()));
+            this->warmDone.erase(first, this->warmDone.end());
+            this->warmReady = this->warmDone.size();
+        }
+
+        size_t uploaded = 0;
+        for (const auto& r : batch)
+        {
+            auto face = this->getFace(r.size);
+
+            // 그 사이에 그 자리에서 그렸으면 버림
+            std::lock_guard<std::mutex> _lock(face->lock);
+            if (face->peek(static_cast<uint32_t>(r.c)) != nullptr) continue;
+
+            face->insert(
+                static_cast<uint32_t>(r.c),
+                this->createTexture(r.bitmapSize, r.bearing, r.advance, r.pixels.empty() ? nullptr : r.pixels.data())
+            );
+            uploaded++;
+        }
+
+        return uploaded;
+    }
+
+    // FNV-1a
+    static uint64_t hashBytes(uint64_t h, const void* data, size_t length)
+    {
+        const auto bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < length; i++)
+        {
+            h ^= bytes[i];
+            h *= 0x100000001B3ull;
+        }
+        return h;
+    }
+
+    template <typename T>
+    std::shared_ptr<const Text::Layout> Text::layout(int size, std::basic_string_view<T> str, bool wait)
+    {
+        // 키는 (크기, 글자 폭, 문자열)
+        uint64_t key = 0xCBF29CE484222325ull;
+        key = hashBytes(key, &size, sizeof(size));
+        const uint8_t width = sizeof(T);
+        key = hashBytes(key, &width, sizeof(width));
+        key = hashBytes(key, str.data(), str.size() * sizeof(T));
+
+        {
+            std::lock_guard<std::mutex> _lock(this->layoutsLock);
+
+            auto f = this->layouts.find(key);
+            if (f != this->layouts.end())
+            {
+                // 해시만 같은 다른 문자열이면 새로 만들어서 덮어씀
+                const auto& source = f->second->source;
+                if (source.size() == str.size() * sizeof(T) && std::memcmp(source.data(), str.data(), source.size()) == 0)
+                {
+                    return f->second;
                 }
+            }
+        }
 
-                // 전체 사이즈 계산
-                r.sizeTotal.w  = glm::max(r.sizeTotal.w, width );
-                r.sizeTotal.h += height;
+        // 없으면 계산. 글리프를 불러오는 동안 잠그지 않음
+        auto r = this->buildLayout<T>(this->getFace(size), str, wait);
 
-                // 사이즈 벡터에 밀어넣고
-                r.size.push_back({ width, height });
+        // 네모가 섞여 있으면 글자가 올라온 뒤에 다시 배치해야 하므로 저장하지 않음
+        if (r->complete)
+        {
+            std::lock_guard<std::mutex> _lock(this->layoutsLock);
 
-                // 줄 수 기록
-                r.lines++;
+            // 날자, fps 처럼 계속 바뀌는 문자열 때문에 끝없이 커지지 않도록
+            if (this->layouts.size() >= FONT_LAYOUT_CACHE_SIZE)
+            {
+                this->layouts.clear();
             }
+            this->layouts[key] = r;
         }
 
         return r;
     }
 
     template <typename T>
-    void Text::drawLine(Face* face, float x, float y, float z, v::Color color, const std::basic_string<T>& str)
+    std::shared_ptr<const Text::Layout> Text::buildLayout(Face* face, std::basic_string_view<T> str, bool wait)
+    {
+        TRACE_SCOPE("Text::buildLayout");
+
+        auto r = std::make_shared<Layout>();
+        r->sizeTotal = 0;
+        r->source.assign(reinterpret_cast<const char*>(str.data()), str.size() * sizeof(T));
+
+        const auto chH = face->getChar('H');
+        const auto lineHeight = static_cast<int>(face->tfFace->size->metrics.height >> 6) + 1;
+
+        // 줄 단위로 자르기. getline 처럼 마지막 빈 줄은 없는 것으로 침
+        size_t pos = 0;
+        while (pos < str.size())
+        {
+            auto end = str.find(static_cast<T>('\n'), pos);
+            if (end == std::basic_string_view<T>::npos) end = str.size();
+
+            const auto line = str.substr(pos, end - pos);
+            pos = end + 1;
+
+            Layout::Line info{};
+            info.first = r->glyphs.size();
+            info.count = line.size();
+
+            // 빈 줄이면...??
+            // 높이를 H 문자 기준으로 계산하기
+            if (line.size() == 0)
+            {
+                info.size.h = lineHeight * 2 / 3;
+            }
+            else
+            {
+                info.size.h = lineHeight;
+
+                int x = 0;
+                for (auto c : line)
+                {
+                    const auto& ch = face->getChar(c, wait);
+                    if (&ch == &face->fallback) r->complete = false;
+
+                    r->glyphs.push_back(Layout::Glyph{
+                        ch.TextureID,
+                        static_cast<float>(x + ch.Bearing.x),
+                        static_cast<float>(chH.Bearing.y - ch.Bearing.y),
+                        static_cast<float>(ch.Size.w),
+                        static_cast<float>(ch.Size.h),
+                        ch.TexRect,
+                    });
+
+                    // bitshift by 6 to get value in pixels (1/64th times 2^6 = 64)
+                    x += static_cast<int>(ch.Advance >> 6);
+                }
+                info.size.w = x;
+            }
+
+            // 전체 사이즈 계산
+            r->sizeTotal.w  = glm::max(r->sizeTotal.w, info.size.w);
+            r->sizeTotal.h += info.size.h;
+
+            r->lines.push_back(info);
+        }
+
+        return r;
+    }
+
+    void Text::drawLine(const Layout& layout, const Layout::Line& line, float x, float y, float z)
     {
         glBindVertexArray(this->vao);
         defer(glBindVertexArray(0));
@@ -183,41 +599,60 @@ namespace model
         glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
         defer(glBindBuffer(GL_ARRAY_BUFFER, 0));
 
-        const auto chH = face->getChar('H');
+        // 줄 전체의 사각형을 만들어서 한번에 올림
+        auto& vertices = this->lineVertices;
+        vertices.clear();
 
-        // iterate through all characters
-        for (auto c = str.begin(); c != str.end(); c++)
+        for (size_t i = line.first; i < line.first + line.count; i++)
         {
-            const auto ch = face->getChar(*c);
+            const auto& g = layout.glyphs[i];
 
-            const auto xpos = x + static_cast<float>(ch.Bearing.x);
-            const auto ypos = y + static_cast<float>(chH.Bearing.y - ch.Bearing.y);
+            const auto xpos = x + g.x;
+            const auto ypos = y + g.y;
 
-            const auto w = static_cast<float>(ch.Size.w);
-            const auto h = static_cast<float>(ch.Size.h);
+            const auto w = g.w;
+            const auto h = g.h;
 
-            // update vbo for each character
-            std::array<float, 30> vertices = {
-                xpos,     ypos + h, z,   0.0f, 1.0f,
-                xpos + w, ypos,     z,   1.0f, 0.0f,
-                xpos,     ypos,     z,   0.0f, 0.0f,
+            const auto u0 = g.tex.x, u1 = g.tex.x + g.tex.w;
+            const auto v0 = g.tex.y, v1 = g.tex.y + g.tex.h;
 
-                xpos,     ypos + h, z,   0.0f, 1.0f,
-                xpos + w, ypos + h, z,   1.0f, 1.0f,
-                xpos + w, ypos,     z,   1.0f, 0.0f,
-            };
-            
-            // 캐릭터 텍스쳐 바인딩
-            glBindTexture(GL_TEXTURE_2D, ch.TextureID);
+            vertices.insert(vertices.end(), {
+                xpos,     ypos + h, z,   u0, v1,
+                xpos + w, ypos,     z,   u1, v0,
+                xpos,     ypos,     z,   u0, v0,
 
-            // 업데이트
-            glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(float), vertices.data());
+                xpos,     ypos + h, z,   u0, v1,
+                xpos + w, ypos + h, z,   u1, v1,
+                xpos + w, ypos,     z,   u1, v0,
+            });
+        }
 
-            // 렌더링
-            glDrawArrays(GL_TRIANGLES, 0, 6);
+        const auto bytes = vertices.size() * sizeof(float);
+        if (bytes > this->vboSize)
+        {
+            this->vboSize = bytes;
+            glBufferData(GL_ARRAY_BUFFER, bytes, vertices.data(), GL_DYNAMIC_DRAW);
+        }
+        else
+        {
+            glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, vertices.data());
+        }
+        glext::countUpload(bytes);
+
+        // 같은 아틀라스에 있는 글자끼리 한번에 그림. 아틀라스가 하나면 줄마다 한번
+        size_t first = 0;
+        while (first < line.count)
+        {
+            const auto textureId = layout.glyphs[line.first + first].TextureID;
+
+            size_t last = first + 1;
+            while (last < line.count && layout.glyphs[line.first + last].TextureID == textureId) last++;
 
-            // bitshift by 6 to get value in pixels (1/64th times 2^6 = 64)
-            x += (ch.Advance >> 6);
+            glBindTexture(GL_TEXTURE_2D, textureId);
+            glDrawArrays(GL_TRIANGLES, static_cast<GLint>(first * 6), static_cast<GLsizei>((last - first) * 6));
+            glext::countDraw();
+
+            first = last;
         }
 
         glBindTexture(GL_TEXTURE_2D, 0);
@@ -231,8 +666,6 @@ namespace model
 
         glUniform4fv(this->uniformTextColor, 1, color);
 
-        auto face = this->getFace(size);
-
         // 매트릭스 업데이트
         {
             std::lock_guard<std::mutex> _lock(this->matrixOrthoLock);
@@ -248,16 +681,18 @@ namespace model
 
         // 영역 제한
         v::Rect2f rectOut{};
-        auto md = this->measureDetail(face, str);
+        const auto laid = this->layout<T>(size, str, false);
+        const auto& md = *laid;
 
         {
             // 그리는 영역 제한
             if (rect.w >= 0 && rect.h >= 0)
             {
                 glEnable(GL_SCISSOR_TEST);
+                // 화면 좌표는 위쪽이 0, scissor 는 아래쪽이 0
                 glScissor(
                     static_cast<GLint>(rect.x),
-                    static_cast<GLint>(rect.y),
+                    static_cast<GLint>(windowSize.h - rect.y - rect.h),
                     static_cast<GLsizei>(rect.w),
                     static_cast<GLsizei>(rect.h)
                 );
@@ -282,15 +717,11 @@ namespace model
             rectOut.y = rect.y;
 
             // 한 줄씩 쓰기
-            std::basic_stringstream<T> ss(str);
-            std::basic_string<T> line;
-
             float xx = 0;
 
-            int lineIndex = 0;
-            while (std::getline(ss, line))
+            for (const auto& line : md.lines)
             {
-                auto& sizeThisLine = md.size.at(lineIndex++);
+                const auto& sizeThisLine = line.size;
 
                 switch (horizontalAlignment)
                 {
@@ -309,9 +740,9 @@ namespace model
                     rectOut.x = xx;
 
                 // 문자 수가 1개 이상임
-                if (line.size() > 0)
+                if (line.count > 0)
                 {
-                    drawLine(face, xx, rect.y, z, color, line);
+                    drawLine(md, line, xx, rect.y, z);
                 }
 
                 rect.y += sizeThisLine.h;
@@ -335,14 +766,12 @@ namespace model
     v::Size2i Text::measure(int size, const std::string& str)
     {
         // 정보 가져오고
-        auto face = this->getFace(size);
-        return this->measureDetail<char>(face, str).sizeTotal;
+        return this->layout<char>(size, str, true)->sizeTotal;
     }
     v::Size2i Text::measure(int size, const std::wstring& str)
     {
         // 정보 가져오고
-        auto face = this->getFace(size);
-        return this->measureDetail<wchar_t>(face, str).sizeTotal;
+        return this->layout<wchar_t>(size, str, true)->sizeTotal;
     }
 
     // 점을 기준으로 문자를 쓰는 함수.
@@ -364,4 +793,81 @@ namespace model
     {
         return this->drawAll<wchar_t>(windowSize, location, z, horizontalAlignment, verticalAlignment, size, color, str);
     }
+
+    void Text::benchmark(std::ostream& os)
+    {
+        // UI 에 쓰는 것 처럼 ASCII 와 한글이 섞인 문자열
+        const std::wstring sample = TEXT_BENCH_SAMPLE;
+        const std::wstring_view view(sample);
+
+        auto face = this->getFace(FONT_SIZE_2);
+
+        // 처음 한 번은 글리프를 불러오므로 빼고 잰다
+        this->measure(FONT_SIZE_2, sample);
+
+        std::array<char, 256> buff;
+        std::snprintf(buff.data(), buff.size(), "%-10s %12s %16s", "stage", "ms", "glyphs/sec");
+        os << buff.data() << std::endl;
+
+        const auto print = [&](const char* stage, std::chrono::steady_clock::time_point start, size_t iterations)
+        {
+            const auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            const auto glyphs = static_cast<double>(iterations) * sample.size();
+
+            std::snprintf(buff.data(), buff.size(), "%-10s %12.2f %16.0f", stage, ms, glyphs / ms * 1000);
+            os << buff.data() << std::endl;
+        };
+
+        // 글자 찾기
+        {
+            FT_Pos sink = 0;
+
+            const auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < TEXT_BENCH_ITERATIONS; i++)
+            {
+                for (auto c : sample) sink += face->getChar(c).Advance;
+            }
+            print("lookup", start, TEXT_BENCH_ITERATIONS);
+
+            // 최적화로 없어지지 않도록
+            if (sink == 0) os << std::endl;
+        }
+
+        // 캐시 없이 배치
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < TEXT_BENCH_ITERATIONS; i++)
+            {
+                this->buildLayout<wchar_t>(face, view, true);
+            }
+            print("layout", start, TEXT_BENCH_ITERATIONS);
+        }
+
+        // 캐시된 배치
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < TEXT_BENCH_ITERATIONS; i++)
+            {
+                this->measure(FONT_SIZE_2, sample);
+            }
+            print("measure", start, TEXT_BENCH_ITERATIONS);
+        }
+
+        // 그리기. GPU 가 끝날 때 까지
+        {
+            const auto size = platform::size();
+            const v::Size2f windowSize(static_cast<float>(size.w), static_cast<float>(size.h));
+
+            glFinish();
+
+            const auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < TEXT_BENCH_DRAW_ITERATIONS; i++)
+            {
+                this->draw(windowSize, v::Rect2f(0, windowSize), Alignment::Near, Alignment::Near, FONT_SIZE_2, 0xFFFFFF, sample);
+            }
+            glFinish();
+
+            print("draw", start, TEXT_BENCH_DRAW_ITERATIONS);
+        }
+    }
 }
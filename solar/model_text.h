@@ -3,10 +3,21 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <ostream>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
 #include <tuple>
+#include <unordered_map>
 #include <vector>
 
 #include <glad/glad.h>
@@ -29,31 +40,92 @@ namespace model
 
     class Text
     {
+    public:
+        // 글자 비트맵. 줄 간격 (pitch) 없이 한 줄에 bitmapSize.w 바이트
+        struct Raster
+        {
+            int                        size;
+            wchar_t                    c;
+            v::Size2i                  bitmapSize;
+            v::Point2i                 bearing; // 기준선에서 비트맵 왼쪽 위까지
+            FT_Pos                     advance; // 다음 글자까지 (1/64 픽셀)
+            std::vector<unsigned char> pixels;
+        };
+
     private:
         struct Face
         {
             struct CharInfo
             {
-                GLuint     TextureID; // ID handle of the glyph textureId
+                GLuint     TextureID; // 글자가 들어있는 아틀라스 텍스쳐
                 v::Size2i  Size;      // size of glyph
                 v::Point2i Bearing;   // offset from baseline to left/top of glyph
                 FT_Pos     Advance;   // horizontal offset to advance to next glyph
+                v::Rect2f  TexRect;   // 아틀라스 안의 글자 위치 (텍스쳐 좌표)
+            };
+
+            // 글자 정보 칸. 한번 채워지면 바뀌지 않으므로 읽을 때는 잠그지 않음
+            using Slot = std::atomic<const CharInfo*>;
+
+            // BMP 256 글자 단위
+            struct Page
+            {
+                std::array<Slot, 256> slots{};
             };
 
             FT_Face tfFace = nullptr; // FT_Face 객체
+            int     pixelSize = 0;    // 글씨 크기
+
+            std::array<Slot, 128>                ascii{}; // ASCII 는 바로 찾기
+            std::array<std::atomic<Page*>, 256> pages{}; // BMP 는 상위 바이트로 페이지, 하위 바이트로 칸
+
+            // 여기부터는 새 글자를 넣을 때만 씀
+            std::mutex                          lock;
+            std::deque<CharInfo>                storage;     // 글자 정보. 주소가 바뀌지 않도록 deque
+            std::vector<std::unique_ptr<Page>>  pageStorage; // 만든 페이지
+            std::map<uint32_t, const CharInfo*> others;      // BMP 밖 글자 (wchar_t 가 32비트인 경우)
+
+            CharInfo fallback{}; // 아직 그리지 않은 글자 대신 쓰는 네모. TextureID 가 0 이면 아직 안 만듦
 
-            std::mutex lock;
-            std::map<wchar_t, CharInfo> info;
+            // 해당하는 문자 정보 가져오기. wait 가 false 면 처음 보는 글자는 네모를 반환할 수 있음
+            const CharInfo& getChar(wchar_t c, bool wait = true);
 
-            // 해당하는 문자 정보 가져오기
-            CharInfo getChar(wchar_t c);
+            // 잠그지 않고 찾기. 없으면 nullptr
+            const CharInfo* peek(uint32_t code);
+
+            // 없는 문자를 불러와서 표에 넣기. 기다리지 않으면 백그라운드에 맡기고 네모를 반환
+            const CharInfo& loadChar(wchar_t c, bool wait);
+
+            // 표에 넣기. 이미 있으면 있던 것을 반환. lock 을 잡고 호출
+            const CharInfo& insert(uint32_t code, const CharInfo& info);
         };
 
-        struct MeasureDetail
+
+        // 문자열 배치 결과. 같은 크기, 같은 문자열이면 다시 계산하지 않고 그대로 씀
+        struct Layout
         {
-            v::Size2i              sizeTotal; // 크기
-            std::vector<v::Size2i> size;      // 각 줄의 크기...
-            int                    lines;     // 총 줄 수
+            // 글자 사각형. 줄 시작점 기준
+            struct Glyph
+            {
+                GLuint    TextureID;
+                float     x, y, w, h;
+                v::Rect2f tex; // 텍스쳐 좌표
+            };
+
+            struct Line
+            {
+                v::Size2i size;  // 줄 크기
+                size_t    first; // glyphs 에서 이 줄의 첫 글자
+                size_t    count; // 글자 수
+            };
+
+            v::Size2i          sizeTotal; // 크기
+            std::vector<Line>  lines;     // 각 줄
+            std::vector<Glyph> glyphs;    // 모든 줄의 글자
+
+            std::string source; // 원래 문자열 (바이트). 해시가 겹쳤는지 확인용
+
+            bool complete = true; // 네모 없이 모든 글자가 있음. 네모가 있으면 저장하지 않음
         };
 
         FT_Library ftLibrary = nullptr;
@@ -61,10 +133,38 @@ namespace model
         std::mutex facesLock;
         std::map<int, std::unique_ptr<Face>> faces; // size 별 폰트들 저장된 저장소
 
+        std::mutex layoutsLock;
+        std::unordered_map<uint64_t, std::shared_ptr<const Layout>> layouts; // (크기, 문자열) 별 배치 결과
+
+        // 글자 미리 그리기
+        std::mutex                          warmLock;
+        std::condition_variable             warmCv;
+        std::deque<std::pair<int, wchar_t>> warmRequests;  // 그릴 글자 (크기, 글자)
+        std::set<std::pair<int, uint32_t>>  warmRequested; // 한번 요청한 글자. 다시 요청하지 않음
+        std::vector<Raster>                 warmDone;      // 그려서 올리기를 기다리는 글자
+        std::vector<std::thread>            warmWorkers;
+        bool                                warmStopping = false;
+        std::atomic_size_t                  warmReady    = 0; // warmDone 크기
+
+        std::atomic_bool asyncMisses = false; // 처음 보는 글자를 백그라운드에서 그릴지
+
         GLint shader = 0; // 셰이더
 
         GLuint vao = 0;
         GLuint vbo = 0;
+        size_t vboSize = 0; // vbo 크기 (바이트). 긴 줄이 오면 늘림
+
+        std::vector<float> lineVertices; // 한 줄의 사각형들. 줄마다 새로 할당하지 않도록 재사용
+
+        // 글자 텍스쳐를 모아두는 아틀라스. 한 줄을 텍스쳐 전환 없이 한번에 그리기 위함
+        // 가득 차면 새로 만듦. 렌더링 스레드에서만 씀
+        struct Atlas
+        {
+            GLuint textureId = 0;
+            int    x = 0, y = 0; // 다음 글자를 넣을 위치
+            int    rowHeight = 0; // 지금 줄에서 가장 높은 글자
+        };
+        std::vector<Atlas> atlases;
 
         int uniformText = 0;
         int uniformProjection = 0;
@@ -78,19 +178,35 @@ namespace model
         // Face 가져오는 함수
         Face* getFace(int size);
 
-        // 문자열의 크기나 줄 수 등의 정보를 가져오는 함수
+        // 문자열 배치 (줄 크기, 글자 위치) 를 가져오는 함수. 처음 보는 문자열만 계산함
+        // wait 가 false 면 없는 글자는 기다리지 않고 네모로 배치
         template <typename T>
-        Text::MeasureDetail measureDetail(Face* face, const std::basic_string<T>& str);
+        std::shared_ptr<const Layout> layout(int size, std::basic_string_view<T> str, bool wait);
 
-        // 실제로 렌더링하는 함수
         template <typename T>
-        void drawLine(Face* face, float x, float y, float z, v::Color color, const std::basic_string<T>& str);
+        std::shared_ptr<const Layout> buildLayout(Face* face, std::basic_string_view<T> str, bool wait);
+
+        // 실제로 렌더링하는 함수
+        void drawLine(const Layout& layout, const Layout::Line& line, float x, float y, float z);
+
+        // 비트맵을 글자 아틀라스에 올리기
+        Face::CharInfo createTexture(v::Size2i size, v::Point2i bearing, FT_Pos advance, const unsigned char* pixels);
+
+        // 백그라운드에서 그리도록 요청
+        void request(int size, wchar_t c);
+
+        // 글자 그리는 스레드. FreeType 은 스레드마다 따로 연다
+        void warmLoop();
+
+        // FT_Load_Char 로 그린 글자를 Raster 로 복사
+        static void copyGlyph(FT_GlyphSlot glyph, Raster& r);
 
         // 실제로 렌더링하는 함수
         template <typename T>
         v::Rect2f drawAll(v::Size2f windowSize, v::Rect2f rect, float z, Alignment horizontalAlignment, Alignment verticalAlignment, int size, v::Color color, const std::basic_string<T>& str);
 
         Text() = default;
+        ~Text();
 
     public:
         static Text& instance()
@@ -102,6 +218,28 @@ namespace model
         // 셰이더 초기화
         void init();
 
+        // 글자 비트맵을 바로 그려서 가져오기. 텍스쳐를 직접 만들 때 사용
+        Raster rasterize(int size, wchar_t c);
+
+        // 한 줄 높이
+        int lineHeight(int size);
+
+        // 글자들을 크기별로 백그라운드에서 미리 그려둠. 그린 글자는 upload 에서 올림
+        void warmUp(const std::vector<int>& sizes, const std::wstring& chars);
+
+        // 미리 그린 글자를 최대 count 개 텍스쳐로 올림. 렌더링 스레드에서 매 프레임 호출. 올린 수를 반환
+        size_t upload(size_t count);
+
+        // 올리기를 기다리는 글자가 있는지
+        bool pending() noexcept { return this->warmReady > 0; }
+
+        // 그릴 때 처음 보는 글자를 그 자리에서 그리지 않고 백그라운드에서 그림. 그 동안은 네모로 표시
+        // measure 는 항상 기다리므로, 재고 나서 그리는 글씨 (도움말 등) 는 네모가 나오지 않음
+        void setAsyncMisses(bool value) noexcept { this->asyncMisses = value; }
+
+        // 글자 찾기, 배치, 그리기 속도 측정 (--bench-text). 초당 글자 수 출력
+        void benchmark(std::ostream& os);
+
         // 문자열 크기 계산하는 함수
         v::Size2i measure(int size, const std::string& str);
         v::Size2i measure(int size, const std::wstring& str);
@@ -1,42 +1,212 @@
 ﻿#pragma once
 
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <iostream>
 #include <vector>
 
 #include <glad/glad.h>
 
 #include "constants.h"
+#include "glext.h"
 
 namespace model
 {
-    // 3차원 구체 버텍스 찍는 함수.
-    // indices 마지막에 GL_PRIMITIVE_RESTART = RESTART_INDEX 인거 주의!!!
-    // VVV NNN UV | VVV NNN UV | VVV NNN UV | ...
-    void initSphere(
-        float radius,
+    // 구체 버텍스 하나. 12 바이트
+    // 반지름 1 인 구라서 위치가 곧 법선벡터. 크기는 셰이더에서 반지름을 곱한다.
+    // XYZ (snorm16) _ (패딩) | UV (unorm16)
+    struct SphereVertex
+    {
+        GLshort  x, y, z, w;
+        GLushort u, v;
+    };
+
+    struct SphereMesh
+    {
+        std::vector<SphereVertex> vertices;
+        std::vector<GLuint>       indices;
+    };
+
+    // 같은 버텍스가 캐시에 남아있으면 버텍스 셰이더를 다시 돌리지 않는다.
+    // FIFO 캐시로 흉내내서 버텍스 셰이더가 몇 번 돌았는지 반환
+    inline size_t countVertexShaderRuns(const std::vector<GLuint>& indices, size_t cacheSize)
+    {
+        std::vector<GLuint> cache(cacheSize, static_cast<GLuint>(-1));
+        size_t head = 0;
+        size_t runs = 0;
+
+        for (const auto index : indices)
+        {
+            if (std::find(cache.begin(), cache.end(), index) != cache.end()) continue;
+
+            cache[head] = index;
+            head = (head + 1) % cacheSize;
+            runs++;
+        }
+
+        return runs;
+    }
+
+    // 인덱스 순서를 버텍스 캐시에 맞게 다시 정렬 (Tom Forsyth, Linear-Speed Vertex Cache Optimisation)
+    // 캐시에 있는 버텍스를 쓰는 삼각형, 남은 삼각형이 적은 버텍스를 쓰는 삼각형을 먼저 그린다.
+    inline void optimizeVertexCache(std::vector<GLuint>& indices, size_t vertexCount)
+    {
+        const size_t triCount = indices.size() / 3;
+        if (triCount == 0) return;
+
+        constexpr size_t cacheSize = SPHERE_VERTEX_CACHE_SIZE;
+
+        const auto score = [](int cachePos, int remaining)
+        {
+            // 더 그릴 삼각형이 없으면 관심 없음
+            if (remaining == 0) return -1.0f;
+
+            float s = 0;
+            if (cachePos >= 0)
+            {
+                // 방금 그린 삼각형의 버텍스는 일부러 조금 낮게 줘서 같은 쪽으로만 파고들지 않게 함
+                s = cachePos < 3
+                    ? 0.75f
+                    : std::pow(1.0f - static_cast<float>(cachePos - 3) / (cacheSize - 3), 1.5f);
+            }
+
+            // 남은 삼각형이 적은 버텍스를 빨리 끝내서 외톨이 삼각형이 남지 않게 함
+            return s + 2.0f * std::pow(static_cast<float>(remaining), -0.5f);
+        };
+
+        // 버텍스마다 아직 안 그린 삼각형 목록. [offset, offset + remaining) 이 남은 삼각형
+        std::vector<int>    remaining(vertexCount, 0);
+        std::vector<size_t> offset(vertexCount + 1, 0);
+        for (const auto index : indices) remaining[index]++;
+        for (size_t v = 0; v < vertexCount; v++) offset[v + 1] = offset[v] + remaining[v];
+
+        std::vector<GLuint> vertexTris(indices.size());
+        {
+            std::vector<size_t> fill(offset.begin(), offset.end() - 1);
+            for (size_t t = 0; t < triCount; t++)
+            {
+                for (size_t k = 0; k < 3; k++)
+                {
+                    vertexTris[fill[indices[t * 3 + k]]++] = static_cast<GLuint>(t);
+                }
+            }
+        }
+
+        std::vector<int>   cachePos(vertexCount, -1);
+        std::vector<float> vertexScore(vertexCount);
+        for (size_t v = 0; v < vertexCount; v++) vertexScore[v] = score(-1, remaining[v]);
+
+        std::vector<float> triScore(triCount);
+        std::vector<bool>  triAdded(triCount, false);
+        for (size_t t = 0; t < triCount; t++)
+        {
+            triScore[t] = vertexScore[indices[t * 3 + 0]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+        }
+
+        std::vector<GLuint> result;
+        result.reserve(indices.size());
+
+        std::vector<GLuint> cache;
+        std::vector<GLuint> nextCache;
+
+        size_t first = 0; // 이 앞은 전부 그린 삼각형
+        long   best  = -1;
+
+        while (result.size() < indices.size())
+        {
+            // 캐시에 있는 버텍스로 그릴 삼각형이 없으면 남은 것 중에서 점수가 가장 높은 것
+            if (best < 0)
+            {
+                while (triAdded[first]) first++;
+
+                float bestScore = -1;
+                for (size_t t = first; t < triCount; t++)
+                {
+                    if (!triAdded[t] && triScore[t] > bestScore)
+                    {
+                        bestScore = triScore[t];
+                        best = static_cast<long>(t);
+                    }
+                }
+            }
+
+            // 삼각형 추가
+            const size_t tri = static_cast<size_t>(best);
+            triAdded[tri] = true;
+
+            nextCache.clear();
+            for (size_t k = 0; k < 3; k++)
+            {
+                const auto v = indices[tri * 3 + k];
+                result.push_back(v);
+                nextCache.push_back(v);
+
+                // 버텍스의 남은 삼각형 목록에서 빼기
+                const auto begin = vertexTris.begin() + offset[v];
+                const auto end   = begin + remaining[v];
+                std::iter_swap(std::find(begin, end, static_cast<GLuint>(tri)), end - 1);
+                remaining[v]--;
+            }
+
+            // 방금 쓴 버텍스를 캐시 맨 앞으로
+            for (const auto v : cache)
+            {
+                if (std::find(nextCache.begin(), nextCache.begin() + 3, v) == nextCache.begin() + 3)
+                {
+                    nextCache.push_back(v);
+                }
+            }
+
+            // 캐시 위치가 바뀌었으니 점수 다시 계산. 밀려난 버텍스도 캐시 밖 점수로
+            for (size_t i = 0; i < nextCache.size(); i++)
+            {
+                const auto v = nextCache[i];
+                cachePos[v]    = i < cacheSize ? static_cast<int>(i) : -1;
+                vertexScore[v] = score(cachePos[v], remaining[v]);
+            }
+
+            // 점수가 바뀐 버텍스를 쓰는 삼각형 중 가장 높은 것이 다음 삼각형
+            best = -1;
+            float bestScore = -1;
+            for (const auto v : nextCache)
+            {
+                for (size_t i = offset[v]; i < offset[v] + remaining[v]; i++)
+                {
+                    const auto t = vertexTris[i];
+                    triScore[t] = vertexScore[indices[t * 3 + 0]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+
+                    if (triScore[t] > bestScore)
+                    {
+                        bestScore = triScore[t];
+                        best = static_cast<long>(t);
+                    }
+                }
+            }
+
+            if (nextCache.size() > cacheSize) nextCache.resize(cacheSize);
+            std::swap(cache, nextCache);
+        }
+
+        indices.swap(result);
+    }
+
+    // 반지름 1 인 구체 버텍스 찍는 함수.
+    inline void initSphere(
         int stackCount,
         int sectorCount,
-        std::vector<GLfloat>& vertices,
-        std::vector<GLuint>& indices,
-        bool withNormal,
-        bool withTexCoords = true
+        SphereMesh& mesh
     )
     {
         // 버텍스들 계산하기
         {
-            // 1 버텍스당 데이터 수
-            int v = 3;
-            if (withNormal) v += 3;
-            if (withTexCoords) v += 2;
-
-            // 미리 할당
-            vertices.resize((stackCount + 1) * (sectorCount + 1) * v);
+            mesh.vertices.resize((stackCount + 1) * (sectorCount + 1));
 
             // 메모리로 접근할거임.
-            auto virticesIt = vertices.begin();
+            auto virticesIt = mesh.vertices.begin();
 
-            // 법선벡터 구하는거
-            const float inverseRadius = 1.0f / radius;
+            const auto snorm = [](float v) { return static_cast<GLshort >(std::lround(std::clamp(v, -1.0f, 1.0f) * 32767.0f)); };
+            const auto unorm = [](float v) { return static_cast<GLushort>(std::lround(std::clamp(v,  0.0f, 1.0f) * 65535.0f)); };
 
             for (int stack = 0; stack <= stackCount; stack++)
             {
@@ -44,8 +214,8 @@ namespace model
                 const auto stackAngle = PI_2 - PI * stack / stackCount;
 
                 // 스택 좌표
-                const auto y = radius * std::sinf(stackAngle);
-                const auto xz = radius * std::cosf(stackAngle);
+                const auto y = std::sin(stackAngle);
+                const auto xz = std::cos(stackAngle);
 
                 for (int sector = 0; sector <= sectorCount; sector++)
                 {
@@ -53,28 +223,19 @@ namespace model
                     const auto sectorAngle = PI2 * sector / sectorCount;
 
                     // 현재 섹터 좌표
-                    const auto x = xz * std::sinf(sectorAngle);
-                    const auto z = xz * std::cosf(sectorAngle);
+                    const auto x = xz * std::sin(sectorAngle);
+                    const auto z = xz * std::cos(sectorAngle);
 
                     // 버텍스 설정
-                    *virticesIt++ = x;
-                    *virticesIt++ = y;
-                    *virticesIt++ = z;
-
-                    if (withNormal)
-                    {
-                        // 노말 벡터
-                        *virticesIt++ = x * inverseRadius;
-                        *virticesIt++ = y * inverseRadius;
-                        *virticesIt++ = z * inverseRadius;
-                    }
+                    auto& vertex = *virticesIt++;
+                    vertex.x = snorm(x);
+                    vertex.y = snorm(y);
+                    vertex.z = snorm(z);
+                    vertex.w = 0;
 
                     // 텍스쳐 매핑
-                    if (withTexCoords)
-                    {
-                        *virticesIt++ = static_cast<float>(sector) / stackCount;
-                        *virticesIt++ = static_cast<float>(stack ) / sectorCount;
-                    }
+                    vertex.u = unorm(static_cast<float>(sector) / sectorCount);
+                    vertex.v = unorm(static_cast<float>(stack ) / stackCount );
                 }
             }
         }
@@ -90,6 +251,8 @@ namespace model
         아래 : p12 > p21 > p22
         */
         {
+            auto& indices = mesh.indices;
+
             indices.resize((2 * stackCount - 2) * (sectorCount) * 3);
             auto indicesIt = indices.begin();
 
@@ -122,5 +285,57 @@ namespace model
                 }
             }
         }
+
+        // 줄 단위 순서는 줄이 바뀔 때마다 윗줄 버텍스를 다시 돌리게 되므로 캐시에 맞게 다시 정렬
+        const auto runsBefore = countVertexShaderRuns(mesh.indices, SPHERE_VERTEX_CACHE_SIM_SIZE);
+        optimizeVertexCache(mesh.indices, mesh.vertices.size());
+        const auto runsAfter = countVertexShaderRuns(mesh.indices, SPHERE_VERTEX_CACHE_SIM_SIZE);
+
+        const auto triCount = static_cast<double>(mesh.indices.size() / 3);
+        std::cout << "model : sphere " << stackCount << "x" << sectorCount
+                  << " vertices: " << mesh.vertices.size()
+                  << ", vertex shader runs: " << runsBefore << " -> " << runsAfter
+                  << " (ACMR " << runsBefore / triCount << " -> " << runsAfter / triCount << ")"
+                  << std::endl;
+    }
+
+    // 지금 바인딩된 VertexArray 에 구체 버텍스와 인덱스를 올리고 attribute 설정
+    // 0 : 위치 (= 법선벡터), 1 : 텍스쳐 좌표 (withTexCoords 일 때)
+    // 버텍스가 65536 개 이하면 인덱스는 16 비트. glDrawElements 에 넘길 인덱스 타입을 반환
+    inline GLenum uploadSphere(const SphereMesh& mesh, GLuint& vbo, GLuint& ebo, bool withTexCoords)
+    {
+        // 버텍스 저장
+        glGenBuffers(1, &vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(SphereVertex), mesh.vertices.data(), GL_STATIC_DRAW);
+        glext::countUpload(mesh.vertices.size() * sizeof(SphereVertex));
+
+        // 인덱스 저장
+        GLenum indexType = GL_UNSIGNED_INT;
+
+        glGenBuffers(1, &ebo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        if (mesh.vertices.size() <= 0x10000)
+        {
+            const std::vector<GLushort> indices16(mesh.indices.begin(), mesh.indices.end());
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices16.size() * sizeof(GLushort), indices16.data(), GL_STATIC_DRAW);
+            glext::countUpload(indices16.size() * sizeof(GLushort));
+
+            indexType = GL_UNSIGNED_SHORT;
+        }
+        else
+        {
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(GLuint), mesh.indices.data(), GL_STATIC_DRAW);
+            glext::countUpload(mesh.indices.size() * sizeof(GLuint));
+        }
+
+        // attri 사용 설정
+        glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, sizeof(SphereVertex), (void*)offsetof(SphereVertex, x)); glEnableVertexAttribArray(0);
+        if (withTexCoords)
+        {
+            glVertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(SphereVertex), (void*)offsetof(SphereVertex, u)); glEnableVertexAttribArray(1);
+        }
+
+        return indexType;
     }
 }
@@ -1,10 +1,13 @@
 ﻿#include "orbital.h"
 
+#include <cmath>
+
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
+#include "catalog.h"
 #include "constants.h"
-#include "planet.h"
+#include "ephemeris.h"
 #include "v.h"
 
 // 참고자료
@@ -14,9 +17,6 @@
 
 namespace orbital
 {
-    //constexpr double MOON_AU = au2unit(0.00257f);
-    constexpr double MOON_AU = au2unit(0.0257f);
-
     constexpr double PI   = glm::pi<double>();
     constexpr double PI2  = glm::two_pi<double>();
     constexpr double PI_2 = glm::half_pi<double>();
@@ -26,72 +26,6 @@ namespace orbital
 
     constexpr double daysPerCentry = 100 * 365.25;
 
-    struct Elements
-    {
-        double a; // 장반경
-        double e; // 이심률
-        double I; // 기울기
-        double L; // 평균 경도
-        double Lp; // 근일점 경도
-        double o; // 승교점 적경
-
-        constexpr Elements() : a(0), e(0), I(0), L(0), Lp(0), o(0) { };
-        constexpr Elements(
-            double a,
-            double e,
-            double i,
-            double l,
-            double lp,
-            double o
-        ) : a(au2unit(a)),
-            e(glm::radians(e)),
-            I(glm::radians(i)),
-            L(glm::radians(l)),
-            Lp(glm::radians(lp)),
-            o(glm::radians(o))
-        {
-            // 단위 변경...
-            // degree 는 radian 으로, AU 단위도 내부단위로
-        }
-    };
-    struct J2000
-    {
-        const Elements base;
-        const Elements delta;
-
-        constexpr J2000(Elements base, Elements delta) : base(base), delta(delta)
-        {
-        }
-    };
-
-    // https://ssd.jpl.nasa.gov/txt/p_elem_t1.txt
-    // Keplerian elements and their rates, with respect to the mean ecliptic
-    // and equinox of J2000, valid for the time - interval 1800 AD - 2050 AD.
-    const std::vector<J2000> elements =
-    {
-        { {}, {} }, // 태양
-        //        a              e               I                L            long.peri.      long.node.
-        //    AU, AU/Cy     rad, rad/Cy     deg, deg/Cy      deg, deg/Cy      deg, deg/Cy     deg, deg/Cy
-        { {  0.38709927,     0.20563593,     7.00497902,     252.25032350,    77.45779628,    48.33076593, },
-          {  0.00000037,     0.00001906,    -0.00594749,  149472.67411175,     0.16047689,    -0.12534081, } }, // 수
-        { {  0.72333566,     0.00677672,     3.39467605,     181.97909950,   131.60246718,    76.67984255, },
-          {  0.00000390,    -0.00004107,    -0.00078890,   58517.81538729,     0.00268329,    -0.27769418, } }, // 금
-        { {  1.00000261,     0.01671123,    -0.00001531,     100.46457166,   102.93768193,     0.00000000, },
-          {  0.00000562,    -0.00004392,    -0.01294668,   35999.37244981,     0.32327364,     0.00000000, } }, // 지
-        { {  1.52371034,     0.09339410,     1.84969142,      -4.55343205,   -23.94362959,    49.55953891, },
-          {  0.00001847,    -0.00007882,    -0.00813131,   19140.30268499,     0.44441088,    -0.29257343, } }, // 화
-        { {  5.20288700,     0.04838624,     1.30439695,      34.39644051,    14.72847983,   100.47390909, },
-          { -0.00011607,    -0.00013253,    -0.00183714,    3034.74612775,     0.21252668,     0.20469106, } }, // 목
-        { {  9.53667594,     0.05386179,     2.48599187,      49.95424423,    92.59887831,   113.66242448, },
-          { -0.00125060,    -0.00050991,     0.00193609,    1222.49362201,    -0.41897216,    -0.28867794, } }, // 토
-        { { 19.18916464,     0.04725744,     0.77263783,     313.23810451,   170.95427630,    74.01692503, },
-          { -0.00196176,    -0.00004397,    -0.00242939,     428.48202785,     0.40805281,     0.04240589, } }, // 천
-        { { 30.06992276,     0.00859048,     1.77004347,     -55.12002969,    44.96476227,   131.78422574, },
-          {  0.00026291,     0.00005105,     0.00035372,     218.45945325,    -0.32241464,    -0.00508664, } }, // 해
-        { { 39.48211675,     0.24882730,    17.14001206,     238.92903833,   224.06891629,   110.30393684, },
-          { -0.00031596,     0.00005170,     0.00004818,     145.20780515,    -0.04062942,    -0.01183482, } }, // 명
-    };
-
     double getEccentricity(const double M, const double e) {
         double M1 = 0;
         double M2 = M;
@@ -108,54 +42,31 @@ namespace orbital
         return M2;
     }
 
-    glm::vec4 getCurrentPosition(int planetIndex, double days)
+    // 지정한 날짜의 케플러 궤도 요소
+    catalog::Elements getElements(int planetIndex, double days)
     {
-        // 달은 비교적 정확하지 않은 궤도를 그리기 때문에 궤도를 표시하기 어려운 관계로 고정궤도로 이동시킴.
-        if (planetIndex == planet::PlanetIndex::Moon)
-        {
-            // https://en.wikipedia.org/wiki/Orbit_of_the_Moon#/media/File:Lunar_Orbit_and_Orientation_with_respect_to_the_Ecliptic.tif
-            // 5.14 도 기울게
-            constexpr auto sy = 0.0895896429900152875272158894646;  // sin 5.14
-            constexpr auto cy = 0.99597876275999058304925149124373; // cos 5.14
-
-            const auto theta = PI2 * std::fmod(days, 27.321f) / 27.321f;
-
-            const auto c = std::cos(theta);
-            const auto s = std::sin(theta);
-
-            return glm::vec4(
-                MOON_AU * c * cy,
-                MOON_AU * c * sy,
-                MOON_AU * -s,
-                glm::degrees(theta)
-            );
-        }
-
-        const J2000 kec = elements.at(planetIndex);
+        const auto& bodies = catalog::bodies();
 
-        auto ke = kec.base;
+        const auto& rate = bodies.rates.at(planetIndex);
+        auto ke = bodies.elements.at(planetIndex);
 
         // 2.
-        {
-            const auto delta = days / daysPerCentry;
-
-            ke.a  += kec.delta.a  * delta;
-            ke.e  += kec.delta.e  * delta;
-            ke.I  += kec.delta.I  * delta;
-            ke.L  += kec.delta.L  * delta;
-            ke.Lp += kec.delta.Lp * delta;
-            ke.o  += kec.delta.o  * delta;
-        }
+        const auto delta = days / daysPerCentry;
 
-        // 3.
-        const auto w = ke.Lp - ke.o;
-        const auto M = std::fmod(ke.L - ke.Lp, PI2) - PI;
+        ke.a  += rate.a  * delta;
+        ke.e  += rate.e  * delta;
+        ke.I  += rate.I  * delta;
+        ke.L  += rate.L  * delta;
+        ke.Lp += rate.Lp * delta;
+        ke.o  += rate.o  * delta;
 
-        // 4.
-        const auto E = getEccentricity(M, ke.e);
+        return ke;
+    }
 
-        const double x = ke.a * (glm::cos(E) - ke.e);
-        const double y = ke.a * (glm::sqrt(1 - ke.e * ke.e) * glm::sin(E));
+    // 궤도면 좌표 (x, y) 를 황도 좌표로 바꾸는 기저 벡터 P, Q
+    void getOrbitBasis(const catalog::Elements& ke, glm::dvec3& P, glm::dvec3& Q)
+    {
+        const auto w = ke.Lp - ke.o;
 
         const double cosw = glm::cos(w);
         const double sinw = glm::sin(w);
@@ -164,19 +75,111 @@ namespace orbital
         const double cosI = glm::cos(ke.I);
         const double sinI = glm::sin(ke.I);
 
-        const double Xecl = (cosw * cosO - sinw * sinO * cosI) * x + (-sinw * cosO - cosw * sinO * cosI) * y;
-        const double Yecl = (cosw * sinO + sinw * cosO * cosI) * x + (-sinw * sinO + cosw * cosO * cosI) * y;
-        const double Zecl =                      (sinw * sinI) * x +                       (cosw * sinI) * y;
+        P = glm::dvec3( cosw * cosO - sinw * sinO * cosI,  cosw * sinO + sinw * cosO * cosI, sinw * sinI);
+        Q = glm::dvec3(-sinw * cosO - cosw * sinO * cosI, -sinw * sinO + cosw * cosO * cosI, cosw * sinI);
+    }
 
-        double v = glm::atan(y, x);
+    // 황도 좌표 -> opengl 좌표
+    glm::vec4 toOpenGL(const glm::dvec3& ecl, double v)
+    {
         if (v < 0) v = PI2 + v;
 
-        //Result array
         return glm::vec4(
-            Xecl,
-            Zecl, // Y 축으로 회전시키기 위해서 Z 축과 Y 축 교환
-            -Yecl, // opengl 의 y 축은 밑에서부터.
+            ecl.x,
+            ecl.z, // Y 축으로 회전시키기 위해서 Z 축과 Y 축 교환
+            -ecl.y, // opengl 의 y 축은 밑에서부터.
             glm::degrees(v)
         );
     }
+
+    // 기울어진 원 궤도 위의 점. theta 는 궤도 위의 각도 (radian)
+    glm::vec4 getCircularPosition(const catalog::Elements& ke, double theta)
+    {
+        const auto sy = std::sin(ke.I);
+        const auto cy = std::cos(ke.I);
+
+        const auto c = std::cos(theta);
+        const auto s = std::sin(theta);
+
+        return glm::vec4(
+            ke.a * c * cy,
+            ke.a * c * sy,
+            ke.a * -s,
+            glm::degrees(theta)
+        );
+    }
+
+    glm::vec4 getCurrentPosition(int planetIndex, double days)
+    {
+        const auto& bodies = catalog::bodies();
+
+        switch (bodies.orbitType.at(planetIndex))
+        {
+        case catalog::OrbitNone:
+            return glm::vec4(0, 0, 0, 0);
+
+        case catalog::OrbitCircular:
+        {
+            // 기울어진 원 궤도.
+            // 달은 비교적 정확하지 않은 궤도를 그리기 때문에 궤도를 표시하기 어려운 관계로 고정궤도로 이동시킴.
+            // https://en.wikipedia.org/wiki/Orbit_of_the_Moon#/media/File:Lunar_Orbit_and_Orientation_with_respect_to_the_Ecliptic.tif
+            const auto& ke = bodies.elements.at(planetIndex);
+            const double period = bodies.resolutionPeriod.at(planetIndex);
+
+            return getCircularPosition(ke, ke.L + PI2 * std::fmod(days, period) / period);
+        }
+        }
+
+        const auto ke = getElements(planetIndex, days);
+
+        // 3.
+        // 평균 근점이각은 -PI ~ PI 사이로
+        auto M = std::fmod(ke.L - ke.Lp, PI2);
+        if (M >  PI) M -= PI2;
+        if (M < -PI) M += PI2;
+
+        // 4.
+        const auto E = getEccentricity(M, ke.e);
+
+        const double x = ke.a * (glm::cos(E) - ke.e);
+        const double y = ke.a * (glm::sqrt(1 - ke.e * ke.e) * glm::sin(E));
+
+        glm::dvec3 P, Q;
+        getOrbitBasis(ke, P, Q);
+
+        //Result array
+        return toOpenGL(P * x + Q * y, glm::atan(y, x));
+    }
+
+    glm::vec4 getPrecisePosition(int planetIndex, double days, double threshold)
+    {
+        glm::dvec3 ecl;
+        if (!ephemeris::getPosition(planetIndex, days, threshold, ecl))
+        {
+            return getCurrentPosition(planetIndex, days);
+        }
+
+        const auto& bodies = catalog::bodies();
+
+        if (bodies.orbitType.at(planetIndex) == catalog::OrbitCircular)
+        {
+            // 원 궤도로 표시하는 천체 (달) 는 궤도선을 원으로 그리므로 급수에서는 각도만 가져와서 원 궤도 위에 놓음.
+            // 실제 위치를 쓰면 거리, 황위가 달라서 궤도선에서 벗어나 보임
+            const auto& ke = bodies.elements.at(planetIndex);
+
+            // getCurrentPosition 의 theta 와 같은 기준
+            auto theta = glm::atan(ecl.y, ecl.x / std::cos(ke.I));
+            if (theta < 0) theta += PI2;
+
+            return getCircularPosition(ke, theta);
+        }
+
+        ecl = glm::dvec3(au2unit(ecl.x), au2unit(ecl.y), au2unit(ecl.z));
+
+        // 궤도 그라데이션이 어긋나지 않도록 각도는 케플러 궤도면에 투영해서 구함
+        glm::dvec3 P, Q;
+        getOrbitBasis(getElements(planetIndex, days), P, Q);
+
+        return toOpenGL(ecl, glm::atan(glm::dot(Q, ecl), glm::dot(P, ecl)));
+    }
 }
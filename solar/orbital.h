@@ -8,4 +8,9 @@ namespace orbital
     // 기준은 J2000, 2050 년까지 유효.
     // 마지막 값은 진근점이각
     glm::vec4 getCurrentPosition(int planetIndex, double days);
+
+    // 급수 (ephemeris) 로 계산한 위치. 급수가 없는 천체는 getCurrentPosition 과 같음.
+    // threshold : 진폭이 이 값 (AU) 보다 작은 항은 계산하지 않음
+    // 마지막 값은 현재 궤도 요소 기준의 진근점이각
+    glm::vec4 getPrecisePosition(int planetIndex, double days, double threshold);
 }
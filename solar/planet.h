@@ -2,9 +2,11 @@
 #pragma once
 
 #include <functional>
+#include <vector>
 
 #include <glm/mat4x4.hpp>
 
+#include "catalog.h"
 #include "glext.h"
 #include "v.h"
 
@@ -12,6 +14,8 @@ namespace planet
 {
     class Planet;
 
+    // 기본 천체 목록 (resources/bodies.txt) 의 순서.
+    // 단축키 처럼 특정 천체를 가리켜야 할 때만 사용하고, 천체별 처리는 catalog::Material 로 한다.
     enum PlanetIndex
     {
         None = -1,
@@ -28,42 +32,45 @@ namespace planet
         Moon,    // 달
     };
 
-    // 행성 목록. planet.cpp 에 선언되어 있음.
+    // 행성 목록. catalog 를 읽어서 init 에서 만든다.
     extern std::vector<Planet> planetList;
 
+    // 천체 목록 읽고 planetList 만들기
+    void init();
+
     class Planet
     {
     public:
         /****************************************************************************************************/
-        // 행성 기본 정보
+        // 행성 기본 정보는 catalog 에 있음
 
         int const _index; // 행성 Index
-        v::Color const _color; // 행성 궤도 고유 색
-
-        const char* const _name; // 이름
 
-        float const _radius; // 행성 반지름
+        const char* name()    const { return catalog::bodies().name   (this->_index); } // 이름
+        const char* texture() const { return catalog::bodies().texture(this->_index); } // 텍스쳐 이름. 없으면 빈 문자열
 
-        float const _resolutionPeriod; // 공전 주기
-        float const _rotationPeriod;   // 자전 주기
+        v::Color color()            const { return static_cast<int>(catalog::bodies().color.at(this->_index)); } // 행성 궤도 고유 색
+        float    radius()           const { return catalog::bodies().radius          .at(this->_index); } // 행성 반지름
+        float    resolutionPeriod() const { return catalog::bodies().resolutionPeriod.at(this->_index); } // 공전 주기
+        double   rotationPeriod()   const { return catalog::bodies().rotationPeriod  .at(this->_index); } // 자전 주기
+        float    angleRad()         const { return catalog::bodies().tilt            .at(this->_index); } // 자전축 12시 0
+        double   rotationPhase()    const { return catalog::bodies().rotationPhase   .at(this->_index); } // J2000 시점의 자전 위상. 0 ~ 1
+        int      parentIndex()      const { return catalog::bodies().parent          .at(this->_index); } // 부모 행성
 
-        float const _angleRad; // 자전축 12시 0
-
-        int const _parentIndex; // 부모 행성
+        bool hasMaterial(uint32_t material) const { return (catalog::bodies().material.at(this->_index) & material) != 0; }
 
         /****************************************************************************************************/
         // 행성 위치 정보
 
-        double rotationSum = 0; // 자전 delta 누적값
         float rotationThetaRad = 0; // 자전 각도
 
         /****************************************************************************************************/
 
         // Planet 초기화용 생성자
-        Planet(int index, v::Color color, const char* name, float diameter, float resolutionPeriod, float rotationPeriod, float angle, int parentIndex);
+        explicit Planet(int index);
 
-        // 현재 위치 계산하는 함수
-        void addDays(double dayDelta);
+        // 현재 자전 각도 계산하는 함수. 누적하지 않고 J2000 기준 일 수로 바로 계산한다.
+        void setDays(double days);
 
         // 자전용 LocalMatrix 가져오는 함수. axisOnly 가 true 면 자전축만큼만 회전합니다.
         glm::mat4 getLocalMatrix(bool axisOnly) const;
@@ -78,18 +85,11 @@ namespace planet
         >
         constexpr void foreach(STD_FUNCTION_T const& f, Targs... Fargs) const
         {
-            for (size_t subIndex = 0; subIndex < planet::planetList.size(); subIndex++)
+            // 자식 목록만 돈다
+            for (const auto subIndex : catalog::children(this->_index))
             {
-                // 같은 행성 처리 안함
-                if (subIndex == this->_index) continue;
-
-                // 자식 행성 처리
-                if (planet::planetList.at(subIndex)._parentIndex == this->_index)
-                {
-                    f(Fargs..., static_cast<int>(subIndex));
-                }
+                f(Fargs..., static_cast<int>(subIndex));
             }
         }
     };
 }
-
@@ -0,0 +1,504 @@
+﻿#include "platform.h"
+
+#include <array>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+#ifdef PLATFORM_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#ifdef PLATFORM_OSMESA
+#include <GL/osmesa.h>
+#endif
+
+#include "constants.h"
+#include "defer.h"
+
+namespace platform
+{
+    Backend current = Backend::Window;
+
+    v::Size2i screenSize;   // 처음 만든 크기. 창이 없으면 이 크기로 고정
+
+    // Window
+    GLFWwindow* mainWindow = nullptr;
+
+    // 공유 컨텍스트용 숨겨진 창. glfwDestroyWindow 는 메인 스레드에서만 호출할 수 있어서 종료할 때 한번에 지운다.
+    std::mutex sharedWindowsLock;
+    std::vector<GLFWwindow*> sharedWindows;
+
+    // 창 없는 백엔드가 그리는 곳
+    GLuint fbo = 0;
+    GLuint rboColor = 0;
+    GLuint rboDepth = 0;
+
+#ifdef PLATFORM_EGL
+    EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+    EGLConfig  eglConfig  = nullptr;
+    EGLContext eglContext = EGL_NO_CONTEXT;
+    EGLSurface eglSurface = EGL_NO_SURFACE;
+
+    // OpenGL 3.3 Core
+    constexpr std::array<EGLint, 7> EGL_CONTEXT_ATTRIBS = {
+        EGL_CONTEXT_MAJOR_VERSION,       3,
+        EGL_CONTEXT_MINOR_VERSION,       3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE,
+    };
+
+    // 컨텍스트를 붙여둘 최소 크기 pbuffer. 실제로 그리는 곳은 FBO
+    constexpr std::array<EGLint, 5> EGL_PBUFFER_ATTRIBS = {
+        EGL_WIDTH,  1,
+        EGL_HEIGHT, 1,
+        EGL_NONE,
+    };
+#endif
+
+#ifdef PLATFORM_OSMESA
+    OSMesaContext osmesaContext = nullptr;
+    std::vector<GLubyte> osmesaBuffer;
+
+    constexpr std::array<int, 13> OSMESA_CONTEXT_ATTRIBS = {
+        OSMESA_FORMAT,                OSMESA_RGBA,
+        OSMESA_DEPTH_BITS,            24,
+        OSMESA_PROFILE,               OSMESA_CORE_PROFILE,
+        OSMESA_CONTEXT_MAJOR_VERSION, 3,
+        OSMESA_CONTEXT_MINOR_VERSION, 3,
+        0, 0, 0,
+    };
+#endif
+
+    /**************************************************************************************************************/
+
+    Backend parseBackend(const std::string& name)
+    {
+        if (name == "window") return Backend::Window;
+        if (name == "egl"   ) return Backend::EGL;
+        if (name == "osmesa") return Backend::OSMesa;
+
+        throw std::runtime_error("Unknown backend: " + name);
+    }
+
+    void initWindow(v::Size2i size)
+    {
+        // glfw 초기화
+        if (glfwInit() != GLFW_TRUE)
+        {
+            throw std::runtime_error(std::string("Failed to initialize GLFW. error-code :") + std::to_string(glfwGetError(nullptr)));
+        }
+
+        // 사용할 OpenGL 버전 명시.
+        glfwWindowHint(GLFW_SAMPLES,               OPENGL_MSAA_SAMPLES     ); // 안티엘리어싱
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3                       ); // OpenGL 3.3
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3                       );
+        glfwWindowHint(GLFW_OPENGL_PROFILE,        GLFW_OPENGL_CORE_PROFILE); // deprecated API 사용하지 않기
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE                 ); // deprecated API 제외하기
+
+        // glfw 윈도우 생성
+        glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+        mainWindow = glfwCreateWindow(size.w, size.h, WINDOW_CAPTION, nullptr, nullptr);
+        if (mainWindow == nullptr)
+        {
+            throw std::runtime_error("Failed to create GLFW window.");
+        }
+        glfwMakeContextCurrent(mainWindow);
+
+        // glad 초기화
+        if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress)))
+        {
+            throw std::runtime_error("Failed to initialize Glad");
+        }
+
+        std::cout << "GLFW version : " << glfwGetVersionString() << std::endl;
+    }
+
+#ifdef PLATFORM_EGL
+    // X 서버 없이 쓸 디스플레이. Mesa 는 기본 디스플레이가 X 에 붙으려다 실패하므로 surfaceless 플랫폼을 씀
+    EGLDisplay getHeadlessDisplay()
+    {
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+        const auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (getPlatformDisplay != nullptr)
+        {
+            return getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+#endif
+        return EGL_NO_DISPLAY;
+    }
+
+    void initEGL()
+    {
+        eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, nullptr, nullptr))
+        {
+            eglDisplay = getHeadlessDisplay();
+        }
+        if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, nullptr, nullptr))
+        {
+            throw std::runtime_error("Failed to initialize EGL. error-code: " + std::to_string(eglGetError()));
+        }
+
+        constexpr std::array<EGLint, 13> configAttribs = {
+            EGL_SURFACE_TYPE,    EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_RED_SIZE,        8,
+            EGL_GREEN_SIZE,      8,
+            EGL_BLUE_SIZE,       8,
+            EGL_DEPTH_SIZE,      24,
+            EGL_NONE,
+        };
+
+        EGLint count = 0;
+        if (!eglChooseConfig(eglDisplay, configAttribs.data(), &eglConfig, 1, &count) || count == 0)
+        {
+            throw std::runtime_error("Failed to choose EGL config.");
+        }
+
+        if (!eglBindAPI(EGL_OPENGL_API))
+        {
+            throw std::runtime_error("EGL does not support desktop OpenGL.");
+        }
+
+        eglSurface = eglCreatePbufferSurface(eglDisplay, eglConfig, EGL_PBUFFER_ATTRIBS.data());
+        eglContext = eglCreateContext(eglDisplay, eglConfig, EGL_NO_CONTEXT, EGL_CONTEXT_ATTRIBS.data());
+        if (eglSurface == EGL_NO_SURFACE || eglContext == EGL_NO_CONTEXT)
+        {
+            throw std::runtime_error("Failed to create EGL context. error-code: " + std::to_string(eglGetError()));
+        }
+
+        eglMakeCurrent(eglDisplay, eglSurface, eglSurface, eglContext);
+
+        if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress)))
+        {
+            throw std::runtime_error("Failed to initialize Glad");
+        }
+
+        std::cout << "EGL version : " << eglQueryString(eglDisplay, EGL_VERSION) << std::endl;
+    }
+#endif
+
+#ifdef PLATFORM_OSMESA
+    void initOSMesa()
+    {
+        osmesaContext = OSMesaCreateContextAttribs(OSMESA_CONTEXT_ATTRIBS.data(), nullptr);
+        if (osmesaContext == nullptr)
+        {
+            throw std::runtime_error("Failed to create OSMesa context.");
+        }
+
+        // 기본 버퍼는 쓰지 않지만 makeCurrent 하려면 필요함
+        osmesaBuffer.resize(4);
+        if (!OSMesaMakeCurrent(osmesaContext, osmesaBuffer.data(), GL_UNSIGNED_BYTE, 1, 1))
+        {
+            throw std::runtime_error("Failed to make OSMesa context current.");
+        }
+
+        if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(OSMesaGetProcAddress)))
+        {
+            throw std::runtime_error("Failed to initialize Glad");
+        }
+    }
+#endif
+
+    // 창 대신 그릴 프레임버퍼
+    void initFramebuffer(v::Size2i size)
+    {
+        glGenRenderbuffers(1, &rboColor);
+        glBindRenderbuffer(GL_RENDERBUFFER, rboColor);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size.w, size.h);
+
+        glGenRenderbuffers(1, &rboDepth);
+        glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size.w, size.h);
+
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, rboColor);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,  GL_RENDERBUFFER, rboDepth);
+
+        const auto frameBufferStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        if (frameBufferStatus != GL_FRAMEBUFFER_COMPLETE)
+            throw std::runtime_error(std::string("Framebuffer is not complete!") + std::to_string(frameBufferStatus));
+    }
+
+    void init(Backend backend, v::Size2i size)
+    {
+        current = backend;
+        screenSize = size;
+
+        switch (backend)
+        {
+        case Backend::Window:
+            initWindow(size);
+            break;
+
+        case Backend::EGL:
+#ifdef PLATFORM_EGL
+            initEGL();
+            break;
+#else
+            throw std::runtime_error("EGL backend is not built. define PLATFORM_EGL.");
+#endif
+
+        case Backend::OSMesa:
+#ifdef PLATFORM_OSMESA
+            initOSMesa();
+            break;
+#else
+            throw std::runtime_error("OSMesa backend is not built. define PLATFORM_OSMESA.");
+#endif
+        }
+
+        if (headless())
+        {
+            initFramebuffer(size);
+        }
+    }
+
+    void terminate()
+    {
+        if (fbo != 0)
+        {
+            glDeleteFramebuffers(1, &fbo);
+            glDeleteRenderbuffers(1, &rboColor);
+            glDeleteRenderbuffers(1, &rboDepth);
+            fbo = rboColor = rboDepth = 0;
+        }
+
+        switch (current)
+        {
+        case Backend::Window:
+        {
+            std::lock_guard<std::mutex> __lock(sharedWindowsLock);
+            for (const auto window : sharedWindows) glfwDestroyWindow(window);
+            sharedWindows.clear();
+
+            glfwTerminate();
+            mainWindow = nullptr;
+            break;
+        }
+
+        case Backend::EGL:
+#ifdef PLATFORM_EGL
+            eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            eglDestroyContext(eglDisplay, eglContext);
+            eglDestroySurface(eglDisplay, eglSurface);
+            eglTerminate(eglDisplay);
+#endif
+            break;
+
+        case Backend::OSMesa:
+#ifdef PLATFORM_OSMESA
+            OSMesaDestroyContext(osmesaContext);
+            osmesaContext = nullptr;
+#endif
+            break;
+        }
+    }
+
+    /**************************************************************************************************************/
+
+    Backend backend() noexcept
+    {
+        return current;
+    }
+
+    bool headless() noexcept
+    {
+        return current != Backend::Window;
+    }
+
+    GLFWwindow* window() noexcept
+    {
+        return mainWindow;
+    }
+
+    v::Size2i size() noexcept
+    {
+        return screenSize;
+    }
+
+    GLuint framebuffer() noexcept
+    {
+        return fbo;
+    }
+
+    /**************************************************************************************************************/
+    // 백그라운드에서 텍스쳐를 가져오기 위한 부분
+    // glext.h 참조.
+
+    Context createSharedContext()
+    {
+        Context ctx;
+
+        switch (current)
+        {
+        case Backend::Window:
+        {
+            // 보이지 않는 창을 만들어서 컨텍스트만 사용. 버전 힌트는 메인 창 만들 때 설정한 값 그대로
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+            defer(glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE));
+
+            const auto window = glfwCreateWindow(1, 1, WINDOW_CAPTION, nullptr, mainWindow);
+            if (window == nullptr)
+            {
+                throw std::runtime_error("Failed to create shared context.");
+            }
+
+            std::lock_guard<std::mutex> __lock(sharedWindowsLock);
+            sharedWindows.push_back(window);
+
+            ctx.handle = window;
+            break;
+        }
+
+        case Backend::EGL:
+#ifdef PLATFORM_EGL
+            ctx.handle  = eglCreateContext(eglDisplay, eglConfig, eglContext, EGL_CONTEXT_ATTRIBS.data());
+            ctx.surface = eglCreatePbufferSurface(eglDisplay, eglConfig, EGL_PBUFFER_ATTRIBS.data());
+            if (ctx.handle == EGL_NO_CONTEXT || ctx.surface == EGL_NO_SURFACE)
+            {
+                throw std::runtime_error("Failed to create shared context. error-code: " + std::to_string(eglGetError()));
+            }
+#endif
+            break;
+
+        case Backend::OSMesa:
+#ifdef PLATFORM_OSMESA
+            ctx.handle  = OSMesaCreateContextAttribs(OSMESA_CONTEXT_ATTRIBS.data(), osmesaContext);
+            ctx.surface = new GLubyte[4];
+            if (ctx.handle == nullptr)
+            {
+                throw std::runtime_error("Failed to create shared context.");
+            }
+#endif
+            break;
+        }
+
+        return ctx;
+    }
+
+    void makeCurrent(const Context& ctx)
+    {
+        switch (current)
+        {
+        case Backend::Window:
+            glfwMakeContextCurrent(static_cast<GLFWwindow*>(ctx.handle));
+            break;
+
+        case Backend::EGL:
+#ifdef PLATFORM_EGL
+            eglMakeCurrent(eglDisplay, ctx.surface, ctx.surface, ctx.handle);
+#endif
+            break;
+
+        case Backend::OSMesa:
+#ifdef PLATFORM_OSMESA
+            OSMesaMakeCurrent(static_cast<OSMesaContext>(ctx.handle), ctx.surface, GL_UNSIGNED_BYTE, 1, 1);
+#endif
+            break;
+        }
+    }
+
+    void release(const Context& ctx)
+    {
+        switch (current)
+        {
+        case Backend::Window:
+            // 창은 terminate 에서 지움
+            glfwMakeContextCurrent(nullptr);
+            break;
+
+        case Backend::EGL:
+#ifdef PLATFORM_EGL
+            eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            eglDestroyContext(eglDisplay, ctx.handle);
+            eglDestroySurface(eglDisplay, ctx.surface);
+#endif
+            break;
+
+        case Backend::OSMesa:
+#ifdef PLATFORM_OSMESA
+            OSMesaDestroyContext(static_cast<OSMesaContext>(ctx.handle));
+            delete[] static_cast<GLubyte*>(ctx.surface);
+#endif
+            break;
+        }
+    }
+
+    /**************************************************************************************************************/
+
+    void detachContext()
+    {
+        if (mainWindow != nullptr) glfwMakeContextCurrent(nullptr);
+    }
+
+    void attachContext()
+    {
+        if (mainWindow != nullptr) glfwMakeContextCurrent(mainWindow);
+    }
+
+    bool shouldClose()
+    {
+        return mainWindow != nullptr && glfwWindowShouldClose(mainWindow);
+    }
+
+    void requestClose()
+    {
+        if (mainWindow != nullptr)
+        {
+            glfwSetWindowShouldClose(mainWindow, GLFW_TRUE);
+            glfwPostEmptyEvent();
+        }
+    }
+
+    void swapBuffers()
+    {
+        if (mainWindow != nullptr)
+        {
+            glfwSwapBuffers(mainWindow);
+        }
+        else
+        {
+            // 화면에 보낼 곳이 없으니 다 그릴 때 까지만 기다림
+            glFinish();
+        }
+    }
+
+    void pollEvents()
+    {
+        if (mainWindow != nullptr) glfwPollEvents();
+    }
+
+    void waitEvents(double timeout)
+    {
+        if (mainWindow != nullptr) glfwWaitEventsTimeout(timeout);
+    }
+
+    void setSwapInterval(int interval)
+    {
+        if (mainWindow != nullptr) glfwSwapInterval(interval);
+    }
+
+    void showError(const char* message)
+    {
+        std::cerr << message << std::endl;
+
+#ifdef _WIN32
+        if (!headless())
+        {
+            MessageBoxA(NULL, message, WINDOW_CAPTION, MB_OK | MB_ICONERROR);
+        }
+#endif
+    }
+}
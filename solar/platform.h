@@ -0,0 +1,68 @@
+﻿// 창, OpenGL 컨텍스트 관리
+// 창을 띄우는 GLFW 와, 창 없이 FBO 에 그리는 EGL / OSMesa 를 같은 방식으로 사용한다.
+// EGL, OSMesa 는 PLATFORM_EGL, PLATFORM_OSMESA 를 정의하고 빌드해야 사용할 수 있음.
+
+#pragma once
+
+#include <string>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "v.h"
+
+namespace platform
+{
+    enum class Backend
+    {
+        Window, // GLFW 창
+        EGL,    // 창 없음. EGL pbuffer + FBO. GPU 가 없으면 Mesa llvmpipe 사용
+        OSMesa, // 창 없음. Mesa 소프트웨어 렌더러 + FBO
+    };
+
+    // 백그라운드 로딩용 공유 컨텍스트. 백엔드마다 들어있는 값이 다름.
+    struct Context
+    {
+        void* handle  = nullptr; // GLFWwindow*, EGLContext, OSMesaContext
+        void* surface = nullptr; // EGLSurface, OSMesa 용 버퍼
+    };
+
+    // 이름으로 백엔드 찾기. window, egl, osmesa
+    Backend parseBackend(const std::string& name);
+
+    // 메인 컨텍스트 생성 및 glad 초기화. 실패하면 예외 발생.
+    void init(Backend backend, v::Size2i size);
+    void terminate();
+
+    Backend backend() noexcept;
+    bool    headless() noexcept;
+
+    // 창. 창이 없는 백엔드면 nullptr
+    GLFWwindow* window() noexcept;
+
+    // 처음 만든 화면 크기
+    v::Size2i size() noexcept;
+
+    // 화면 대신 그릴 프레임버퍼. 창이 있으면 0
+    GLuint framebuffer() noexcept;
+
+    // 메인 컨텍스트와 리소스를 공유하는 컨텍스트. 메인 스레드에서 생성하고
+    // 사용할 스레드에서 makeCurrent, 다 쓰면 그 스레드에서 release 한다.
+    Context createSharedContext();
+    void    makeCurrent(const Context& ctx);
+    void    release(const Context& ctx);
+
+    // 메인 컨텍스트를 다른 스레드로 넘길 때. 지금 스레드에서 떼고, 쓸 스레드에서 붙인다. 창 백엔드에서만 사용
+    void detachContext();
+    void attachContext();
+
+    bool shouldClose();
+    void requestClose(); // 아무 스레드에서나 호출 가능. 이벤트 대기중인 메인 스레드를 깨움
+    void swapBuffers();
+    void pollEvents();
+    void waitEvents(double timeout); // 이벤트가 올 때 까지 최대 timeout 초 대기. 창이 없으면 바로 반환
+    void setSwapInterval(int interval);
+
+    // 오류 표시. 창이 있으면 메시지 박스, 아니면 표준 오류
+    void showError(const char* message);
+}
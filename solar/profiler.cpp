@@ -0,0 +1,201 @@
+﻿#include "profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+
+#include <glad/glad.h>
+
+#include "constants.h"
+
+namespace profiler
+{
+    // 구간 기록 하나
+    struct Record
+    {
+        const char* name;
+        int depth;
+    };
+
+    // 프레임 하나 분량의 쿼리
+    struct Frame
+    {
+        uint64_t number = 0;
+        std::array<GLuint, PROFILER_MAX_SCOPES * 2> queries{}; // 시작, 끝
+        std::array<Record, PROFILER_MAX_SCOPES>     records{};
+        int count = 0;
+        bool pending = false; // 아직 결과를 읽지 않음
+    };
+
+    // CSV 용 기록
+    struct Row
+    {
+        uint64_t frame;
+        int      result;
+        double   ms;
+    };
+
+    bool on = false;
+    bool initialized = false;
+    bool inFrame = false;
+
+    std::array<Frame, PROFILER_FRAME_LATENCY> frames;
+    uint64_t frameNumber = 0;
+
+    Frame* current = nullptr;
+    int depth = 0;
+
+    std::vector<Result> resultList;
+    std::deque<Row> history;
+
+    /**************************************************************************************************************/
+
+    void setEnabled(bool enabled)
+    {
+        on = enabled;
+    }
+
+    bool enabled() noexcept
+    {
+        return on;
+    }
+
+    int findResult(const char* name, int depth)
+    {
+        for (size_t i = 0; i < resultList.size(); i++)
+        {
+            const auto& r = resultList.at(i);
+            if (r.depth == depth && std::strcmp(r.name.c_str(), name) == 0) return static_cast<int>(i);
+        }
+
+        resultList.push_back(Result{ name, depth, 0, 0, 0 });
+        return static_cast<int>(resultList.size() - 1);
+    }
+
+    // 돌아온 슬롯의 결과 읽기. PROFILER_FRAME_LATENCY 프레임 전 것이라 대부분 바로 나옴
+    void resolve(Frame& frame)
+    {
+        if (!frame.pending) return;
+        frame.pending = false;
+
+        // 이번 프레임에 나온 이름별 합계
+        std::vector<std::pair<int, double>> sums;
+
+        for (int i = 0; i < frame.count; i++)
+        {
+            GLuint64 begin = 0, end = 0;
+            glGetQueryObjectui64v(frame.queries.at(i * 2    ), GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(frame.queries.at(i * 2 + 1), GL_QUERY_RESULT, &end);
+
+            const auto& record = frame.records.at(i);
+            const int index = findResult(record.name, record.depth);
+            const double ms = (end - begin) / 1e6;
+
+            const auto it = std::find_if(sums.begin(), sums.end(), [index](const auto& s) { return s.first == index; });
+            if (it == sums.end()) sums.emplace_back(index, ms);
+            else                  it->second += ms;
+        }
+
+        for (const auto& [index, ms] : sums)
+        {
+            auto& r = resultList.at(index);
+            r.lastMs = ms;
+            r.avgMs  = r.avgMs == 0 ? ms : r.avgMs + (ms - r.avgMs) * PROFILER_AVERAGE_WEIGHT;
+            r.maxMs  = std::max(r.maxMs, ms);
+
+            history.push_back(Row{ frame.number, index, ms });
+        }
+
+        // 오래된 기록 버리기
+        while (!history.empty() && history.front().frame + PROFILER_HISTORY < frame.number)
+        {
+            history.pop_front();
+        }
+    }
+
+    void beginFrame()
+    {
+        if (!on) return;
+
+        if (!initialized)
+        {
+            for (auto& frame : frames)
+            {
+                glGenQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+            }
+            initialized = true;
+        }
+
+        current = &frames.at(frameNumber % frames.size());
+        resolve(*current);
+
+        current->number = frameNumber;
+        current->count = 0;
+
+        depth = 0;
+        inFrame = true;
+    }
+
+    void endFrame()
+    {
+        if (!inFrame) return;
+
+        current->pending = true;
+        current = nullptr;
+        inFrame = false;
+
+        frameNumber++;
+    }
+
+    /**************************************************************************************************************/
+
+    Scope::Scope(const char* name)
+        : index(-1)
+    {
+        if (!inFrame || current->count >= PROFILER_MAX_SCOPES) return;
+
+        this->index = current->count++;
+        current->records.at(this->index) = Record{ name, depth++ };
+
+        glQueryCounter(current->queries.at(this->index * 2), GL_TIMESTAMP);
+    }
+
+    Scope::~Scope()
+    {
+        if (this->index == -1 || !inFrame) return;
+
+        glQueryCounter(current->queries.at(this->index * 2 + 1), GL_TIMESTAMP);
+        depth--;
+    }
+
+    /**************************************************************************************************************/
+
+    const std::vector<Result>& results()
+    {
+        return resultList;
+    }
+
+    bool exportCSV(const std::string& path)
+    {
+        std::ofstream fs(path, std::ios::trunc);
+        if (!fs.is_open())
+        {
+            std::cout << "profiler : failed to write csv. path: " << path << std::endl;
+            return false;
+        }
+
+        fs << "frame,scope,depth,gpu_ms" << std::endl;
+        for (const auto& row : history)
+        {
+            const auto& r = resultList.at(row.result);
+            fs << row.frame << ',' << r.name << ',' << r.depth << ',' << row.ms << std::endl;
+        }
+
+        std::cout << "profiler : saved " << path << ". rows: " << history.size() << std::endl;
+        return true;
+    }
+}
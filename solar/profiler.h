@@ -0,0 +1,50 @@
+﻿// GPU 구간별 시간 측정
+// glQueryCounter(GL_TIMESTAMP) 로 구간 시작, 끝 시간을 기록한다.
+// 결과를 기다리면 CPU 가 멈추므로 쿼리를 몇 프레임 분량 돌려쓰면서 PROFILER_FRAME_LATENCY 프레임 늦게 읽는다.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace profiler
+{
+    // 구간 이름별 결과. 같은 이름이 한 프레임에 여러 번 나오면 합친다.
+    struct Result
+    {
+        std::string name;
+        int    depth;  // 중첩 깊이
+        double lastMs; // 마지막 프레임
+        double avgMs;  // 지수 이동 평균
+        double maxMs;  // 기록된 프레임 중 최대
+    };
+
+    // 켜져 있을 때만 쿼리를 사용함
+    void setEnabled(bool enabled);
+    bool enabled() noexcept;
+
+    // 프레임 시작, 끝. 메인 (렌더링) 스레드에서만 호출
+    void beginFrame();
+    void endFrame();
+
+    // 구간. 생성할 때 시작, 소멸할 때 끝.
+    // name 은 결과를 읽을 때 까지 유지되는 문자열이어야 함 (리터럴, 천체 이름)
+    class Scope
+    {
+    private:
+        int index;
+
+    public:
+        explicit Scope(const char* name);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    // 처음 나온 순서대로
+    const std::vector<Result>& results();
+
+    // 최근 PROFILER_HISTORY 프레임의 기록을 CSV 로 저장. frame,scope,depth,gpu_ms
+    bool exportCSV(const std::string& path);
+}
@@ -0,0 +1,457 @@
+﻿#include "regress.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "args.h"
+#include "camera.h"
+#include "catalog.h"
+#include "config.h"
+#include "constants.h"
+#include "image.h"
+#include "platform.h"
+#include "render.h"
+#include "ui.h"
+
+namespace regress
+{
+    using clock = std::chrono::steady_clock;
+
+    struct Scene
+    {
+        std::string name;
+
+        double date = 0; // J2000 기준 일
+
+        bool  hasCamera = false;
+        int   focus     = 0;
+        float radius    = 0;
+        float azimuth   = 0;
+        float elevation = 0;
+
+        std::vector<std::pair<std::string, double>> options;
+
+        double tolerance = REGRESS_MAX_DIFF_RATIO; // 달라도 되는 픽셀 비율
+    };
+
+    struct Result
+    {
+        std::string name;
+        std::string error; // 비교하지 못한 이유
+
+        bool   passed    = false;
+        size_t diffCount = 0;  // 기준보다 많이 다른 픽셀 수
+        double diffRatio = 0;
+        double maxDelta  = 0;  // ΔE (CIE76)
+        double meanDelta = 0;
+
+        double cpuMs = 0; // 측정 프레임 평균
+        double gpuMs = 0;
+    };
+
+    bool running = false;
+
+    std::vector<Scene>  scenes;
+    std::vector<Result> results;
+
+    size_t sceneIndex = 0;
+    int    frame      = 0; // 장면 안에서 몇 번째 프레임인지
+    bool   inFrame    = false;
+
+    GLuint            query = 0;
+    clock::time_point frameStart;
+
+    double cpuTotal = 0;
+    double gpuTotal = 0;
+
+    /**************************************************************************************************************/
+
+    void parse(const std::string& path)
+    {
+        std::ifstream fs(path);
+        if (!fs.is_open())
+        {
+            throw std::runtime_error("Failed to open regress script. path: " + path);
+        }
+
+        std::string line;
+        std::istringstream ss;
+        int lineNumber = 0;
+
+        while (std::getline(fs, line))
+        {
+            lineNumber++;
+
+            // 주석 제거
+            const auto comment = line.find('#');
+            if (comment != std::string::npos) line.erase(comment);
+
+            ss.clear();
+            ss.str(line);
+
+            std::string command;
+            if (!(ss >> command)) continue; // 빈 줄
+
+            if (command == "scene")
+            {
+                Scene scene;
+                ss >> scene.name;
+                scenes.push_back(scene);
+                continue;
+            }
+
+            if (scenes.empty())
+            {
+                throw std::runtime_error("Command before first scene. path: " + path + ", line: " + std::to_string(lineNumber));
+            }
+
+            auto& scene = scenes.back();
+
+                 if (command == "date"     ) ss >> scene.date;
+            else if (command == "tolerance") ss >> scene.tolerance;
+            else if (command == "camera")
+            {
+                // camera <focus> <radius> <azimuth> <elevation>
+                std::string focus;
+                ss >> focus >> scene.radius >> scene.azimuth >> scene.elevation;
+
+                scene.focus = catalog::find(focus);
+                if (scene.focus == -1)
+                {
+                    throw std::runtime_error("Unknown body in regress script: " + focus);
+                }
+                scene.hasCamera = true;
+            }
+            else if (command == "set")
+            {
+                // set <option> <value>
+                std::string name;
+                double value;
+                ss >> name >> value;
+
+                if (!config::hasOption(name))
+                {
+                    throw std::runtime_error("Unknown option in regress script: " + name);
+                }
+                scene.options.emplace_back(name, value);
+            }
+            else
+            {
+                throw std::runtime_error("Unknown command in regress script: " + command);
+            }
+
+            if (ss.fail())
+            {
+                throw std::runtime_error("Invalid regress script line. path: " + path + ", line: " + std::to_string(lineNumber));
+            }
+        }
+    }
+
+    void load(const std::string& path)
+    {
+        scenes.clear();
+        results.clear();
+        parse(path);
+
+        sceneIndex = 0;
+        frame = 0;
+        running = !scenes.empty();
+
+        std::cout << "regress : loaded " << path << ". scenes: " << scenes.size() << std::endl;
+    }
+
+    bool active() noexcept
+    {
+        return running;
+    }
+
+    bool finished() noexcept
+    {
+        return running && sceneIndex >= scenes.size();
+    }
+
+    /**************************************************************************************************************/
+    // 비교
+
+    // sRGB 8bit -> 선형
+    std::array<float, 256> makeLinearTable()
+    {
+        std::array<float, 256> table{};
+        for (size_t i = 0; i < table.size(); i++)
+        {
+            const float c = i / 255.0f;
+            table[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return table;
+    }
+
+    const std::array<float, 256> linearTable = makeLinearTable();
+
+    // sRGB -> CIELAB (D65)
+    std::array<float, 3> toLab(const uint8_t* p)
+    {
+        const float r = linearTable[p[0]];
+        const float g = linearTable[p[1]];
+        const float b = linearTable[p[2]];
+
+        const float x = (0.4124f * r + 0.3576f * g + 0.1805f * b) / 0.95047f;
+        const float y = (0.2126f * r + 0.7152f * g + 0.0722f * b);
+        const float z = (0.0193f * r + 0.1192f * g + 0.9505f * b) / 1.08883f;
+
+        const auto f = [](float t) { return t > 0.008856f ? std::cbrt(t) : 7.787f * t + 16.0f / 116.0f; };
+
+        const float fx = f(x), fy = f(y), fz = f(z);
+        return { 116 * fy - 16, 500 * (fx - fy), 200 * (fy - fz) };
+    }
+
+    // 픽셀별 ΔE 를 구해서 기준보다 큰 것을 센다. diff 는 다른 곳을 빨갛게 표시한 이미지
+    void compare(const std::vector<uint8_t>& actual, const std::vector<uint8_t>& golden, Result& result, std::vector<uint8_t>& diff)
+    {
+        const size_t count = actual.size() / 4;
+
+        diff.resize(actual.size());
+
+        double sum = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            const auto a = toLab(&actual[i * 4]);
+            const auto g = toLab(&golden[i * 4]);
+
+            const double delta = std::sqrt(
+                (a[0] - g[0]) * (a[0] - g[0]) +
+                (a[1] - g[1]) * (a[1] - g[1]) +
+                (a[2] - g[2]) * (a[2] - g[2])
+            );
+
+            sum += delta;
+            result.maxDelta = std::max(result.maxDelta, delta);
+
+            // 다른 곳은 빨간색, 같은 곳은 어둡게
+            auto d = &diff[i * 4];
+            if (delta > REGRESS_PIXEL_THRESHOLD)
+            {
+                result.diffCount++;
+                d[0] = 255; d[1] = 0; d[2] = 0;
+            }
+            else
+            {
+                d[0] = d[1] = d[2] = static_cast<uint8_t>(actual[i * 4 + 1] / 4);
+            }
+            d[3] = 255;
+        }
+
+        result.diffRatio = count > 0 ? static_cast<double>(result.diffCount) / count : 0;
+        result.meanDelta = count > 0 ? sum / count : 0;
+    }
+
+    std::vector<uint8_t> readFile(const std::filesystem::path& path)
+    {
+        std::ifstream fs(path, std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(fs), std::istreambuf_iterator<char>());
+    }
+
+    void writePNG(const std::filesystem::path& path, const std::vector<uint8_t>& rgba, v::Size2i size)
+    {
+        std::filesystem::create_directories(path.parent_path());
+
+        std::vector<uint8_t> png;
+        image::encodePNG(rgba.data(), size, png);
+
+        std::ofstream fs(path, std::ios::binary | std::ios::trunc);
+        fs.write(reinterpret_cast<const char*>(png.data()), png.size());
+    }
+
+    // 정답 이미지와 비교하고 결과 저장
+    void check(const Scene& scene, Result& result, const std::vector<uint8_t>& actual, v::Size2i size)
+    {
+        const auto& opt = args::get();
+
+        const std::filesystem::path goldenPath = std::filesystem::path(opt.regressGolden) / (scene.name + ".png");
+        const std::filesystem::path outPath    = std::filesystem::path(opt.regressOut);
+
+        if (opt.regressUpdate)
+        {
+            writePNG(goldenPath, actual, size);
+            result.passed = true;
+            result.error = "updated";
+            return;
+        }
+
+        std::vector<uint8_t> golden;
+        v::Size2i goldenSize;
+        if (!image::decodePNG(readFile(goldenPath), golden, goldenSize))
+        {
+            result.error = "no golden image";
+        }
+        else if (goldenSize != size)
+        {
+            result.error = "size " + std::to_string(goldenSize.w) + "x" + std::to_string(goldenSize.h);
+        }
+        else
+        {
+            std::vector<uint8_t> diff;
+            compare(actual, golden, result, diff);
+
+            result.passed = result.diffRatio <= scene.tolerance;
+            if (result.passed) return;
+
+            writePNG(outPath / (scene.name + ".diff.png"), diff, size);
+        }
+
+        // 실패하면 확인할 수 있게 남겨둠
+        writePNG(outPath / (scene.name + ".png"), actual, size);
+    }
+
+    /**************************************************************************************************************/
+
+    void applyScene(const Scene& scene)
+    {
+        // 장면끼리 영향이 없도록 기본값에서 시작. 시간에 따라 바뀌는 글자는 끔
+        auto cfg = config::reset();
+        cfg.playAnimation = true;
+        cfg.showFPS       = false;
+        cfg.showSpeed     = false;
+        cfg.showHelp      = false;
+        cfg.vsync         = false;
+
+        for (const auto& [name, value] : scene.options)
+        {
+            config::setOption(cfg, name, value);
+        }
+        config::update(cfg);
+
+        camera::resetCenter();
+        if (scene.hasCamera)
+        {
+            auto cam = camera::get();
+            cam.focusedPlanet = scene.focus;
+            cam.radius        = scene.radius;
+            cam.azimuth       = scene.azimuth;
+            cam.elevation     = scene.elevation;
+            camera::update(cam);
+        }
+
+        ui::close();
+    }
+
+    void beginFrame()
+    {
+        if (!running || finished() || !render::loaded()) return;
+
+        const auto& scene = scenes.at(sceneIndex);
+
+        if (frame == 0)
+        {
+            applyScene(scene);
+
+            cpuTotal = 0;
+            gpuTotal = 0;
+
+            if (query == 0) glGenQueries(1, &query);
+        }
+
+        render::setDate(scene.date);
+
+        // 앞 프레임은 버리고 (글자, 텍스쳐 캐시 등) 뒤 프레임만 시간 측정
+        if (frame >= REGRESS_SETTLE_FRAMES)
+        {
+            glBeginQuery(GL_TIME_ELAPSED, query);
+            frameStart = clock::now();
+        }
+
+        inFrame = true;
+    }
+
+    void endFrame()
+    {
+        if (!inFrame) return;
+        inFrame = false;
+
+        if (frame < REGRESS_SETTLE_FRAMES)
+        {
+            frame++;
+            return;
+        }
+
+        // 측정중에는 결과를 바로 기다려도 됨
+        cpuTotal += std::chrono::duration<double, std::milli>(clock::now() - frameStart).count();
+        glEndQuery(GL_TIME_ELAPSED);
+
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &ns);
+        gpuTotal += ns / 1e6;
+
+        if (++frame < REGRESS_SETTLE_FRAMES + REGRESS_TIMED_FRAMES) return;
+
+        // 마지막 프레임을 읽어서 비교
+        const auto& scene = scenes.at(sceneIndex);
+
+        const auto screen = camera::get().screen;
+        const v::Size2i size(static_cast<int>(screen.w), static_cast<int>(screen.h));
+
+        std::vector<uint8_t> actual(static_cast<size_t>(size.w) * size.h * 4);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, platform::framebuffer());
+        glReadPixels(0, 0, size.w, size.h, GL_RGBA, GL_UNSIGNED_BYTE, actual.data());
+
+        Result result;
+        result.name  = scene.name;
+        result.cpuMs = cpuTotal / REGRESS_TIMED_FRAMES;
+        result.gpuMs = gpuTotal / REGRESS_TIMED_FRAMES;
+
+        check(scene, result, actual, size);
+        results.push_back(result);
+
+        sceneIndex++;
+        frame = 0;
+    }
+
+    /**************************************************************************************************************/
+
+    int report()
+    {
+        std::cout << "----- REGRESS -----" << std::endl;
+        std::cout << "renderer : " << glGetString(GL_RENDERER) << std::endl;
+
+        int failed = 0;
+        for (const auto& r : results)
+        {
+            if (!r.passed) failed++;
+
+            std::array<char, 512> buff;
+            std::snprintf(
+                buff.data(),
+                buff.size(),
+                "%-4s %-24s diff %7zu px (%7.4f %%)  dE max %6.2f mean %5.3f  cpu %7.3f ms  gpu %7.3f ms  %s",
+                r.passed ? "ok" : "FAIL",
+                r.name.c_str(),
+                r.diffCount,
+                r.diffRatio * 100,
+                r.maxDelta,
+                r.meanDelta,
+                r.cpuMs,
+                r.gpuMs,
+                r.error.c_str()
+            );
+            std::cout << buff.data() << std::endl;
+        }
+
+        std::cout << "regress : " << results.size() - failed << " / " << results.size() << " passed" << std::endl;
+
+        if (query != 0) glDeleteQueries(1, &query);
+
+        return failed > 0 ? 1 : 0;
+    }
+}
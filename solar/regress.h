@@ -0,0 +1,31 @@
+﻿// 렌더링 회귀 테스트
+// 장면 목록 (날자, 카메라, 설정) 을 하나씩 그려서 정답 이미지와 비교하고, 장면별 차이와 프레임 시간을 출력한다.
+// 드라이버마다 결과가 달라지지 않도록 소프트웨어 렌더러에서 돌리는 것을 전제로 함
+//
+//   solar --backend=egl --size=320x240 --textures=../textures-low --regress=resources/regress.txt
+//   solar --backend=egl --size=320x240 --textures=../textures-low --regress=resources/regress.txt --regress-update   (정답 이미지 갱신)
+//
+// 스크립트 형식, 정답 이미지 (resources/golden) 를 만든 환경은 resources/regress.txt 참조.
+
+#pragma once
+
+#include <string>
+
+namespace regress
+{
+    // 장면 목록 읽기. 실패하면 예외 발생.
+    void load(const std::string& path);
+
+    // 실행중인지
+    bool active() noexcept;
+
+    // 모든 장면을 다 그렸는지
+    bool finished() noexcept;
+
+    // 렌더링 직전, 직후 (화면 갱신 전) 에 호출. 로딩이 끝나기 전에는 아무것도 안 함
+    void beginFrame();
+    void endFrame();
+
+    // 결과 출력. 실패한 장면이 있으면 1
+    int report();
+}
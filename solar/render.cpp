@@ -3,6 +3,7 @@
 #include <array>
 #include <atomic>
 #include <chrono>
+#include <cmath>
 #include <ctime>
 #include <exception>
 #include <functional>
@@ -13,29 +14,36 @@
 #include <thread>
 #include <vector>
 
-#include <Windows.h>
-
-#include <glad/glad_wgl.h>
-
 #include <glm/glm.hpp>
 #include <glm/gtx/string_cast.hpp>
 
 #include "camera.h"
+#include "catalog.h"
 #include "config.h"
 #include "constants.h"
+#include "ephemeris.h"
 #include "glext.h"
 #include "input.h"
 #include "model_cube.h"
+#include "model_dynamic_text.h"
+#include "model_hud.h"
 #include "model_milkyway.h"
+#include "model_minorbody.h"
 #include "model_orbit.h"
 #include "model_planet.h"
 #include "model_renderbuffer.h"
 #include "model_saturn_ring.h"
+#include "model_sprite.h"
 #include "orbital.h"
 #include "planet.h"
+#include "platform.h"
+#include "profiler.h"
+#include "simulation.h"
+#include "trace.h"
 #include "ui.h"
 #include "utils.h"
 #include "v.h"
+#include "vtexture.h"
 
 namespace render
 {
@@ -58,43 +66,79 @@ namespace render
     #define LOCK_RENDER std::lock_guard<std::mutex> __lock_render(render::lock);
 
     // FPS
-    std::array<char, 32> fpsString;   // 마지막 fps
-    clock_point          fpsLastTime; // fps 마지막 계산 시간
-    int                  fpsFrames;   // delta-Time 동안 수행한 프레임 수
+    model::DynamicText fpsText;     // 마지막 fps
+    clock_point        fpsLastTime; // fps 마지막 계산 시간
+    int                fpsFrames;   // delta-Time 동안 수행한 프레임 수
+
+    float              speedIs;   // 마지막 속도 값
+    model::DynamicText speedText; // 마지막 속도
 
-    float                speedIs;     // 마지막 속도 값
-    std::array<char, 32> speedString; // 마지막 속도 string
+    model::DynamicText dateText;       // 날자
+    int64_t            dateShown = -1; // dateText 를 만든 시간
 
-    std::array<char, 32> dateString; // 날자 저장
+    std::wstring loadingString;     // 로딩 진행 상황
+    int          loadingShown = -1; // loadingString 을 만든 진행 상황
+
+    // 글씨 레이어
+    enum HudWidget
+    {
+        HudLoading,
+        HudHelp,
+        HudPause,
+        HudDate,
+        HudSpeed,
+        HudFps,
+        HudWatermark,
+    };
+    model::Hud hud;
 
     // openGL 모델
-    model::RenderBuffer modelHelp;        // 도움말
-    model::RenderBuffer modelWatermark;   // 워터마크
-    model::RenderBuffer modelPause;       // 일시 정지
+    model::SpriteAtlas  modelSprites;     // 도움말, 워터마크, 일시 정지를 모아둔 텍스쳐
+    int                 spriteHelp      = -1; // 도움말
+    int                 spriteWatermark = -1; // 워터마크
+    int                 spritePause     = -1; // 일시 정지
 
     model::MilkyWay            modelBackground;  // 배경
-    std::vector<model::Orbit>  modelOrbit;       // 궤도
+    model::Orbits              modelOrbit;       // 궤도
+    model::MinorBodies         modelMinorBodies; // 소행성대, 카이퍼 벨트
     std::vector<model::Planet> modelPlanets;     // 행성
     model::SaturnRing          modelSaturnRing;  // 토성 고리
+    int                        modelRingIndex = planet::PlanetIndex::None; // 고리 그릴 행성
 
     // 텍스쳐 로딩중
-    constexpr int modelTotalCounts = // 백그라운드에서 로딩할 모델 갯수
-        1 +     // 배경
-        1 +     // 토성 고리
-        10 * 2; // 행성별 텍스쳐 및 궤도
+    int modelTotalCounts = 0; // 백그라운드에서 로딩할 모델 갯수. init 에서 계산
     std::atomic_bool loadedNecessary  = false; // true 가 되야 로딩 텍스트 띄움
     std::atomic_bool loadingCompleted = false; // 로딩중...
     std::atomic_int  loadingProgress = 0;
 
-    // 현재 날자
+    // 현재 날자. 계산 스레드가 있으면 마지막으로 그린 날자
     double today;
+    simulation::State frameState;  // 이번 프레임에 그릴 천체 위치
+    uint64_t          frameConfig = 0; // 계산 스레드 없이 직접 계산했을 때의 설정 버전
+
+    // 지난 프레임의 상대 위치. 천체 위치와 카메라가 그대로면 다시 계산하지 않음
+    std::vector<RelativeLocation> relPos;
+    uint64_t relPosStep   = 0;
+    double   relPosToday  = 0;
+    uint64_t relPosCamera = 0;
+    bool     relPosValid  = false;
+
+    // 필요할 때만 그리기
+    std::atomic_bool drawRequested = true; // invalidate 로 다시 그려달라고 한 상태
+    uint64_t         drawnConfig   = 0;    // 마지막으로 그린 설정 버전
+    uint64_t         drawnCamera   = 0;    // 마지막으로 그린 카메라 버전
+    int              drawRemains   = 0;    // 바뀐 뒤로 더 그려야 하는 프레임 수
+    clock_point      drawLastTime;         // 마지막으로 그린 시간
     
     /**************************************************************************************************************/
 
-    void textureLoadingAsync(HDC hdc, HGLRC ctx)
+    void textureLoadingAsync(platform::Context ctx)
     {
-        wglMakeCurrent(hdc, ctx);
-        defer(wglMakeCurrent(hdc, nullptr); wglDeleteContext(ctx););
+        platform::makeCurrent(ctx);
+        defer(platform::release(ctx));
+
+        trace::setThreadName("loader");
+        TRACE_SCOPE("textureLoadingAsync");
 
         /****************************************************************************************************/
         // 기본 데이터 읽고 텍스트 생성부분
@@ -104,6 +148,34 @@ namespace render
             model::Text::instance().init();
         });
 
+        // 쓸 글자들을 백그라운드에서 미리 그려둠. 처음 쓸 때 그 자리에서 그리느라 멈추지 않도록
+        {
+            // 숫자, 날자, 속도 형식 등은 ASCII 로 전부
+            std::wstring chars;
+            for (wchar_t c = 0x20; c < 0x7F; c++) chars += c;
+
+            chars += input::getHelpString();
+            chars += WINDOW_LOADING_TEXT_FORMAT;
+            chars += WINDOW_PAUSED_TEXT;
+
+            model::Text::instance().warmUp(
+                { FONT_SIZE_1, FONT_SIZE_2, FONT_SIZE_3, FONT_SIZE_4, FONT_SIZE_5, FONT_SIZE_6 },
+                chars
+            );
+
+            // 천체 이름은 거리에 따라 크기가 바뀌므로 그 사이 크기 전부
+            std::wstring names;
+            for (const auto& planet : planet::planetList)
+            {
+                for (auto p = planet.name(); *p != 0; p++) names += static_cast<wchar_t>(*p);
+            }
+
+            std::vector<int> sizes;
+            for (int size = PLANET_NAME_TEXT_SIZE_FAR; size <= PLANET_NAME_TEXT_SIZE_NEAR; size++) sizes.push_back(size);
+
+            model::Text::instance().warmUp(sizes, names);
+        }
+
         v::Size2f size = 0;
 
         // 워터마크 생성
@@ -112,14 +184,16 @@ namespace render
             size.w += 10;
             size.h += 10;
 
-            modelWatermark.init(size);
+            modelSprites.init(v::Size2i(WINDOW_SPRITE_ATLAS_SIZE, WINDOW_SPRITE_ATLAS_SIZE));
 
-            modelWatermark.drawStart();
-            defer(modelWatermark.drawEnd());
+            spriteWatermark = modelSprites.add(size);
+
+            const auto rect = modelSprites.drawStart(spriteWatermark);
+            defer(modelSprites.drawEnd());
 
             model::Text::instance().draw(
-                size,
-                v::Rect2f(0, size),
+                modelSprites.getAtlasSize(),
+                rect,
                 WINDOW_WATERMARK_TEXT_ALIGN_HORIZ,
                 model::Alignment::Near,
                 WINDOW_WATERMARK_TEXT_SIZE,
@@ -128,6 +202,13 @@ namespace render
             );
         });
 
+        // 날자, 속도, fps
+        glext::dispatch([&]() {
+            dateText .init(WINDOW_DATE_TEXT_SIZE,  WINDOW_DYNAMIC_TEXT_ALPHABET.chars);
+            speedText.init(WINDOW_SPEED_TEXT_SIZE, WINDOW_DYNAMIC_TEXT_ALPHABET.chars);
+            fpsText  .init(WINDOW_FPS_TEXT_SIZE,   WINDOW_DYNAMIC_TEXT_ALPHABET.chars);
+        });
+
         // 여기까지만 로드되면 로딩띄워도 됨.
         glFlush();
         loadedNecessary = true;
@@ -136,14 +217,14 @@ namespace render
         glext::dispatch([&]() {
             size = model::Text::instance().measure(WINDOW_HELP_TEXT_SIZE, input::getHelpString());
 
-            modelHelp.init(size);
+            spriteHelp = modelSprites.add(size);
 
-            modelHelp.drawStart();
-            defer(modelHelp.drawEnd());
+            const auto rect = modelSprites.drawStart(spriteHelp);
+            defer(modelSprites.drawEnd());
 
             model::Text::instance().draw(
-                size,
-                v::Rect2f(0, size),
+                modelSprites.getAtlasSize(),
+                rect,
                 WINDOW_HELP_TEXT_ALIGN_HORIZ,
                 model::Alignment::Near,
                 WINDOW_HELP_TEXT_SIZE,
@@ -158,14 +239,14 @@ namespace render
             size = model::Text::instance().measure(WINDOW_PAUSED_TEXT_SIZE, WINDOW_PAUSED_TEXT);
             size.h += 10; // 글자 잘려서 마진.
 
-            modelPause.init(size);
+            spritePause = modelSprites.add(size);
 
-            modelPause.drawStart();
-            defer(modelPause.drawEnd());
+            const auto rect = modelSprites.drawStart(spritePause);
+            defer(modelSprites.drawEnd());
 
             model::Text::instance().draw(
-                    size,
-                    v::Rect2f(0, size),
+                modelSprites.getAtlasSize(),
+                rect,
                 WINDOW_PAUSED_TEXT_ALIGN_HORIZ,
                 model::Alignment::Far,
                 WINDOW_PAUSED_TEXT_SIZE,
@@ -178,7 +259,11 @@ namespace render
         // 행성 로딩부분
 
         modelPlanets.resize(planet::planetList.size());
-        modelOrbit.resize(planet::planetList.size());
+
+        // 큰 텍스쳐 풀. 행성보다 먼저
+        glext::dispatch([&]() {
+            vtexture::start();
+        });
 
         // 행성 텍스쳐
         for (size_t i = 0; i < planet::planetList.size(); i++)
@@ -186,32 +271,56 @@ namespace render
             // 태양은 별도작업함.
 
             const auto& planet = planet::planetList.at(i);
+            TRACE_SCOPE(planet.name());
 
-            // 태양은 궤도 없음.
-            if (i != 0)
+            // 공전하지 않는 천체는 궤도 없음.
+            if (planet.parentIndex() != -1)
             {
-                modelOrbit.at(i).init(planet);
+                modelOrbit.add(planet);
                 loadingProgress++;
             }
 
-            // 행성
-            modelPlanets.at(i).init(planet);
-            loadingProgress++;
+            // 행성. 텍스쳐 없는 천체는 궤도만 그린다.
+            if (planet.texture()[0] != '\0')
+            {
+                modelPlanets.at(i).init(planet);
+                loadingProgress++;
+            }
+
+            // 고리는 하나만
+            if (modelRingIndex == planet::PlanetIndex::None && planet.hasMaterial(catalog::MaterialRing))
+            {
+                modelRingIndex = static_cast<int>(i);
+            }
         }
 
+        // 궤도는 한번에 올림
+        modelOrbit.init();
+
+        // 소천체. 파일이 없으면 건너뜀
+        modelMinorBodies.init();
+        loadingProgress++;
+
+        // 행성 급수. 읽기 전까지는 케플러 궤도로 계산
+        ephemeris::load();
+        loadingProgress++;
+
         // 배경
         modelBackground.init();
         loadingProgress++;
 
         // 토성 고리
-        modelSaturnRing.init(planet::planetList.at(planet::PlanetIndex::Saturn));
-        loadingProgress++;
+        if (modelRingIndex != planet::PlanetIndex::None)
+        {
+            modelSaturnRing.init(planet::planetList.at(modelRingIndex));
+            loadingProgress++;
+        }
 
         glFlush();
         loadingCompleted = true;
     }
 
-    void init(GLFWwindow* window)
+    void init()
     {
         // 기본 색 지정
         glColor4f(1, 1, 1, 1);
@@ -261,38 +370,72 @@ namespace render
 
         /**************************************************************************************************************/
         // 백그라운드에서 텍스쳐를 가져오기 위한 부분
-        // https://www.khronos.org/opengl/wiki/Platform_specifics:_Windows#wglShareLists
         // glext.h 참조.
 
-        constexpr std::array<int, 9> attribs = {
-            WGL_CONTEXT_MAJOR_VERSION_ARB, 3,
-            WGL_CONTEXT_MINOR_VERSION_ARB, 3,
-            WGL_CONTEXT_PROFILE_MASK_ARB,  WGL_CONTEXT_CORE_PROFILE_BIT_ARB, // Core profile 사용함.
-            WGL_CONTEXT_FLAGS_ARB,         WGL_CONTEXT_FORWARD_COMPATIBLE_BIT_ARB, // OpenGL 3 이상의 API 만을 사용함
-            0,
-        };
+        // 로딩할 모델 갯수
+        modelTotalCounts =
+            1 + // 배경
+            1 + // 소천체
+            1;  // 급수
+
+        bool hasRing = false;
+        for (const auto& planet : planet::planetList)
+        {
+            if (planet.parentIndex() != -1)  modelTotalCounts++; // 궤도
+            if (planet.texture()[0] != '\0') modelTotalCounts++; // 텍스쳐
 
-        const auto ctxCurrent = wglGetCurrentContext();
-        const auto dc = wglGetCurrentDC();
-        const auto ctxBackground = wglCreateContextAttribsARB(dc, ctxCurrent, attribs.data());
+            hasRing |= planet.hasMaterial(catalog::MaterialRing);
+        }
+        if (hasRing) modelTotalCounts++; // 고리
 
-        std::thread thd(textureLoadingAsync, dc, ctxBackground);
+        // 공유 컨텍스트는 메인 스레드에서 만들고 로딩 스레드에서 사용
+        std::thread thd(textureLoadingAsync, platform::createSharedContext());
         thd.detach();
     }
 
+    bool loaded() noexcept
+    {
+        return loadingCompleted;
+    }
+
     void resetDate() noexcept
     {
-        today = 0;
+        setDate(0);
     }
 
-    // 케플러 공식을 활용하여 행성 위치 구하는 함수
-    void calcPlanetResolution(std::vector<RelativeLocation>& relLoc)
+    void setDate(double days) noexcept
     {
-        relLoc.at(0).location = glm::vec4(0, 0, 0, 0);
+        today = days;
 
-        for (size_t i = 1; i < planet::planetList.size(); i++)
+        if (simulation::running())
         {
-            relLoc.at(i).location = orbital::getCurrentPosition(static_cast<int>(i), today);
+            simulation::setDate(days);
+        }
+    }
+
+    // 행성 위치 구하는 함수
+    // 계산 스레드가 있으면 마지막 두 상태를 보간하고, 없으면 (벤치마크, 내보내기 등) 여기서 today 로 바로 계산함.
+    // 공전, 자전 모두 날자만으로 계산하므로 이전 프레임과 관계 없음.
+    void calcPlanetResolution(const config::Config& cfg, uint64_t cfgVersion, clock_point renderStartClock)
+    {
+        TRACE_SCOPE("calcPlanetResolution");
+
+        const simulation::Snapshot* snapshot = simulation::running() ? &simulation::latest() : nullptr;
+        if (snapshot != nullptr && !snapshot->current.locations.empty())
+        {
+            // 두 상태 사이에 들어가도록 한 간격 전 시점을 그림
+            const auto step = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(SIMULATION_STEP_SECONDS));
+            simulation::interpolate(*snapshot, renderStartClock - step, frameState);
+
+            today = frameState.today;
+        }
+        else if (frameState.locations.empty() || frameState.today != today || frameConfig != cfgVersion)
+        {
+            frameState.today = today;
+            frameState.step++;
+            simulation::compute(frameState, cfg);
+
+            frameConfig = cfgVersion;
         }
     }
 
@@ -312,9 +455,10 @@ namespace render
         const auto& planet = planet::planetList.at(planetIndex);
 
         // 부모 행성 확인
-        if (planet._parentIndex != -1)
+        const auto parentIndex = planet.parentIndex();
+        if (parentIndex != -1)
         {
-            auto& rlParent = relLoc.at(planet._parentIndex);
+            auto& rlParent = relLoc.at(parentIndex);
             if (!rlParent.updated)
             {
                 rlParent.updated = true;
@@ -324,19 +468,14 @@ namespace render
                     modelMatrix,
                     -glm::vec3(rl.location)
                 );
-                calcRelativeLocation(relLoc, cam, modelMatrixParent, planet._parentIndex);
+                calcRelativeLocation(relLoc, cam, modelMatrixParent, parentIndex);
             }
         }
 
         // 자식 행성 위치 계산
-        for (auto& planetChild : planet::planetList)
+        for (const auto childIndex : catalog::children(planetIndex))
         {
-            if (planetChild._index == planetIndex) continue; // 나 스킵
-
-            if (planetChild._parentIndex == -1) continue; // 부모 없는거 스킵
-            if (planetChild._parentIndex != planetIndex) continue; // 내가 부모 아닌거 스킵
-
-            auto& rlChild = relLoc.at(planetChild._index);
+            auto& rlChild = relLoc.at(childIndex);
             if (rlChild.updated) continue; // 업데이트 된거 스킵
             rlChild.updated = true;
 
@@ -345,7 +484,7 @@ namespace render
                 modelMatrix,
                 glm::vec3(rlChild.location)
             );
-            calcRelativeLocation(relLoc, cam, modelMatrixChild, planetChild._index);
+            calcRelativeLocation(relLoc, cam, modelMatrixChild, childIndex);
         }
     }
 
@@ -364,47 +503,39 @@ namespace render
         glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
         defer(glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE));
 
+        profiler::Scope scope("background");
+
         // 카메라 회전만 설정한 상태로 배경을 그려야 확대, 축소를 해도 배경이 동일하게 그려진다.
         modelBackground.draw(cam.matProjection, cam.matViewMilkyway);
     }
 
     // 행성들 궤도 그리는 함수
     void drawOrbit(
-        const std::vector<RelativeLocation> relPos,
+        const std::vector<RelativeLocation>& relPos,
         const config::Config cfg,
-        const camera::Camera cam,
-        const int planetIndex = PLANET_INDEX_START
+        const camera::Camera cam
     )
     {
-        if (planetIndex == PLANET_INDEX_START)
+        // 궤도별 위치 정보 갱신
+        for (const auto& planet : planet::planetList)
         {
-            drawOrbit(relPos, cfg, cam, 0);
-            return;
-        }
-
-        const auto& planet = planet::planetList.at(planetIndex);
-
-        // 태양은 안함
-        if (planetIndex != planet::PlanetIndex::Sun)
-        {
-            const auto& rlParent = relPos.at(planet._parentIndex);
-            const auto& rlCurernt = relPos.at(planetIndex);
+            // 공전하지 않는 천체는 안함
+            const auto parentIndex = planet.parentIndex();
+            if (parentIndex == -1) continue;
 
             // 부모 행성의 위치가 기본위치다!
-            const glm::mat4 modelMatrix = planet._parentIndex == -1 ? glm::mat4(1) : rlParent.ModelMatrix;
+            const glm::mat4 modelMatrix = relPos.at(parentIndex).ModelMatrix;
 
-            // 궤도 렌더링
-            modelOrbit.at(planetIndex).draw(
-                cam.matProjection,
-                cam.matView,
-                modelMatrix,
-                cfg,
-                rlCurernt.location.w
-            );
+            modelOrbit.update(planet._index, modelMatrix, relPos.at(planet._index).location.w);
         }
 
-        // 자식 행성 드로잉
-        planet.foreach(drawOrbit, relPos, cfg, cam);
+        // 궤도 렌더링
+        profiler::Scope scope("orbits");
+        modelOrbit.draw(
+            cam.matProjection,
+            cam.matView,
+            cfg
+        );
     }
 
     // 행성 그리는 함수
@@ -419,8 +550,14 @@ namespace render
     {
         if (planetIndex == PLANET_INDEX_START)
         {
-            // 태양부터 시작
-            drawPlanet(deltaSecond, relPos, cfg, cam, lightPos, 0);
+            // 부모 없는 천체 (태양) 부터 시작
+            for (const auto& planet : planet::planetList)
+            {
+                if (planet.parentIndex() == -1)
+                {
+                    drawPlanet(deltaSecond, relPos, cfg, cam, lightPos, planet._index);
+                }
+            }
             return;
         }
 
@@ -430,6 +567,7 @@ namespace render
         const auto modelMatrix = relPos.at(planetIndex).ModelMatrix;
 
         // 자전축만큼 회전하고 그리기
+        if (planet.texture()[0] != '\0')
         {
             const auto matRotation = modelMatrix * planet.getLocalMatrix(false);
 
@@ -442,17 +580,23 @@ namespace render
             // 내 기준 카메라의 상대 위치 얻어오기
             const glm::vec3 camPosRelative = cam.posCamera - glm::vec3(modelMatrix * glm::vec4(myCenter, 1));
 
-            modelPlanets.at(planetIndex).draw(
-                cam.matProjection,
-                cam.matView,
-                matRotation,
-                lightPosRelative,
-                camPosRelative
-            );
+            {
+                profiler::Scope scope(planet.name());
+                modelPlanets.at(planetIndex).draw(
+                    cam.matProjection,
+                    cam.matView,
+                    matRotation,
+                    lightPosRelative,
+                    camPosRelative,
+                    cam.screen.h
+                );
+            }
 
             // 렌더링
-            if (planetIndex == planet::PlanetIndex::Saturn)
+            if (planetIndex == modelRingIndex)
             {
+                profiler::Scope scope("ring");
+
                 // 후면제거 끄기
                 glDisable(GL_CULL_FACE);
                 defer(glEnable(GL_CULL_FACE));
@@ -469,9 +613,11 @@ namespace render
         // 이름 쓰기
         if (cfg.showPlanetName)
         {
+            profiler::Scope scope("labels");
+
             // 글씨를 쓸 위치 구하기
             constexpr float rt = glm::root_two<float>();
-            const glm::vec3 v = cam.matRotateInverse * glm::vec4(planet._radius / rt, planet._radius / rt, planet._radius * 3, 1);
+            const glm::vec3 v = cam.matRotateInverse * glm::vec4(planet.radius() / rt, planet.radius() / rt, planet.radius() * 3, 1);
 
             // 화면상의 좌표 구하기
             const auto c = glm::project(v, cam.matView * modelMatrix, cam.matProjection, glm::vec4(0, 0, cam.screen.w, cam.screen.h));
@@ -519,7 +665,7 @@ namespace render
                     model::Alignment::Near,
                     fontSize,
                     PLANET_NAME_TEXT_COLOR,
-                    planet._name,
+                    planet.name(),
                     c.z
                 );
             }
@@ -530,6 +676,7 @@ namespace render
     }
 
     // 도움말, FPS, watermark, ui 등 화면에 그리는 무언가를 그리는 함수
+    // 글씨는 레이어에 모아두고 내용이 바뀐 것만 다시 씀. 레이어는 ui 위에 그려짐
     void drawUserInterface(const config::Config cfg, const camera::Camera cam, const clock_point renderStartClock)
     {
         // 화면에 직접 텍스트 쓸 영역 재계산
@@ -543,28 +690,47 @@ namespace render
         glDepthFunc(GL_ALWAYS); // Depth 테스트 하지 않고 항상 화면을 갱신하도록한다.
         defer(glDepthFunc(GL_LESS)); // 복구
 
+        // UI 렌더링
+        // 글씨 레이어가 화면 최상위에 올라와야 하기 때문에 UI 부터 렌더링함.
+        // 창이 없으면 조작할 수 없으니 그리지 않음
+        if (loadingCompleted && !platform::headless())
+        {
+            profiler::Scope scope("imgui");
+            ui::render(cam.screen, cfg, cam);
+        }
+
+        hud.begin(cam.screen);
+
         // 로딩중 텍스트 띄우기
         if (!loadingCompleted)
         {
-            std::array<wchar_t, 128> wcsBuff{};
-
-            std::swprintf(
-                wcsBuff.data(),
-                wcsBuff.size(),
-                WINDOW_LOADING_TEXT_FORMAT,
-                loadingProgress.load(),
-                modelTotalCounts
-            );
+            // 진행 상황이 바뀔 때만 새로 만듦
+            const int progress = loadingProgress;
+            if (progress != loadingShown)
+            {
+                loadingShown = progress;
+
+                std::array<wchar_t, 128> wcsBuff{};
+
+                std::swprintf(
+                    wcsBuff.data(),
+                    wcsBuff.size(),
+                    WINDOW_LOADING_TEXT_FORMAT,
+                    progress,
+                    modelTotalCounts
+                );
+                loadingString = wcsBuff.data();
+            }
 
             // LOADING 쓰기
-            model::Text::instance().draw(
-                cam.screen,
+            hud.text(
+                HudLoading,
                 viewTextRect,
                 model::Alignment::Middle,
                 model::Alignment::Middle,
                 WINDOW_LOADING_TEXT_SIZE,
                 WINDOW_LOADING_TEXT_COLOR,
-                wcsBuff.data()
+                loadingString
             );
         }
         else
@@ -572,63 +738,64 @@ namespace render
             // 도움말
             if (cfg.showHelp)
             {
-                modelHelp.draw(
-                    cam.screen,
+                hud.sprite(
+                    HudHelp,
                     viewTextRect,
                     WINDOW_HELP_TEXT_ALIGN_HORIZ,
-                    WINDOW_HELP_TEXT_ALIGN_VERTI
+                    WINDOW_HELP_TEXT_ALIGN_VERTI,
+                    modelSprites,
+                    spriteHelp
                 );
             }
 
             // paused
             if (!cfg.playAnimation)
             {
-                modelPause.draw(
-                    cam.screen,
+                hud.sprite(
+                    HudPause,
                     viewTextRect,
                     WINDOW_PAUSED_TEXT_ALIGN_HORIZ,
-                    WINDOW_PAUSED_TEXT_ALIGN_VERTI
+                    WINDOW_PAUSED_TEXT_ALIGN_VERTI,
+                    modelSprites,
+                    spritePause
                 );
             }
 
             // 날자 표시
             if (cfg.showDate)
             {
-                // J2000 기준 타임스탬프 계산
-                const __time64_t tt = 946727935 + static_cast<time_t>(today * 24 * 60 * 60);
-
-                // timestamp to tm.
-                tm tm;
-                _gmtime64_s(&tm, &tt);
-                std::snprintf(
-                    dateString.data(),
-                    dateString.size(),
-                    WINDOW_DATE_TEXT,
-                    1900 + tm.tm_year,
-                    1 + tm.tm_mon,
-                    tm.tm_mday,
-                    tm.tm_hour,
-                    tm.tm_min,
-                    tm.tm_sec
-                );
+                // J2000 기준 타임스탬프 계산. 초가 바뀔 때만 새로 만듦
+                const int64_t tt = 946727935 + static_cast<int64_t>(today * 24 * 60 * 60);
+                if (tt != dateShown)
+                {
+                    dateShown = tt;
+
+                    // timestamp to tm.
+                    tm tm;
+                    utils::gmtime(tt, tm);
+
+                    // formatting
+                    dateText.begin();
+                    dateText.put(1900 + tm.tm_year, 4); dateText.put('-');
+                    dateText.put(1 + tm.tm_mon,     2); dateText.put('-');
+                    dateText.put(tm.tm_mday,        2); dateText.put(' ');
+                    dateText.put(tm.tm_hour,        2); dateText.put(':');
+                    dateText.put(tm.tm_min,         2); dateText.put(':');
+                    dateText.put(tm.tm_sec,         2);
+                    dateText.put(WINDOW_DATE_TEXT_SUFFIX);
+                    dateText.end();
+                }
 
-                // formatting
-                model::Text::instance().draw(
-                    cam.screen,
+                hud.dynamic(
+                    HudDate,
                     viewTextRect,
                     WINDOW_DATE_TEXT_ALIGN_HORIZ,
                     WINDOW_DATE_TEXT_ALIGN_VERTI,
-                    WINDOW_DATE_TEXT_SIZE,
                     WINDOW_DATE_TEXT_COLOR,
-                    dateString.data()
+                    dateText
                 );
             }
 
-            // UI 렌더링
-            // 속도랑 fps 는 화면 최상위에 올라와야 하기 때문에 UI 부터 렌더링함.
-            ui::render(cam.screen, cfg, cam);
-
-
             // 속도랑 fps 는 순서대로 쌓아야 하기 때문에...
             v::Rect2f rectRightTop(
                 viewTextRect.x,
@@ -645,17 +812,19 @@ namespace render
                     speedIs = cfg.speed;
 
                     // 포메팅
-                    std::snprintf(speedString.data(), speedString.size(), WINDOW_SPEED_TEXT_FORMAT, cfg.speed);
+                    speedText.begin();
+                    speedText.put(static_cast<double>(cfg.speed), WINDOW_SPEED_TEXT_DECIMALS);
+                    speedText.put(WINDOW_SPEED_TEXT_UNIT);
+                    speedText.end();
                 }
 
-                const auto size = model::Text::instance().draw(
-                    cam.screen,
+                const auto size = hud.dynamic(
+                    HudSpeed,
                     rectRightTop,
                     WINDOW_SPEED_TEXT_ALIGN_HORIZ,
                     WINDOW_SPEED_TEXT_ALIGN_VERTI,
-                    WINDOW_SPEED_TEXT_SIZE,
                     WINDOW_SPEED_TEXT_COLOR,
-                    speedString.data()
+                    speedText
                 );
 
                 rectRightTop.y += size.h;
@@ -679,48 +848,81 @@ namespace render
                     // 렌더링 시간 계산 및 포메팅
                     const auto renderTime = std::chrono::duration<double, std::milli>(clock::now() - renderStartClock).count();
 
-                    std::snprintf(fpsString.data(), fpsString.size(), WINDOW_FPS_TEXT_FORMAT, fps, renderTime);
+                    fpsText.begin();
+                    fpsText.put(WINDOW_FPS_TEXT_PREFIX);
+                    fpsText.put(fps, 1);
+                    fpsText.put(WINDOW_FPS_TEXT_TIME_PREFIX);
+                    fpsText.put(renderTime, 2);
+                    fpsText.put(WINDOW_FPS_TEXT_TIME_SUFFIX);
+                    fpsText.end();
                 }
 
                 if (cfg.showFPS)
                 {
                     // 위쪽에 속도 썼으면 그만큼 밑으로 내려야 하므로...
 
-                    model::Text::instance().draw(
-                        cam.screen,
+                    hud.dynamic(
+                        HudFps,
                         rectRightTop,
                         WINDOW_FPS_TEXT_ALIGN_HORIZ,
                         WINDOW_FPS_TEXT_ALIGN_VERTI,
-                        WINDOW_FPS_TEXT_SIZE,
                         WINDOW_FPS_TEXT_COLOR,
-                        fpsString.data()
+                        fpsText
                     );
                 }
             }
         }
 
         // 오예
-        modelWatermark.draw(
-            cam.screen,
+        hud.sprite(
+            HudWatermark,
             viewTextRect,
             WINDOW_WATERMARK_TEXT_ALIGN_HORIZ,
-            WINDOW_WATERMARK_TEXT_ALIGN_VERTI
+            WINDOW_WATERMARK_TEXT_ALIGN_VERTI,
+            modelSprites,
+            spriteWatermark
         );
+
+        hud.end();
     }
 
-    void render(GLFWwindow* window, clock_point renderStartClock, double deltaSeconds)
+    void render(clock_point renderStartClock, double deltaSeconds)
     {
+        TRACE_SCOPE("render::render");
+
         LOCK_RENDER;
 
         // 준비 안됐으면 기다림
         if (!loadedNecessary) return;
 
-        // 현재 카메라 및 설정 정보 가져오기.
-        const auto cfg = config::get();
-        const auto cam = camera::get();
+        // 백그라운드에서 그려둔 글자 올리기
+        model::Text::instance().upload(TEXT_WARMUP_UPLOADS_PER_FRAME);
+
+        // 백그라운드에서 읽어둔 큰 텍스쳐 타일 올리기
+        vtexture::upload(VTEX_UPLOADS_PER_FRAME);
+
+        // 현재 카메라 및 설정 정보 가져오기. 버전은 이번 프레임에 쓴 값의 것
+        uint64_t cfgVersion, camVersion;
+        const auto cfg = config::get(&cfgVersion);
+        const auto cam = camera::get(&camVersion);
+
+        // GPU 구간 측정
+        profiler::setEnabled(cfg.enableProfiler);
+        profiler::beginFrame();
+        defer(profiler::endFrame());
+
+        profiler::Scope frameScope("frame");
+
+        // 어떤 상태를 그렸는지 기록
+        drawnConfig  = cfgVersion;
+        drawnCamera  = camVersion;
+        drawLastTime = renderStartClock;
 
         /****************************************************************************************************/
 
+        // 창이 없으면 FBO 에 그림
+        glBindFramebuffer(GL_FRAMEBUFFER, platform::framebuffer());
+
         // 영역 설정
         glViewport(
             0,
@@ -735,29 +937,43 @@ namespace render
         if (loadingCompleted)
         {
             /****************************************************************************************************/
-            // 애니메이션 처리
-            if (cfg.playAnimation)
+            // 애니메이션 처리. 계산 스레드가 있으면 거기서 진행함
+            if (cfg.playAnimation && !simulation::running())
             {
                 // 마지막 렌더링으로부터 지난 시간 (부드럽고 정확한 애니메이션 처리)
-                const auto delta = deltaSeconds * cfg.speed;
                 today += deltaSeconds * cfg.speed;
-
-                // 행성 위치 계산
-                for (auto& p : planet::planetList)
-                {
-                    p.addDays(delta);
-                }
             }
 
             /****************************************************************************************************/
             // 계산부
-            std::vector<RelativeLocation> relPos(planet::planetList.size());
 
             // 행성 위치 계산
-            calcPlanetResolution(relPos);
+            calcPlanetResolution(cfg, cfgVersion, renderStartClock);
 
-            // 상대위치 전환
-            calcRelativeLocation(relPos, cam);
+            // 상대위치 전환. 일시정지 중 카메라가 그대로면 지난 프레임 것을 씀
+            if (!relPosValid ||
+                relPosStep   != frameState.step  ||
+                relPosToday  != frameState.today ||
+                relPosCamera != camVersion)
+            {
+                TRACE_SCOPE("calcRelativeLocation");
+
+                relPos.assign(planet::planetList.size(), RelativeLocation{});
+                for (size_t i = 0; i < planet::planetList.size(); i++)
+                {
+                    relPos.at(i).location = frameState.locations.at(i);
+
+                    planet::planetList.at(i).setDays(frameState.today);
+                }
+
+                // 재귀 함수라 여기서 한 번만 기록
+                calcRelativeLocation(relPos, cam);
+
+                relPosStep   = frameState.step;
+                relPosToday  = frameState.today;
+                relPosCamera = camVersion;
+                relPosValid  = true;
+            }
 
             /****************************************************************************************************/
             // 렌더링 영역
@@ -773,6 +989,13 @@ namespace render
                 drawOrbit(relPos, cfg, cam);
             }
 
+            // 소천체 그리기. 위치는 셰이더에서 계산함
+            if (cfg.showMinorBodies)
+            {
+                profiler::Scope scope("minor bodies");
+                modelMinorBodies.draw(cam.matProjection, cam.matView, relPos.at(0).ModelMatrix, today);
+            }
+
             // 행성 그리기
             {
                 // 광원의 위치는 태양의 위치랑 같다.
@@ -789,6 +1012,45 @@ namespace render
         }
 
         // 글씨쓰기
-        drawUserInterface(cfg, cam, renderStartClock);
+        {
+            profiler::Scope scope("hud");
+            drawUserInterface(cfg, cam, renderStartClock);
+        }
+    }
+
+    void invalidate() noexcept
+    {
+        drawRequested = true;
+    }
+
+    bool needsRedraw(clock_point now)
+    {
+        const auto cfg = config::get();
+
+        // 화면이 계속 바뀌는 상태
+        if (!cfg.renderOnDemand || cfg.playAnimation || !loadingCompleted || simulation::pending() || model::Text::instance().pending() || vtexture::pending())
+        {
+            return true;
+        }
+
+        // 입력이 있었거나 설정, 카메라가 바뀌었으면 몇 프레임 더 그림. (imgui 는 한 프레임 늦게 반영되는 게 있음)
+        if (drawRequested.exchange(false) || drawnConfig != config::version() || drawnCamera != camera::version())
+        {
+            drawRemains = RENDER_REDRAW_FRAMES;
+        }
+        if (drawRemains > 0)
+        {
+            drawRemains--;
+            return true;
+        }
+
+        // fps 표시 갱신
+        if (cfg.showFPS)
+        {
+            const double ms = std::chrono::duration<double, std::milli>(now - drawLastTime).count();
+            return ms >= WINDOW_FPS_UPDATE_INTERVAL;
+        }
+
+        return false;
     }
 }
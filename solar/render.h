@@ -12,9 +12,14 @@ namespace render
     using clock = std::chrono::steady_clock;
     using clock_point = clock::time_point;
 
-    void init(GLFWwindow* window); // openGL 렌더링 관련 부분 초기화
+    void init(); // openGL 렌더링 관련 부분 초기화
+    bool loaded() noexcept; // 백그라운드 로딩이 끝났는지
 
     void resetDate() noexcept;
+    void setDate(double days) noexcept; // J2000 기준 일 수
 
-    void render(GLFWwindow* window, clock_point renderStartClock, double deltaSeconds); // 화면 렌더링
+    void render(clock_point renderStartClock, double deltaSeconds); // 화면 렌더링
+
+    void invalidate() noexcept; // 다음 프레임은 다시 그리도록 표시. 입력, 창 갱신 요청 등
+    bool needsRedraw(clock_point now); // 마지막으로 그린 뒤 화면이 바뀔 일이 있었는지
 }
@@ -0,0 +1,25 @@
+﻿#version 330 core
+
+// 글자 하나가 instance 하나. 사각형 네 귀퉁이는 gl_VertexID 로 만든다.
+layout (location = 0) in vec3 glyph; // 펜 위치 x, y, 글자 번호
+
+out vec2 TexCoords;
+
+uniform mat4 projection;
+uniform vec2 origin;
+
+// 글자별 사각형 (x, y, w, h), 텍스쳐 좌표 (u0, v0, u1, v1)
+uniform vec4 glyphRect[64];
+uniform vec4 glyphUV[64];
+
+void main()
+{
+    int  index  = int(glyph.z);
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+
+    vec4 rect = glyphRect[index];
+    vec4 uv   = glyphUV[index];
+
+    gl_Position = projection * vec4(origin + glyph.xy + rect.xy + corner * rect.zw, 0.0, 1.0);
+    TexCoords = mix(uv.xy, uv.zw, corner);
+}
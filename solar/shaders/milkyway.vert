@@ -3,6 +3,7 @@
 // 상수
 uniform mat4 projectionMatrix;	// Projection-Matrix
 uniform mat4 viewMatrix;	    // View-Matrix
+uniform float radius;           // 반지름. 버텍스는 반지름 1 인 구
 
 // 입력 데이터
 layout (location = 0) in vec3 inPos;     // 벡터
@@ -13,7 +14,7 @@ out vec2 TexCoords; // 텍스쳐 좌표
 
 void main()
 {
-	vec4 pos = projectionMatrix * viewMatrix * vec4(inPos, 1);
+	vec4 pos = projectionMatrix * viewMatrix * vec4(inPos * radius, 1);
     gl_Position = pos.xyww; // z 값을 w 로 설정해서 깊이검사 최적화
 	
     TexCoords = texCoords;
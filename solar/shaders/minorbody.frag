@@ -0,0 +1,19 @@
+﻿#version 330 core
+
+in vec4 Color;
+
+// 출력물
+out vec4 FragColor;
+
+void main()
+{
+    // 둥근 점으로
+    vec2 p = gl_PointCoord * 2 - 1;
+    float r = dot(p, p);
+    if (r > 1)
+    {
+        discard;
+    }
+
+    FragColor = vec4(Color.rgb, Color.a * (1 - r));
+}
@@ -0,0 +1,68 @@
+﻿#version 330 core
+
+// 상수
+uniform mat4  projectionMatrix; // Projection-Matrix
+uniform mat4  viewMatrix;       // View-Matrix
+uniform mat4  modelMatrix;      // 태양 위치
+uniform float days;             // J2000 기준 일 수
+uniform float auScale;          // AU -> opengl 좌표 단위
+uniform float pointSize;        // 점 크기
+uniform vec2  magnitude;        // x : 밝은 등급, y : 어두운 등급
+uniform vec2  alpha;            // x : 최소 알파, y : 최대 알파
+uniform vec2  beltDistance;     // x : 소행성대 거리, y : 카이퍼 벨트 거리 (AU)
+uniform vec4  colorInner;       // 소행성대 색
+uniform vec4  colorOuter;       // 카이퍼 벨트 색
+
+// 입력 데이터. minorbody::Elements 순서와 같음
+layout (location = 0) in float inA;    // 장반경 (AU)
+layout (location = 1) in float inE;    // 이심률
+layout (location = 2) in float inI;    // 기울기
+layout (location = 3) in float inNode; // 승교점 경도
+layout (location = 4) in float inPeri; // 근일점 인수
+layout (location = 5) in float inM;    // J2000 시점 평균 근점이각
+layout (location = 6) in float inN;    // 평균 운동 (rad/day)
+layout (location = 7) in float inH;    // 절대 등급
+
+// 넘기기
+out vec4 Color;
+
+const float PI2 = 6.28318530718;
+
+void main()
+{
+    // 평균 근점이각
+    float M = mod(inM + inN * days, PI2);
+
+    // 케플러 방정식. 이심률이 크지 않으면 몇 번이면 충분함
+    float E = M + inE * sin(M);
+    for (int i = 0; i < 6; i++)
+    {
+        E = E - (E - inE * sin(E) - M) / (1 - inE * cos(E));
+    }
+
+    // 궤도면 위의 위치
+    float x = inA * (cos(E) - inE);
+    float y = inA * sqrt(1 - inE * inE) * sin(E);
+
+    float cosw = cos(inPeri);
+    float sinw = sin(inPeri);
+    float cosO = cos(inNode);
+    float sinO = sin(inNode);
+    float cosI = cos(inI);
+    float sinI = sin(inI);
+
+    // 황도 좌표. orbital::getCurrentPosition 과 같은 식
+    float Xecl = (cosw * cosO - sinw * sinO * cosI) * x + (-sinw * cosO - cosw * sinO * cosI) * y;
+    float Yecl = (cosw * sinO + sinw * cosO * cosI) * x + (-sinw * sinO + cosw * cosO * cosI) * y;
+    float Zecl =                      (sinw * sinI) * x +                       (cosw * sinI) * y;
+
+    // Y 축과 Z 축 교환
+    vec3 pos = vec3(Xecl, Zecl, -Yecl) * auScale;
+
+    gl_Position  = projectionMatrix * viewMatrix * modelMatrix * vec4(pos, 1);
+    gl_PointSize = pointSize;
+
+    // 거리에 따라 색, 등급에 따라 알파
+    Color   = mix(colorInner, colorOuter, smoothstep(beltDistance.x, beltDistance.y, inA));
+    Color.a = mix(alpha.y, alpha.x, clamp((inH - magnitude.x) / (magnitude.y - magnitude.x), 0, 1));
+}
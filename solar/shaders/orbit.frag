@@ -3,27 +3,26 @@
 uniform float angleVisible;
 uniform float alphaGradient;
 
-uniform float angleCurrent;
-uniform vec4  color;
-
 in float Angle;
+flat in vec4  Color;
+flat in float AngleCurrent;
 
 // 출력물
 out vec4  FragColor;
 
 void main()
 {
-    FragColor = color;
+    FragColor = Color;
 
-    // angleCurrent == -1 이면 그라디언트 사용 안 함.
-    if (angleCurrent == -1)
+    // AngleCurrent == -1 이면 그라디언트 사용 안 함.
+    if (AngleCurrent == -1)
     {
         return;
     }
 
     // alphaGradient 을 기준으로 상대적인 각도를 구한다
     // 단, 반시계방향이니까 주의
-    float angle = Angle - angleCurrent;
+    float angle = Angle - AngleCurrent;
     if (angle < 0) angle = 360 + angle;
 
     // angleVisible 까지 색 넣지 않기
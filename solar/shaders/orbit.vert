@@ -1,18 +1,40 @@
 ﻿#version 330 core
 
+// 궤도 하나의 정보
+// model_orbit.h 의 Orbits::Instance 와 std140 레이아웃을 맞춰야 함.
+struct OrbitInfo
+{
+    mat4 modelMatrix;  // 부모 행성 기준 Model-Matrix
+    vec4 color;        // 궤도 색
+    vec4 angleCurrent; // x : 현재 진근점이각. -1 이면 그라디언트 사용 안 함
+};
+
+// 크기는 ORBIT_BATCH_SIZE 와 맞춰야 함.
+layout (std140) uniform OrbitBlock
+{
+    OrbitInfo orbits[128];
+};
+
 // 상수
 uniform mat4  projectionMatrix;	// Projection-Matrix
 uniform mat4  viewMatrix;	    // View-Matrix
-uniform mat4  modelMatrix;		// Model-Matrix
 
 // 입력 데이터
-layout (location = 0) in vec4 inPos;
+layout (location = 0) in vec4  inPos;
+layout (location = 1) in float inSlot; // OrbitBlock 내의 위치
 
 // 넘기기
 out float Angle;
+flat out vec4  Color;
+flat out float AngleCurrent;
 
 void main()
 {
-	gl_Position = projectionMatrix * viewMatrix * modelMatrix * vec4(inPos.xyz, 1);
+    OrbitInfo orbit = orbits[int(inSlot)];
+
+	gl_Position = projectionMatrix * viewMatrix * orbit.modelMatrix * vec4(inPos.xyz, 1);
     Angle = inPos.w;
+
+    Color        = orbit.color;
+    AngleCurrent = orbit.angleCurrent.x;
 }
@@ -21,25 +21,111 @@ uniform sampler2D shaderTextureSpecular; // 반사광
 uniform sampler2D shaderTextureNight;    // 야간 텍스쳐
 uniform sampler2D shaderTextureCloud;    // 구름 텍스쳐
 
+// 큰 텍스쳐 (가상 텍스쳐). 주간 텍스쳐 대신 씀 (vtexture.h)
+uniform int       isVirtual;
+uniform sampler2D virtualPool;        // 타일이 올라가는 풀
+uniform sampler2D virtualPageTable;   // (단계, 타일) -> 풀 칸
+uniform vec4      virtualLevels[16];  // 단계별 (너비, 높이, 페이지 테이블 y 위치, 가로 타일 수)
+uniform int       virtualLevelCount;
+uniform vec3      virtualTile;        // (타일 크기, 테두리, 풀 칸 크기)
+
 // vert 에서 넘어오는 것들.
-in vec2 TexCoords; // 텍스쳐 좌표
+in vec3 LocalDir;  // 행성 로컬 좌표의 방향
 in vec3 Normal;    // 노말벡터
 in vec3 FragPos;   // fragment 좌표
 
 // 출력물
 out vec4 FragColor;
 
+// 텍스쳐 좌표 (equirectangular) 와 미분값
+vec2 TexCoords;
+vec2 TexCoordsDx;
+vec2 TexCoordsDy;
+
 float getBrightness(vec3 c)
 {
     return 0.299f * c.r + 0.587f * c.g + 0.114f * c.b;
 }
 
+// 방향으로 텍스쳐 좌표 계산
+// u 는 뒤쪽에서 1 -> 0 으로 튀어서 그 자리 미분값이 커지고 (밉맵이 가장 작은 걸로 잡혀서 선이 생김)
+// 0.5 만큼 돌린 좌표의 미분값을 대신 써서 막는다
+void calcTexCoords()
+{
+    vec3 d = normalize(LocalDir);
+
+    float u  = atan(d.x, d.z) / 6.283185307;
+    float uA = fract(u);
+    float uB = fract(u + 0.5) - 0.5;
+    float v  = acos(clamp(d.y, -1.0, 1.0)) / 3.141592654;
+
+    TexCoords = vec2(uA, v);
+
+    bool useB = fwidth(uB) < fwidth(uA);
+    TexCoordsDx = vec2(useB ? dFdx(uB) : dFdx(uA), dFdx(v));
+    TexCoordsDy = vec2(useB ? dFdy(uB) : dFdy(uA), dFdy(v));
+}
+
+vec4 sampleSurface(sampler2D tex)
+{
+    return textureGrad(tex, TexCoords, TexCoordsDx, TexCoordsDy);
+}
+
+// 가상 텍스쳐 한 단계 읽기
+// 페이지 테이블에서 타일이 올라가 있는 풀 칸을 찾음. 없는 타일은 더 작은 단계의 칸을 가리키므로 그 단계 좌표로 읽음
+vec4 sampleVirtualLevel(int level)
+{
+    vec4  info   = virtualLevels[level];
+    float tilesY = ceil(info.y / virtualTile.x);
+
+    vec2 tile = floor(TexCoords * info.xy / virtualTile.x);
+    tile.x = mod(tile.x, info.w);
+    tile.y = clamp(tile.y, 0.0, tilesY - 1.0);
+
+    vec4 page = texelFetch(virtualPageTable, ivec2(tile.x, info.z + tile.y), 0) * 255.0;
+
+    // 실제로 올라와 있는 단계의 타일 안 좌표. 테두리가 있어서 밖으로 조금 나가도 됨
+    vec4 resident = virtualLevels[int(page.z + 0.5)];
+    vec2 texel    = TexCoords * resident.xy;
+    vec2 inTile   = texel - clamp(floor(texel / virtualTile.x), vec2(0.0), ceil(resident.xy / virtualTile.x) - 1.0) * virtualTile.x;
+
+    vec2 pos = floor(page.xy + 0.5) * virtualTile.z + virtualTile.y + inTile;
+    return textureLod(virtualPool, pos / vec2(textureSize(virtualPool, 0)), 0.0);
+}
+
+// 가상 텍스쳐 읽기. 단계는 0 단계 텍셀 기준 미분값으로 정하고 두 단계 사이는 섞음 (trilinear)
+vec4 sampleVirtual()
+{
+    vec2 dx = TexCoordsDx * virtualLevels[0].xy;
+    vec2 dy = TexCoordsDy * virtualLevels[0].xy;
+
+    float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8));
+    lod = clamp(lod, 0.0, float(virtualLevelCount - 1));
+
+    int level = int(floor(lod));
+    int next  = min(level + 1, virtualLevelCount - 1);
+
+    return mix(sampleVirtualLevel(level), sampleVirtualLevel(next), lod - float(level));
+}
+
+// 주간 텍스쳐
+vec4 sampleBase()
+{
+    if (isVirtual != 0)
+    {
+        return sampleVirtual();
+    }
+    return sampleSurface(shaderTexture);
+}
+
 void main()
 {
+    calcTexCoords();
+
     // 태양은 언제나 태양색
     if (light.shininess == 0)
     {
-        FragColor = texture2D(shaderTexture, TexCoords);
+        FragColor = sampleBase();
         return;
     }
     
@@ -70,14 +156,14 @@ void main()
     if (isEarth == 0)
     {
         // Phong
-        FragColor = texture2D(shaderTexture, TexCoords) * vec4(ambient + diffuse + specular, 1);
+        FragColor = sampleBase() * vec4(ambient + diffuse + specular, 1);
         return;
     }
     
-    vec3 colorDay      = texture2D(shaderTexture,         TexCoords).rgb;
-    vec3 colorNight    = texture2D(shaderTextureNight,    TexCoords).rgb;
-    vec3 colorSpecular = texture2D(shaderTextureSpecular, TexCoords).rgb;
-    vec3 colorCloud    = texture2D(shaderTextureNight,    TexCoords).rgb;
+    vec3 colorDay      = sampleBase().rgb;
+    vec3 colorNight    = sampleSurface(shaderTextureNight   ).rgb;
+    vec3 colorSpecular = sampleSurface(shaderTextureSpecular).rgb;
+    vec3 colorCloud    = sampleSurface(shaderTextureNight   ).rgb;
 
     // Phong
     colorSpecular = colorSpecular * specular;
@@ -96,7 +182,7 @@ void main()
     // 구름 추가. 구름은 반사안함
     // 구름이 너무 밝아서 밝기 낮추고
     // 아침에는 잘 보이고 저녁에는 잘 안보이게 nDotL 를 범위 내에서 추가
-    color += texture2D(shaderTextureCloud, TexCoords).r * 0.3 * clamp(nDotL, 0.1, 1.0);
+    color += sampleSurface(shaderTextureCloud).r * 0.3 * clamp(nDotL, 0.1, 1.0);
 
     FragColor = vec4(color, 1);
 }
@@ -4,22 +4,33 @@
 uniform mat4 projectionMatrix;	// Projection-Matrix
 uniform mat4 viewMatrix;	    // View-Matrix
 uniform mat4 modelMatrix;		// Model-Matrix
+uniform mat3 faces[6];          // 정육면체 면. 오른쪽, 위쪽, 바깥쪽
+uniform float radius;           // 반지름
+uniform float skirtDepth;       // 치마 깊이 (크기 1 인 패치 기준, 반지름 비율)
 
 // 입력 데이터
-layout (location = 0) in vec3 inPos;     // 버텍스
-layout (location = 1) in vec3 inNormal;  // 노말 벡터 = 법선벡터
-layout (location = 2) in vec2 texCoords; // 텍스쳐 매핑
+layout (location = 0) in vec3 inGrid;  // 격자. 패치 안에서의 위치 (0 ~ 1), 치마 여부
+layout (location = 1) in vec4 inPatch; // 패치. 면 번호, 면 안에서의 위치 (0 ~ 1), 크기
 
 // frag 로 넘길 것들
-out vec2 TexCoords; // 텍스쳐 좌표
+out vec3 LocalDir;  // 행성 로컬 좌표의 방향. 텍스쳐 좌표는 frag 에서 계산
 out vec3 Normal;    // 노말벡터
 out vec3 FragPos;   // fragment 좌표
 
 void main()
 {
-	gl_Position = projectionMatrix * viewMatrix * modelMatrix * vec4(inPos, 1);
+    // 면 위의 점. tan 으로 펴서 칸 크기를 비슷하게 맞춤
+    vec2 ab = inPatch.yz + inGrid.xy * inPatch.w;
+    vec2 c  = tan((ab * 2 - 1) * 0.785398163);
+
+    vec3 dir = normalize(faces[int(inPatch.x)] * vec3(c, 1));
+
+    // 치마는 아래로
+    vec4 pos = vec4(dir * radius * (1 - inGrid.z * inPatch.w * skirtDepth), 1);
+
+	gl_Position = projectionMatrix * viewMatrix * modelMatrix * pos;
 	
-    TexCoords = texCoords;
-    Normal = vec3(viewMatrix * modelMatrix * vec4(inNormal, 0));
-    FragPos = vec3(viewMatrix * modelMatrix * vec4(inPos, 1.0));
+    LocalDir = dir;
+    Normal = vec3(viewMatrix * modelMatrix * vec4(dir, 0));
+    FragPos = vec3(viewMatrix * modelMatrix * pos);
 }
@@ -0,0 +1,242 @@
+﻿#include "simulation.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include "constants.h"
+#include "orbital.h"
+#include "planet.h"
+#include "render.h"
+#include "trace.h"
+
+namespace simulation
+{
+    // triple buffer
+    // 계산 스레드는 back 에 쓰고 middle 과 바꾸고, 렌더링 스레드는 새 것이 있을 때만 front 와 middle 을 바꾼다.
+    // middle 의 아래 2비트는 칸 번호, FRESH 는 아직 가져가지 않은 상태라는 표시
+    constexpr uint8_t SLOT_INDEX = 0x03;
+    constexpr uint8_t SLOT_FRESH = 0x04;
+
+    std::array<Snapshot, 3> slots;
+    std::atomic<uint8_t>    middle = 1;
+    uint8_t                 back   = 0; // 계산 스레드 전용
+    uint8_t                 front  = 2; // 렌더링 스레드 전용
+
+    std::thread      worker;
+    std::atomic_bool stopping = false;
+
+    // 날자 변경 요청
+    std::atomic<double> requestedDate = 0;
+    std::atomic_bool    dateRequested = false;
+
+    // 일시정지 중 바뀐 게 없으면 여기서 잠듦. setDate, 설정 변경 (notify), stop 에서 깨움
+    std::mutex              wakeLock;
+    std::condition_variable wakeSignal;
+    bool                    wakeRequested = false;
+
+    void wake()
+    {
+        {
+            std::lock_guard<std::mutex> _lock(wakeLock);
+            wakeRequested = true;
+        }
+        wakeSignal.notify_one();
+    }
+
+    void compute(State& state, const config::Config& cfg)
+    {
+        TRACE_SCOPE("simulation::compute");
+
+        const double threshold = std::pow(10.0, cfg.ephemerisPrecision);
+
+        state.locations.resize(planet::planetList.size());
+        for (size_t i = 0; i < planet::planetList.size(); i++)
+        {
+            state.locations[i] = cfg.useEphemeris
+                ? orbital::getPrecisePosition(static_cast<int>(i), state.today, threshold)
+                : orbital::getCurrentPosition(static_cast<int>(i), state.today);
+        }
+    }
+
+    void publish(const State& previous, const State& current)
+    {
+        auto& slot = slots[back];
+        slot.previous = previous;
+        slot.current  = current;
+
+        back = middle.exchange(back | SLOT_FRESH, std::memory_order_acq_rel) & SLOT_INDEX;
+    }
+
+    void loop(double today)
+    {
+        trace::setThreadName("simulation");
+
+        const auto step = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(SIMULATION_STEP_SECONDS));
+
+        State previous;
+        State current;
+        current.today = today;
+
+        bool     computed       = false;
+        uint64_t computedConfig = 0;
+
+        auto next = clock::now();
+        while (!stopping)
+        {
+            // 고정 간격. 밀렸으면 쉬지 않고 따라잡되, 너무 밀렸으면 버림
+            next += step;
+            const auto now = clock::now();
+            if (now - next > step * SIMULATION_MAX_CATCHUP_STEPS)
+            {
+                next = now;
+            }
+            std::this_thread::sleep_until(next);
+
+            if (!render::loaded()) continue;
+
+            uint64_t cfgVersion;
+            const auto cfg = config::get(&cfgVersion);
+
+            bool jumped = !computed;
+            if (dateRequested.exchange(false))
+            {
+                current.today = requestedDate;
+                jumped = true;
+            }
+
+            // 일시정지 중이고 바뀐 게 없으면 계산하지 않고 깨울 때 까지 잠듦
+            if (!jumped && !cfg.playAnimation && cfgVersion == computedConfig)
+            {
+                TRACE_SCOPE("simulation::idle");
+
+                std::unique_lock<std::mutex> _lock(wakeLock);
+                wakeSignal.wait(_lock, [] { return wakeRequested || stopping; });
+                wakeRequested = false;
+
+                // 깨어난 시점부터 다시 고정 간격
+                next = clock::now();
+                continue;
+            }
+
+            TRACE_SCOPE("simulation::step");
+
+            previous = current;
+
+            if (cfg.playAnimation && !jumped)
+            {
+                current.today += SIMULATION_STEP_SECONDS * cfg.speed;
+            }
+            current.stamp = next;
+            current.step++;
+            compute(current, cfg);
+
+            // 날자가 튀었으면 보간하지 않음
+            if (jumped)
+            {
+                previous = current;
+            }
+
+            computed       = true;
+            computedConfig = cfgVersion;
+
+            publish(previous, current);
+        }
+    }
+
+    void start(double today)
+    {
+        if (worker.joinable()) return;
+
+        stopping = false;
+        worker = std::thread(loop, today);
+
+        std::cout << "simulation : started. step: " << SIMULATION_STEP_SECONDS << " s" << std::endl;
+    }
+
+    void stop()
+    {
+        if (!worker.joinable()) return;
+
+        stopping = true;
+        wake();
+        worker.join();
+    }
+
+    bool running() noexcept
+    {
+        return worker.joinable();
+    }
+
+    void setDate(double days) noexcept
+    {
+        requestedDate = days;
+        dateRequested = true;
+        wake();
+    }
+
+    void notify() noexcept
+    {
+        wake();
+    }
+
+    bool pending() noexcept
+    {
+        return (middle.load(std::memory_order_relaxed) & SLOT_FRESH) != 0;
+    }
+
+    const Snapshot& latest() noexcept
+    {
+        if (pending())
+        {
+            front = middle.exchange(front, std::memory_order_acq_rel) & SLOT_INDEX;
+        }
+        return slots[front];
+    }
+
+    void interpolate(const Snapshot& snapshot, clock_point at, State& out)
+    {
+        const auto& a = snapshot.previous;
+        const auto& b = snapshot.current;
+
+        double t = 1;
+        if (b.stamp > a.stamp)
+        {
+            t = std::chrono::duration<double>(at - a.stamp) / std::chrono::duration<double>(b.stamp - a.stamp);
+            t = std::clamp(t, 0.0, 1.0);
+        }
+
+        out.today = a.today + (b.today - a.today) * t;
+        out.step  = b.step;
+        out.stamp = at;
+
+        // 각도 (도 단위) 차이는 가까운 쪽으로. 359 -> 1 은 +2
+        const auto wrap = [](float dw) { return dw - 360 * std::floor((dw + 180) / 360); };
+
+        out.locations.resize(b.locations.size());
+        for (size_t i = 0; i < b.locations.size(); i++)
+        {
+            const int index = static_cast<int>(i);
+            const auto& la = a.locations[i];
+            const auto& lb = b.locations[i];
+
+            // 위치를 직선으로 섞으면 빠르게 돌리는 중에는 (간격당 수십 일) 수성, 달이 궤도 안쪽 현을 따라 움직임.
+            // 보간한 날자로 케플러 궤도 위의 위치를 다시 구하고, 급수 위치와 케플러 위치의 차이만 섞는다.
+            // 케플러 궤도만 쓰면 차이는 0 이라 궤도 위의 정확한 위치가 됨
+            const auto ka = orbital::getCurrentPosition(index, a.today);
+            const auto kb = orbital::getCurrentPosition(index, b.today);
+            const auto kt = orbital::getCurrentPosition(index, out.today);
+
+            const auto xyz = glm::vec3(kt) + glm::mix(glm::vec3(la) - glm::vec3(ka), glm::vec3(lb) - glm::vec3(kb), static_cast<float>(t));
+            const auto w   = kt.w + glm::mix(wrap(la.w - ka.w), wrap(lb.w - kb.w), static_cast<float>(t));
+
+            out.locations[i] = glm::vec4(xyz, w);
+        }
+    }
+}
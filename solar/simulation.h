@@ -0,0 +1,62 @@
+﻿// 천체 위치 계산 (시뮬레이션)
+// 렌더링과 따로 고정된 간격으로 날자를 진행시키고 천체 위치를 계산한다.
+// 계산 결과는 triple buffer 로 렌더링 스레드에 넘기므로 어느 쪽도 서로를 기다리지 않는다.
+// 렌더링 스레드는 마지막 두 상태 사이를 보간해서 그린다.
+//
+// 벤치마크, 내보내기, 회귀 테스트처럼 프레임마다 날자가 정해지는 경우에는 스레드를 쓰지 않고 compute 를 직접 호출한다.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "config.h"
+
+namespace simulation
+{
+    using clock = std::chrono::steady_clock;
+    using clock_point = clock::time_point;
+
+    // 한 시점의 상태
+    struct State
+    {
+        double                 today = 0; // J2000 기준 일 수
+        uint64_t               step  = 0; // 위치를 계산한 횟수. 같으면 위치도 같음
+        clock_point            stamp;     // 이 상태가 나타내는 실제 시간
+        std::vector<glm::vec4> locations; // 천체별 부모 기준 위치 (w 는 현재 진근점이각)
+    };
+
+    // 렌더링 스레드에 넘기는 것. 보간할 수 있도록 바로 전 상태도 같이 넘긴다.
+    struct Snapshot
+    {
+        State previous;
+        State current;
+    };
+
+    // today 기준으로 천체 위치 계산
+    void compute(State& state, const config::Config& cfg);
+
+    // 계산 스레드 시작, 종료. 로딩이 끝나야 계산을 시작함
+    void start(double today);
+    void stop();
+    bool running() noexcept;
+
+    // 날자 바꾸기. 다음 간격에 반영되고, 보간하지 않고 바로 바뀜
+    void setDate(double days) noexcept;
+
+    // 설정이 바뀌었다고 알림. 일시정지 중 잠들어 있는 계산 스레드를 깨움
+    void notify() noexcept;
+
+    // 렌더링 스레드가 아직 가져가지 않은 새 상태가 있는지
+    bool pending() noexcept;
+
+    // 가장 최근 상태. 새 상태가 없으면 지난번 것을 그대로 돌려줌. 렌더링 스레드에서만 호출
+    const Snapshot& latest() noexcept;
+
+    // 두 상태 사이 보간. 시간이 범위를 벗어나면 가까운 쪽 상태
+    // 날자를 보간하고 위치는 그 날자의 궤도 위에서 다시 구함
+    void interpolate(const Snapshot& snapshot, clock_point at, State& out);
+}
@@ -0,0 +1,65 @@
+﻿// 여러 스레드에서 읽는 설정, 카메라 값을 잠금 없이 주고받기 위한 seqlock
+// 쓰는 쪽은 하나씩만 (밖에서 잠금) 쓰고, 읽는 쪽은 잠그지 않고 복사한 뒤 그동안 쓰기가 없었는지 확인한다.
+// 쓸 때마다 버전이 1 씩 올라가므로 읽는 쪽에서 값이 바뀌었는지 비교하는 데 쓸 수 있다.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+template <typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock 은 memcpy 로 복사할 수 있는 형식만 가능");
+
+private:
+    std::atomic<uint64_t> sequence = 0; // 홀수면 쓰는 중
+    T value{};
+
+public:
+    // 새 값 쓰기. 쓰는 쪽이 여럿이면 밖에서 잠가야 함
+    void publish(const T& newValue) noexcept
+    {
+        const auto seq = sequence.load(std::memory_order_relaxed);
+
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        std::memcpy(&this->value, &newValue, sizeof(T));
+
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // 마지막으로 쓴 값. 쓰는 중이면 끝날 때 까지 다시 읽음
+    T read(uint64_t* version = nullptr) const noexcept
+    {
+        T result;
+        while (true)
+        {
+            const auto before = sequence.load(std::memory_order_acquire);
+            if (before & 1)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            std::memcpy(&result, &this->value, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (sequence.load(std::memory_order_relaxed) == before)
+            {
+                if (version != nullptr) *version = before / 2;
+                return result;
+            }
+        }
+    }
+
+    // 쓴 횟수
+    uint64_t version() const noexcept
+    {
+        return sequence.load(std::memory_order_acquire) / 2;
+    }
+};
@@ -0,0 +1,175 @@
+﻿#include "trace.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "constants.h"
+
+namespace trace
+{
+    using clock = std::chrono::steady_clock;
+
+    // 구간 기록 하나. 시간은 프로그램 시작부터 ns
+    struct Event
+    {
+        const char* name;
+        int64_t     begin;
+        int64_t     end;
+    };
+
+    // 스레드 하나의 링 버퍼.
+    // 쓰는 건 그 스레드 뿐이라 head 만 atomic 으로 두고 잠금 없이 기록한다.
+    // 읽는 쪽은 복사한 다음 head 를 다시 읽어서 그 사이에 덮어씌워졌을 수 있는 기록을 버린다.
+    struct Buffer
+    {
+        int         tid = 0;
+        std::string name;
+
+        std::atomic<uint64_t> head = 0; // 지금까지 기록한 수
+        std::array<Event, TRACE_BUFFER_EVENTS> events{};
+    };
+
+    const clock::time_point origin = clock::now();
+
+    // 스레드가 끝나도 기록은 남겨둠. 등록할 때, 저장할 때만 잠금
+    std::mutex bufferLock;
+    std::vector<std::unique_ptr<Buffer>> buffers;
+
+    thread_local Buffer* local = nullptr;
+
+    /**************************************************************************************************************/
+
+    inline int64_t now() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - origin).count();
+    }
+
+    Buffer& getBuffer()
+    {
+        if (local == nullptr)
+        {
+            std::lock_guard __lock(bufferLock);
+
+            buffers.push_back(std::make_unique<Buffer>());
+            local = buffers.back().get();
+            local->tid  = static_cast<int>(buffers.size());
+            local->name = "thread " + std::to_string(local->tid);
+        }
+
+        return *local;
+    }
+
+    void setThreadName(const char* name)
+    {
+        auto& buffer = getBuffer();
+
+        std::lock_guard __lock(bufferLock);
+        buffer.name = name;
+    }
+
+    /**************************************************************************************************************/
+
+    Scope::Scope(const char* name) noexcept
+        : name(name)
+        , begin(now())
+    {
+    }
+
+    Scope::~Scope() noexcept
+    {
+        const auto end = now();
+
+        auto& buffer = getBuffer();
+        const auto index = buffer.head.load(std::memory_order_relaxed);
+
+        buffer.events[index % TRACE_BUFFER_EVENTS] = Event{ this->name, this->begin, end };
+        buffer.head.store(index + 1, std::memory_order_release);
+    }
+
+    /**************************************************************************************************************/
+
+    void writeString(std::ostream& os, const char* str)
+    {
+        os << '"';
+        for (; *str != 0; str++)
+        {
+            if (*str == '"' || *str == '\\') os << '\\';
+            os << *str;
+        }
+        os << '"';
+    }
+
+    bool dump(const std::string& path)
+    {
+        std::ofstream fs(path, std::ios::trunc);
+        if (!fs.is_open())
+        {
+            std::cout << "trace : failed to write. path: " << path << std::endl;
+            return false;
+        }
+
+        std::lock_guard __lock(bufferLock);
+
+        size_t count = 0;
+        bool first = true;
+
+        const auto separator = [&]() {
+            if (!first) fs << ',' << std::endl;
+            first = false;
+        };
+
+        fs << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl;
+        fs << std::fixed << std::setprecision(3);
+
+        std::vector<Event> events;
+        for (const auto& buffer : buffers)
+        {
+            separator();
+            fs << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid << ",\"args\":{\"name\":";
+            writeString(fs, buffer->name.c_str());
+            fs << "}}";
+
+            // 최근 기록부터 버퍼 크기만큼 복사
+            const auto head = buffer->head.load(std::memory_order_acquire);
+            const auto from = head > TRACE_BUFFER_EVENTS ? head - TRACE_BUFFER_EVENTS : 0;
+
+            events.clear();
+            for (auto i = from; i < head; i++)
+            {
+                events.push_back(buffer->events[i % TRACE_BUFFER_EVENTS]);
+            }
+
+            // 복사하는 동안 덮어씌워진 기록은 버림
+            const auto headAfter = buffer->head.load(std::memory_order_acquire);
+            const auto valid = headAfter >= TRACE_BUFFER_EVENTS ? headAfter - TRACE_BUFFER_EVENTS + 1 : 0;
+
+            for (auto i = std::max(from, valid); i < head; i++)
+            {
+                const auto& e = events[i - from];
+
+                separator();
+                fs << "{\"name\":";
+                writeString(fs, e.name);
+                fs << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+                   << ",\"ts\":"  << e.begin / 1e3
+                   << ",\"dur\":" << (e.end - e.begin) / 1e3
+                   << '}';
+
+                count++;
+            }
+        }
+
+        fs << std::endl << "]}" << std::endl;
+
+        std::cout << "trace : saved " << path << ". events: " << count << std::endl;
+        return true;
+    }
+}
@@ -0,0 +1,52 @@
+﻿// CPU 구간 기록
+// TRACE_SCOPE("name") 을 둔 곳부터 블록이 끝날 때 까지의 시간을 스레드별 링 버퍼에 기록하고
+// Chrome trace_event 형식 JSON 으로 저장한다. (chrome://tracing, Perfetto 에서 열 수 있음)
+// 디버그 빌드이거나 ENABLE_TRACE 를 정의하고 빌드해야 기록함. 아니면 TRACE_SCOPE 는 아무것도 안 함.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "defer.h"
+
+#if defined(_DEBUG) || defined(ENABLE_TRACE)
+#define TRACE_ENABLED
+#endif
+
+namespace trace
+{
+#ifdef TRACE_ENABLED
+    constexpr bool ENABLED = true;
+#else
+    constexpr bool ENABLED = false;
+#endif
+
+    // 지금 스레드의 이름. 결과 파일에 스레드 이름으로 표시됨
+    void setThreadName(const char* name);
+
+    // 구간. 생성할 때 시작, 소멸할 때 끝.
+    // name 은 저장할 때 까지 유지되는 문자열이어야 함 (리터럴, 천체 이름)
+    class Scope
+    {
+    private:
+        const char* name;
+        int64_t     begin;
+
+    public:
+        explicit Scope(const char* name) noexcept;
+        ~Scope() noexcept;
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    // 모든 스레드의 기록을 JSON 으로 저장. 기록중인 스레드가 있어도 호출할 수 있다.
+    bool dump(const std::string& path);
+}
+
+#ifdef TRACE_ENABLED
+#define TRACE_SCOPE(name) trace::Scope MAKE_TOKEN(_temp_trace,__LINE__){name}
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#endif
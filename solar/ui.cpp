@@ -1,16 +1,25 @@
 ﻿#include "ui.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
 #include <imgui.h>
 #include <imgui_internal.h>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 
 #include "camera.h"
+#include "catalog.h"
 #include "config.h"
 #include "constants.h"
 #include "defer.h"
+#include "ephemeris.h"
+#include "input.h"
 #include "planet.h"
+#include "profiler.h"
 #include "render.h"
+#include "trace.h"
 
 namespace ui
 {
@@ -20,6 +29,28 @@ namespace ui
 
     ImVec2 size, location;
 
+    std::chrono::steady_clock::time_point lastFrame; // 마지막으로 그린 시간
+
+    // 입력 넣기
+    // GLFW 의 상태를 읽는 함수는 메인 스레드에서만 불러야 해서 ImGui_ImplGlfw_NewFrame 대신 input 이 받아둔 값을 씀
+    void newFrame(v::Size2f winRect)
+    {
+        auto& imio = ImGui::GetIO();
+
+        const auto now = std::chrono::steady_clock::now();
+        imio.DeltaTime = std::max(std::chrono::duration<float>(now - lastFrame).count(), 1.0f / 1000);
+        lastFrame = now;
+
+        imio.DisplaySize = ImVec2(winRect.w, winRect.h);
+
+        const auto cursor = input::cursor();
+        imio.MousePos = ImVec2(cursor.x, cursor.y);
+        for (int i = 0; i < IM_ARRAYSIZE(imio.MouseDown); i++)
+        {
+            imio.MouseDown[i] = input::buttonDown(i);
+        }
+    }
+
     void init(GLFWwindow* window)
     {
         IMGUI_CHECKVERSION();
@@ -35,6 +66,20 @@ namespace ui
         ImGui_ImplGlfw_InitForOpenGL(window, false);
     }
 
+    // 포커스 할 천체 목록. 자식 천체는 들여쓰기
+    void focusList(int& focused, int index, int depth)
+    {
+        ImGui::PushID(index);
+        defer(ImGui::PopID());
+
+        ImGui::Dummy(ImVec2(15.0f * (depth + 1), 0)); ImGui::SameLine(); ImGui::RadioButton(catalog::bodies().name(index), &focused, index);
+
+        for (const auto childIndex : catalog::children(index))
+        {
+            focusList(focused, childIndex, depth + 1);
+        }
+    }
+
     bool hitTest(v::Point2f pos) noexcept
     {
         return
@@ -53,7 +98,7 @@ namespace ui
         camera::Camera cam = camc;
 
         ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
+        newFrame(winRect);
 
         {
             ImGui::NewFrame();
@@ -131,6 +176,8 @@ namespace ui
                         ImGui::PopStyleVar();
                     }
 
+                    ImGui::Checkbox("Show asteroids", &cfg.showMinorBodies);
+
                     ImGui::Dummy(ImVec2(0, 10));
                     ImGui::Separator();
                     ImGui::Dummy(ImVec2(0, 10));
@@ -155,17 +202,10 @@ namespace ui
                     ImGui::Dummy(ImVec2(0, 10));
 
                     ImGui::Text("Focusing");
-                    ImGui::Dummy(ImVec2(15, 0)); ImGui::SameLine(); ImGui::RadioButton("Sun",     &cam.focusedPlanet, planet::PlanetIndex::Sun    );
-                    ImGui::Dummy(ImVec2(15, 0)); ImGui::SameLine(); ImGui::RadioButton("Mercury", &cam.focusedPlanet, planet::PlanetIndex::Mercury);
-                    ImGui::Dummy(ImVec2(15, 0)); ImGui::SameLine(); ImGui::RadioButton("Venus",   &cam.focusedPlanet, planet::PlanetIndex::Venus  );
-                    ImGui::Dummy(ImVec2(15, 0)); ImGui::SameLine(); ImGui::RadioButton("Earth",   &cam.focusedPlanet, planet::PlanetIndex::Earth  );
-                    ImGui::Dummy(ImVec2(30, 0)); ImGui::SameLine(); ImGui::RadioButton("Moon",    &cam.focusedPlanet, planet::PlanetIndex::Moon   );
-                    ImGui::Dummy(ImVec2(15, 0)); ImGui::SameLine(); ImGui::RadioButton("Mars",    &cam.focusedPlanet, planet::PlanetIndex::Mars   );
-                    ImGui::Dummy(ImVec2(15, 0)); ImGui::SameLine(); ImGui::RadioButton("Jupiter", &cam.focusedPlanet, planet::PlanetIndex::Jupiter);
-                    ImGui::Dummy(ImVec2(15, 0)); ImGui::SameLine(); ImGui::RadioButton("Saturn",  &cam.focusedPlanet, planet::PlanetIndex::Saturn );
-                    ImGui::Dummy(ImVec2(15, 0)); ImGui::SameLine(); ImGui::RadioButton("Uranus",  &cam.focusedPlanet, planet::PlanetIndex::Uranus );
-                    ImGui::Dummy(ImVec2(15, 0)); ImGui::SameLine(); ImGui::RadioButton("Neptune", &cam.focusedPlanet, planet::PlanetIndex::Neptune);
-                    ImGui::Dummy(ImVec2(15, 0)); ImGui::SameLine(); ImGui::RadioButton("Pluto",   &cam.focusedPlanet, planet::PlanetIndex::Pluto  );
+                    for (const auto& planet : planet::planetList)
+                    {
+                        if (planet.parentIndex() == -1) focusList(cam.focusedPlanet, planet._index, 0);
+                    }
 
                     ImGui::Dummy(ImVec2(0, 10));
                     ImGui::Separator();
@@ -182,7 +222,71 @@ namespace ui
                     defer(ImGui::EndTabItem());
 
                     ImGui::Checkbox("VSync", &cfg.vsync);
+                    ImGui::Checkbox("Render on demand", &cfg.renderOnDemand);
                     ImGui::Checkbox("MSAA MultiSampling", &cfg.enableMSAA);
+
+                    ImGui::Dummy(ImVec2(0, 10));
+                    ImGui::Separator();
+                    ImGui::Dummy(ImVec2(0, 10));
+
+                    ImGui::Checkbox("Precise ephemeris", &cfg.useEphemeris);
+                    if (!cfg.useEphemeris)
+                    {
+                        ImGui::PushItemFlag(ImGuiItemFlags_Disabled, true);
+                        ImGui::PushStyleVar(ImGuiStyleVar_Alpha, ImGui::GetStyle().Alpha * 0.5f);
+                    }
+                    ImGui::Dummy(ImVec2(15, 0)); ImGui::SameLine(); ImGui::Text("Truncation (log10 AU)");
+                    ImGui::Dummy(ImVec2(15, 0)); ImGui::SameLine(); ImGui::SliderInt("##ephemeris", &cfg.ephemerisPrecision, EPHEMERIS_PRECISION_MIN, EPHEMERIS_PRECISION_MAX);
+                    ImGui::Dummy(ImVec2(15, 0)); ImGui::SameLine(); ImGui::Text("%zu terms", ephemeris::countTerms(std::pow(10.0, cfg.ephemerisPrecision)));
+                    if (!cfg.useEphemeris)
+                    {
+                        ImGui::PopItemFlag();
+                        ImGui::PopStyleVar();
+                    }
+                }
+
+                if (ImGui::BeginTabItem("PERFORMANCE"))
+                {
+                    defer(ImGui::EndTabItem());
+
+                    ImGui::Checkbox("GPU timers", &cfg.enableProfiler);
+
+                    ImGui::Dummy(ImVec2(0, 10));
+
+                    // 구간별 GPU 시간. 들여쓰기는 중첩 깊이
+                    ImGui::Columns(4, "##profiler");
+
+                    ImGui::Text("Scope");   ImGui::NextColumn();
+                    ImGui::Text("Last ms"); ImGui::NextColumn();
+                    ImGui::Text("Avg ms");  ImGui::NextColumn();
+                    ImGui::Text("Max ms");  ImGui::NextColumn();
+                    ImGui::Separator();
+
+                    for (const auto& r : profiler::results())
+                    {
+                        ImGui::Dummy(ImVec2(10.0f * r.depth, 0)); ImGui::SameLine(); ImGui::Text("%s", r.name.c_str()); ImGui::NextColumn();
+                        ImGui::Text("%.3f", r.lastMs); ImGui::NextColumn();
+                        ImGui::Text("%.3f", r.avgMs ); ImGui::NextColumn();
+                        ImGui::Text("%.3f", r.maxMs ); ImGui::NextColumn();
+                    }
+
+                    ImGui::Columns(1);
+                    ImGui::Dummy(ImVec2(0, 10));
+
+                    if (ImGui::Button("Export CSV"))
+                    {
+                        profiler::exportCSV(PROFILER_CSV_PATH);
+                    }
+
+                    // CPU 구간 기록은 ENABLE_TRACE 빌드에서만
+                    if constexpr (trace::ENABLED)
+                    {
+                        ImGui::SameLine();
+                        if (ImGui::Button("Save CPU trace"))
+                        {
+                            trace::dump(TRACE_JSON_PATH);
+                        }
+                    }
                 }
             }
         }
@@ -1,13 +1,18 @@
 ﻿#include "utils.h"
 
+#include <cstdlib>
+#include <filesystem>
 #include <random>
 
+#ifdef _WIN32
 #include <Windows.h>
+#endif
 
 #include "constants.h"
 
 namespace utils
 {
+#ifdef _WIN32
     std::wstring str2wcs(const std::string& str)
     {
         // 필요 길이 측정
@@ -35,14 +40,56 @@ namespace utils
 
         return str;
     }
+#else
+    // 윈도우가 아니면 현재 locale 기준으로 변환
+    std::wstring str2wcs(const std::string& str)
+    {
+        std::wstring wcs(str.size() + 1, 0);
+        const auto length = std::mbstowcs(wcs.data(), str.c_str(), wcs.size());
+        wcs.resize(length == static_cast<size_t>(-1) ? 0 : length);
+
+        return wcs;
+    }
+
+    std::string wcs2str(const std::wstring& wcs)
+    {
+        std::string str(wcs.size() * MB_LEN_MAX + 1, 0);
+        const auto length = std::wcstombs(str.data(), wcs.c_str(), str.size());
+        str.resize(length == static_cast<size_t>(-1) ? 0 : length);
+
+        return str;
+    }
+#endif
 
     double rand()
     {
         static std::random_device rn;
         static std::mt19937_64 rnd(rn());
 
-        const std::uniform_real_distribution<double> range(0, 1);
+        std::uniform_real_distribution<double> range(0, 1);
 
         return range(rnd);
     }
+
+    void gmtime(int64_t timestamp, tm& out)
+    {
+#ifdef _WIN32
+        const __time64_t tt = timestamp;
+        _gmtime64_s(&out, &tt);
+#else
+        const time_t tt = static_cast<time_t>(timestamp);
+        gmtime_r(&tt, &out);
+#endif
+    }
+
+    bool isCacheFresh(const std::string& cachePath, const std::string& sourcePath)
+    {
+        namespace fs = std::filesystem;
+
+        std::error_code ec;
+        if (!fs::exists(cachePath, ec)) return false;
+        if (!fs::exists(sourcePath, ec)) return true;
+
+        return fs::last_write_time(cachePath, ec) >= fs::last_write_time(sourcePath, ec);
+    }
 }
@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include <cstdint>
+#include <ctime>
 #include <string>
 
 #include "constants.h"
@@ -12,4 +14,10 @@ namespace utils
     std::string  wcs2str(const std::wstring& wcs); // wchar -> char 변환 함수.
 
     double rand();
+
+    // UTC 기준 timestamp -> tm 변환. gmtime 의 스레드 안전한 버전이 플랫폼마다 달라서 감쌈
+    void gmtime(int64_t timestamp, tm& out);
+
+    // 변환해둔 캐시 파일을 그대로 써도 되는지. 캐시가 있고, 원본이 없거나 캐시보다 오래되었으면 true
+    bool isCacheFresh(const std::string& cachePath, const std::string& sourcePath);
 }
@@ -0,0 +1,719 @@
+﻿#include "vtexture.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "constants.h"
+#include "defer.h"
+#include "glext.h"
+#include "trace.h"
+#include "utils.h"
+
+namespace vtexture
+{
+    constexpr uint32_t FILE_MAGIC   = 0x58455456; // VTEX
+    constexpr uint32_t FILE_VERSION = 1;
+
+    constexpr int    POOL_SIZE  = VTEX_POOL_SLOTS * VTEX_TILE_SLOT; // 풀 텍스쳐 크기 (픽셀)
+    constexpr size_t TILE_BYTES = static_cast<size_t>(VTEX_TILE_SLOT) * VTEX_TILE_SLOT * 4;
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        int32_t  width;    // 0 단계 크기
+        int32_t  height;
+        int32_t  tileSize; // 만들 때의 VTEX_TILE_SIZE, VTEX_TILE_BORDER. 바뀌었으면 다시 만듦
+        int32_t  border;
+        int32_t  levels;
+        int32_t  reserved;
+    };
+
+    struct Level
+    {
+        int    width;
+        int    height;
+        int    tilesX;
+        int    tilesY;
+        size_t firstTile; // 이 단계 첫 타일 번호 (파일, tiles 같음)
+        int    pageY;     // 페이지 테이블에서의 y 위치
+    };
+
+    struct Tile
+    {
+        int      slot     = -1;    // 올라가 있는 풀 칸. 없으면 -1
+        bool     queued   = false; // 읽기 스레드에 요청함
+        uint64_t rejected = 0;     // 풀이 꽉 차서 못 올린 프레임. 한동안 다시 요청하지 않음
+
+        std::atomic<uint64_t> wanted = 0; // 마지막으로 필요했던 프레임. 읽기 스레드도 봄
+    };
+
+    struct Texture
+    {
+        std::string        name;
+        int                width  = 0;
+        int                height = 0;
+        std::vector<Level> levels;
+        std::vector<Tile>  tiles;
+
+        std::ifstream file;
+        std::mutex    fileLock; // 읽기 스레드와 GL 스레드 (setAsync(false)) 가 같이 읽음
+
+        GLuint               pageTable = 0;
+        v::Size2i            pageSize  = 0;
+        std::vector<uint8_t> page;             // 페이지 테이블 (RGBA)
+        bool                 pageDirty = true; // 타일이 올라가거나 빠져서 다시 만들어야 함
+    };
+
+    // 풀 한 칸
+    struct Slot
+    {
+        int      texture = -1; // 없으면 -1
+        size_t   tile    = 0;
+        uint64_t used    = 0;  // 마지막으로 쓴 프레임
+        bool     pinned  = false;
+    };
+
+    struct Job
+    {
+        int    texture;
+        size_t tile;
+        int    level;
+    };
+
+    struct Loaded
+    {
+        int                  texture;
+        size_t               tile;
+        std::vector<uint8_t> pixels; // 비어있으면 읽지 않고 버린 것
+    };
+
+    // 로딩 스레드에서 추가하고 GL 스레드, 읽기 스레드에서 찾음. 한번 추가하면 옮겨지지 않음
+    std::mutex                            texturesLock;
+    std::vector<std::unique_ptr<Texture>> textures;
+
+    // GL 스레드 전용
+    GLuint            pool = 0;
+    std::vector<Slot> slots;
+
+    std::atomic<uint64_t> frame = 1;
+    std::atomic_bool      async = false;
+
+    // 읽기 스레드
+    std::thread             worker;
+    std::atomic_bool        stopping = false;
+    std::mutex              jobLock;
+    std::condition_variable jobSignal;
+    std::vector<Job>        jobs;
+    std::mutex              doneLock;
+    std::vector<Loaded>     done;
+    std::atomic<size_t>     inFlight = 0; // 요청했지만 아직 처리하지 않은 타일 수
+
+    Texture& get(int id)
+    {
+        std::lock_guard<std::mutex> _lock(texturesLock);
+        return *textures.at(id);
+    }
+
+    // 단계별 크기. 타일 하나에 다 들어가는 단계까지
+    std::vector<Level> buildLevels(int width, int height)
+    {
+        std::vector<Level> levels;
+
+        size_t firstTile = 0;
+        int    pageY     = 0;
+        while (true)
+        {
+            Level level;
+            level.width     = width;
+            level.height    = height;
+            level.tilesX    = (width  + VTEX_TILE_SIZE - 1) / VTEX_TILE_SIZE;
+            level.tilesY    = (height + VTEX_TILE_SIZE - 1) / VTEX_TILE_SIZE;
+            level.firstTile = firstTile;
+            level.pageY     = pageY;
+            levels.push_back(level);
+
+            firstTile += static_cast<size_t>(level.tilesX) * level.tilesY;
+            pageY     += level.tilesY;
+
+            if (width <= VTEX_TILE_SIZE && height <= VTEX_TILE_SIZE) break;
+
+            width  = std::max(1, width  / 2);
+            height = std::max(1, height / 2);
+        }
+
+        return levels;
+    }
+
+    // PNG 를 타일로 잘라서 .vtex 로 저장
+    void convert(const std::string& textureName, const std::string& path)
+    {
+        TRACE_SCOPE("vtexture::convert");
+
+        // 0 단계. BGRA, 위쪽 줄부터
+        std::vector<uint8_t> pixels;
+        int w = 0;
+        int h = 0;
+        glext::readImage(textureName, [&](const uint8_t* bgra, v::Size2i size, int stride) {
+            w = size.w;
+            h = size.h;
+
+            pixels.resize(static_cast<size_t>(w) * h * 4);
+            for (int y = 0; y < h; y++)
+            {
+                std::memcpy(&pixels[static_cast<size_t>(y) * w * 4], bgra + static_cast<size_t>(y) * stride, static_cast<size_t>(w) * 4);
+            }
+        });
+
+        const auto levels = buildLevels(w, h);
+        if (levels.size() > VTEX_MAX_LEVELS)
+        {
+            throw std::runtime_error("Virtual texture is too large. name: " + textureName);
+        }
+
+        // 다 쓰고 나서 이름을 바꿔서 중간에 끊겨도 망가진 파일이 남지 않게 함
+        const auto temp = path + ".tmp";
+        {
+            std::ofstream fs(temp, std::ios::binary | std::ios::trunc);
+            if (!fs.is_open())
+            {
+                throw std::runtime_error("Failed to write virtual texture. path: " + temp);
+            }
+
+            const Header header{ FILE_MAGIC, FILE_VERSION, w, h, VTEX_TILE_SIZE, VTEX_TILE_BORDER, static_cast<int32_t>(levels.size()), 0 };
+            fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+            std::vector<uint8_t> tile(TILE_BYTES);
+            for (size_t l = 0; l < levels.size(); l++)
+            {
+                const auto& level = levels[l];
+
+                // 테두리 포함해서 자르기. 가로는 돌아가고 (경도) 세로는 끝에서 멈춤 (극)
+                for (int ty = 0; ty < level.tilesY; ty++)
+                {
+                    for (int tx = 0; tx < level.tilesX; tx++)
+                    {
+                        for (int y = 0; y < VTEX_TILE_SLOT; y++)
+                        {
+                            const int sy = std::clamp(ty * VTEX_TILE_SIZE + y - VTEX_TILE_BORDER, 0, h - 1);
+                            for (int x = 0; x < VTEX_TILE_SLOT; x++)
+                            {
+                                int sx = (tx * VTEX_TILE_SIZE + x - VTEX_TILE_BORDER) % w;
+                                if (sx < 0) sx += w;
+
+                                std::memcpy(
+                                    &tile[(static_cast<size_t>(y) * VTEX_TILE_SLOT + x) * 4],
+                                    &pixels[(static_cast<size_t>(sy) * w + sx) * 4],
+                                    4
+                                );
+                            }
+                        }
+                        fs.write(reinterpret_cast<const char*>(tile.data()), tile.size());
+                    }
+                }
+
+                // 다음 단계. 2x2 평균
+                if (l + 1 < levels.size())
+                {
+                    const int nw = levels[l + 1].width;
+                    const int nh = levels[l + 1].height;
+
+                    std::vector<uint8_t> next(static_cast<size_t>(nw) * nh * 4);
+                    for (int y = 0; y < nh; y++)
+                    {
+                        const int y0 = std::min(y * 2,     h - 1);
+                        const int y1 = std::min(y * 2 + 1, h - 1);
+                        for (int x = 0; x < nw; x++)
+                        {
+                            const int x0 = std::min(x * 2,     w - 1);
+                            const int x1 = std::min(x * 2 + 1, w - 1);
+                            for (int c = 0; c < 4; c++)
+                            {
+                                const int sum =
+                                    pixels[(static_cast<size_t>(y0) * w + x0) * 4 + c] +
+                                    pixels[(static_cast<size_t>(y0) * w + x1) * 4 + c] +
+                                    pixels[(static_cast<size_t>(y1) * w + x0) * 4 + c] +
+                                    pixels[(static_cast<size_t>(y1) * w + x1) * 4 + c];
+                                next[(static_cast<size_t>(y) * nw + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+                            }
+                        }
+                    }
+
+                    pixels.swap(next);
+                    w = nw;
+                    h = nh;
+                }
+            }
+
+            if (!fs)
+            {
+                throw std::runtime_error("Failed to write virtual texture. path: " + temp);
+            }
+        }
+
+        std::filesystem::rename(temp, path);
+
+        std::cout << "vtexture : converted. name: " << textureName << ", size: " << levels[0].width << "x" << levels[0].height << ", levels: " << levels.size() << std::endl;
+    }
+
+    bool open(Texture& tex, const std::string& path, Header& header)
+    {
+        tex.file.close();
+        tex.file.clear();
+        tex.file.open(path, std::ios::binary);
+        if (!tex.file.is_open()) return false;
+
+        tex.file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+        return tex.file &&
+            header.magic    == FILE_MAGIC &&
+            header.version  == FILE_VERSION &&
+            header.tileSize == VTEX_TILE_SIZE &&
+            header.border   == VTEX_TILE_BORDER;
+    }
+
+    bool readTile(Texture& tex, size_t index, std::vector<uint8_t>& pixels)
+    {
+        std::lock_guard<std::mutex> _lock(tex.fileLock);
+
+        pixels.resize(TILE_BYTES);
+
+        tex.file.clear();
+        tex.file.seekg(static_cast<std::streamoff>(sizeof(Header) + index * TILE_BYTES));
+        tex.file.read(reinterpret_cast<char*>(pixels.data()), pixels.size());
+
+        return static_cast<bool>(tex.file);
+    }
+
+    // 빈 칸이나, 지난 프레임부터 쓰지 않은 칸 중에 가장 오래된 칸. 없으면 -1
+    int allocate()
+    {
+        int      victim = -1;
+        uint64_t oldest = UINT64_MAX;
+        for (size_t i = 0; i < slots.size(); i++)
+        {
+            const auto& slot = slots[i];
+            if (slot.texture < 0) return static_cast<int>(i);
+
+            if (slot.pinned || slot.used + 1 >= frame) continue;
+            if (slot.used < oldest)
+            {
+                oldest = slot.used;
+                victim = static_cast<int>(i);
+            }
+        }
+
+        if (victim >= 0)
+        {
+            auto& owner = get(slots[victim].texture);
+            owner.tiles[slots[victim].tile].slot = -1;
+            owner.pageDirty = true;
+
+            slots[victim] = Slot{};
+        }
+
+        return victim;
+    }
+
+    // 타일을 풀 칸에 올리기
+    void place(int id, Texture& tex, size_t index, int slot, const std::vector<uint8_t>& pixels)
+    {
+        glBindTexture(GL_TEXTURE_2D, pool);
+        defer(glBindTexture(GL_TEXTURE_2D, 0));
+
+        glTexSubImage2D(
+            GL_TEXTURE_2D,
+            0,
+            (slot % VTEX_POOL_SLOTS) * VTEX_TILE_SLOT,
+            (slot / VTEX_POOL_SLOTS) * VTEX_TILE_SLOT,
+            VTEX_TILE_SLOT,
+            VTEX_TILE_SLOT,
+            GL_BGRA,
+            GL_UNSIGNED_BYTE,
+            pixels.data()
+        );
+        glext::countUpload(TILE_BYTES);
+
+        slots[slot].texture = id;
+        slots[slot].tile    = index;
+        slots[slot].used    = frame;
+
+        tex.tiles[index].slot = slot;
+        tex.pageDirty = true;
+    }
+
+    // 단계별로 각 타일이 쓸 풀 칸 정하기. 없는 타일은 한 단계 작은 타일이 쓰는 칸을 그대로 씀
+    void buildPage(Texture& tex)
+    {
+        const int last = static_cast<int>(tex.levels.size()) - 1;
+        for (int l = last; l >= 0; l--)
+        {
+            const auto& level = tex.levels[l];
+            for (int ty = 0; ty < level.tilesY; ty++)
+            {
+                for (int tx = 0; tx < level.tilesX; tx++)
+                {
+                    auto p = &tex.page[(static_cast<size_t>(level.pageY + ty) * tex.pageSize.w + tx) * 4];
+
+                    const auto& tile = tex.tiles[level.firstTile + static_cast<size_t>(ty) * level.tilesX + tx];
+                    if (tile.slot >= 0 || l == last)
+                    {
+                        const int slot = std::max(tile.slot, 0);
+                        p[0] = static_cast<uint8_t>(slot % VTEX_POOL_SLOTS);
+                        p[1] = static_cast<uint8_t>(slot / VTEX_POOL_SLOTS);
+                        p[2] = static_cast<uint8_t>(l);
+                        p[3] = 255;
+                        continue;
+                    }
+
+                    // 타일 가운데가 들어있는 한 단계 작은 타일
+                    const auto& parent = tex.levels[l + 1];
+                    const int px = std::min(static_cast<int>((tx + 0.5f) * VTEX_TILE_SIZE * parent.width  / level.width ) / VTEX_TILE_SIZE, parent.tilesX - 1);
+                    const int py = std::min(static_cast<int>((ty + 0.5f) * VTEX_TILE_SIZE * parent.height / level.height) / VTEX_TILE_SIZE, parent.tilesY - 1);
+
+                    std::memcpy(p, &tex.page[(static_cast<size_t>(parent.pageY + py) * tex.pageSize.w + px) * 4], 4);
+                }
+            }
+        }
+    }
+
+    void loop()
+    {
+        trace::setThreadName("vtexture");
+
+        while (true)
+        {
+            Job job;
+            {
+                std::unique_lock<std::mutex> _lock(jobLock);
+                jobSignal.wait(_lock, [] { return stopping || !jobs.empty(); });
+                if (stopping) return;
+
+                // 작은 단계 (없는 타일 대신 쓰이는 것) 부터. 같으면 최근에 요청한 것부터
+                auto best = jobs.end() - 1;
+                for (auto it = jobs.begin(); it != jobs.end(); ++it)
+                {
+                    if (it->level > best->level) best = it;
+                }
+                job = *best;
+                jobs.erase(best);
+            }
+
+            TRACE_SCOPE("vtexture::read");
+
+            auto& tex = get(job.texture);
+
+            // 한참 요청이 없었던 타일은 화면에서 사라졌으므로 읽지 않음
+            Loaded loaded{ job.texture, job.tile, {} };
+            if (frame - tex.tiles[job.tile].wanted <= VTEX_REQUEST_EXPIRE_FRAMES)
+            {
+                if (!readTile(tex, job.tile, loaded.pixels)) loaded.pixels.clear();
+            }
+
+            std::lock_guard<std::mutex> _lock(doneLock);
+            done.push_back(std::move(loaded));
+        }
+    }
+
+    void start()
+    {
+        if (worker.joinable()) return;
+
+        glGenTextures(1, &pool);
+        glBindTexture(GL_TEXTURE_2D, pool);
+        defer(glBindTexture(GL_TEXTURE_2D, 0));
+
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, POOL_SIZE, POOL_SIZE, 0, GL_BGRA, GL_UNSIGNED_BYTE, NULL);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        slots.assign(static_cast<size_t>(VTEX_POOL_SLOTS) * VTEX_POOL_SLOTS, Slot{});
+
+        stopping = false;
+        worker = std::thread(loop);
+
+        std::cout << "vtexture : started. pool: " << POOL_SIZE << "x" << POOL_SIZE
+                  << " (" << (static_cast<size_t>(POOL_SIZE) * POOL_SIZE * 4 >> 20) << " MB), slots: " << slots.size() << std::endl;
+    }
+
+    void stop()
+    {
+        if (!worker.joinable()) return;
+
+        stopping = true;
+        jobSignal.notify_all();
+        worker.join();
+    }
+
+    int load(const std::string& textureName)
+    {
+        TRACE_SCOPE("vtexture::load");
+
+        std::cout << "vtexture : load. textureName: " << textureName << std::endl;
+
+        auto tex = std::make_unique<Texture>();
+        tex->name = textureName;
+
+        // 없거나, PNG 가 더 새 것이거나, 타일 설정이 바뀌었으면 다시 만듦
+        const auto path = getVirtualTexturePath(textureName);
+
+        Header header{};
+        if (!utils::isCacheFresh(path, getTexturePath(textureName)) || !open(*tex, path, header))
+        {
+            convert(textureName, path);
+
+            if (!open(*tex, path, header))
+            {
+                throw std::runtime_error("Failed to open virtual texture. path: " + path);
+            }
+        }
+
+        tex->width  = header.width;
+        tex->height = header.height;
+        tex->levels = buildLevels(header.width, header.height);
+        if (static_cast<int>(tex->levels.size()) != header.levels || tex->levels.size() > VTEX_MAX_LEVELS)
+        {
+            throw std::runtime_error("Invalid virtual texture. path: " + path);
+        }
+
+        const auto& last = tex->levels.back();
+        tex->tiles    = std::vector<Tile>(last.firstTile + static_cast<size_t>(last.tilesX) * last.tilesY);
+        tex->pageSize = v::Size2i(tex->levels[0].tilesX, last.pageY + last.tilesY);
+        tex->page.resize(static_cast<size_t>(tex->pageSize.w) * tex->pageSize.h * 4);
+
+        // 가장 작은 단계 (타일 하나) 는 항상 올려둠. 없는 타일은 결국 여기로 떨어짐
+        const size_t lastTile = last.firstTile;
+
+        std::vector<uint8_t> pixels;
+        if (!readTile(*tex, lastTile, pixels))
+        {
+            throw std::runtime_error("Failed to read virtual texture. path: " + path);
+        }
+
+        int id;
+        {
+            std::lock_guard<std::mutex> _lock(texturesLock);
+            textures.push_back(std::move(tex));
+            id = static_cast<int>(textures.size() - 1);
+        }
+
+        auto& t = get(id);
+        glext::dispatch([&]() {
+            glGenTextures(1, &t.pageTable);
+            glBindTexture(GL_TEXTURE_2D, t.pageTable);
+            defer(glBindTexture(GL_TEXTURE_2D, 0));
+
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, t.pageSize.w, t.pageSize.h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+            const int slot = allocate();
+            if (slot < 0)
+            {
+                throw std::runtime_error("Virtual texture pool is full! name: " + textureName);
+            }
+            slots[slot].pinned = true;
+
+            place(id, t, lastTile, slot, pixels);
+        });
+
+        std::cout << "vtexture : loaded. name: " << textureName << ", size: " << t.width << "x" << t.height
+                  << ", levels: " << t.levels.size() << ", tiles: " << t.tiles.size() << std::endl;
+
+        return id;
+    }
+
+    void setAsync(bool value) noexcept
+    {
+        async = value;
+    }
+
+    // 타일이 필요하다고 표시. 없으면 읽기 요청
+    void touch(int id, Texture& tex, size_t index, int level, uint64_t now)
+    {
+        auto& tile = tex.tiles[index];
+        tile.wanted = now;
+
+        if (tile.slot >= 0)
+        {
+            slots[tile.slot].used = now;
+            return;
+        }
+        if (tile.queued) return;
+        if (tile.rejected != 0 && now - tile.rejected < VTEX_REQUEST_EXPIRE_FRAMES) return;
+
+        if (async)
+        {
+            tile.queued = true;
+            inFlight++;
+            {
+                std::lock_guard<std::mutex> _lock(jobLock);
+                jobs.push_back(Job{ id, index, level });
+            }
+            jobSignal.notify_one();
+            return;
+        }
+
+        // 그 자리에서 읽기
+        std::vector<uint8_t> pixels;
+        if (!readTile(tex, index, pixels)) return;
+
+        const int slot = allocate();
+        if (slot < 0)
+        {
+            tile.rejected = now;
+            return;
+        }
+        place(id, tex, index, slot, pixels);
+    }
+
+    void request(int id, glm::vec2 uvMin, glm::vec2 uvMax, float pixelsPerV)
+    {
+        auto& tex = get(id);
+        const uint64_t now = frame;
+
+        // 화면 한 픽셀에 0 단계 텍셀이 몇 개 들어가는지. u 1 은 (적도에서) v 1 보다 두 배 김
+        const float texels = std::max(tex.width / 2.0f, static_cast<float>(tex.height)) / std::max(pixelsPerV, 1e-6f);
+        const int   last   = static_cast<int>(tex.levels.size()) - 1;
+        const int   first  = std::clamp(static_cast<int>(std::floor(std::log2(std::max(texels, 1e-6f)))), 0, last);
+
+        // 필요한 단계부터 가장 작은 단계까지. 없는 타일 대신 쓸 작은 단계도 올려둠
+        for (int l = first; l <= last; l++)
+        {
+            const auto& level = tex.levels[l];
+
+            int tx0 = static_cast<int>(std::floor(uvMin.x * level.width / VTEX_TILE_SIZE));
+            int tx1 = static_cast<int>(std::floor(uvMax.x * level.width / VTEX_TILE_SIZE));
+            if (tx1 - tx0 + 1 >= level.tilesX)
+            {
+                tx0 = 0;
+                tx1 = level.tilesX - 1;
+            }
+
+            const int ty0 = std::clamp(static_cast<int>(std::floor(uvMin.y * level.height / VTEX_TILE_SIZE)), 0, level.tilesY - 1);
+            const int ty1 = std::clamp(static_cast<int>(std::floor(uvMax.y * level.height / VTEX_TILE_SIZE)), 0, level.tilesY - 1);
+
+            for (int ty = ty0; ty <= ty1; ty++)
+            {
+                for (int tx = tx0; tx <= tx1; tx++)
+                {
+                    const int x = (tx % level.tilesX + level.tilesX) % level.tilesX;
+                    touch(id, tex, level.firstTile + static_cast<size_t>(ty) * level.tilesX + x, l, now);
+                }
+            }
+        }
+    }
+
+    size_t upload(size_t count)
+    {
+        frame++;
+
+        if (inFlight == 0) return 0;
+
+        TRACE_SCOPE("vtexture::upload");
+
+        // 한번에 너무 많이 올리면 프레임이 밀리므로 count 개씩
+        std::vector<Loaded> batch;
+        {
+            std::lock_guard<std::mutex> _lock(doneLock);
+
+            const auto first = done.end() - static_cast<ptrdiff_t>(std::min(count, done.size()));
+            batch.assign(std::make_move_iterator(first), std::make_move_iterator(done.end()));
+            done.erase(first, done.end());
+        }
+
+        size_t uploaded = 0;
+        for (const auto& loaded : batch)
+        {
+            inFlight--;
+
+            auto& tex  = get(loaded.texture);
+            auto& tile = tex.tiles[loaded.tile];
+            tile.queued = false;
+
+            if (loaded.pixels.empty() || tile.slot >= 0) continue;
+
+            // 풀이 꽉 참 (전부 지금 쓰고 있는 타일). 그 동안은 작은 단계로 보임
+            const int slot = allocate();
+            if (slot < 0)
+            {
+                tile.rejected = frame;
+                continue;
+            }
+
+            place(loaded.texture, tex, loaded.tile, slot, loaded.pixels);
+            uploaded++;
+        }
+
+        return uploaded;
+    }
+
+    bool pending() noexcept
+    {
+        return inFlight > 0;
+    }
+
+    void setup(int id, GLuint shader, int poolUnit, int pageTableUnit)
+    {
+        auto& tex = get(id);
+
+        // 단계별 (너비, 높이, 페이지 테이블 y 위치, 가로 타일 수)
+        std::vector<glm::vec4> levels(VTEX_MAX_LEVELS, glm::vec4(0));
+        for (size_t l = 0; l < tex.levels.size(); l++)
+        {
+            const auto& level = tex.levels[l];
+            levels[l] = glm::vec4(level.width, level.height, level.pageY, level.tilesX);
+        }
+
+        glUniform1i(glGetUniformLocation(shader, "isVirtual"        ), 1);
+        glUniform1i(glGetUniformLocation(shader, "virtualPool"      ), poolUnit);
+        glUniform1i(glGetUniformLocation(shader, "virtualPageTable" ), pageTableUnit);
+        glUniform1i(glGetUniformLocation(shader, "virtualLevelCount"), static_cast<GLint>(tex.levels.size()));
+        glUniform3f(glGetUniformLocation(shader, "virtualTile"      ), VTEX_TILE_SIZE, VTEX_TILE_BORDER, VTEX_TILE_SLOT);
+
+        glUniform4fv(glGetUniformLocation(shader, "virtualLevels"), VTEX_MAX_LEVELS, glm::value_ptr(levels[0]));
+    }
+
+    void bind(int id, int poolUnit, int pageTableUnit)
+    {
+        auto& tex = get(id);
+
+        glActiveTexture(GL_TEXTURE0 + pageTableUnit);
+        glBindTexture(GL_TEXTURE_2D, tex.pageTable);
+
+        if (tex.pageDirty)
+        {
+            tex.pageDirty = false;
+
+            buildPage(tex);
+
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, tex.pageSize.w, tex.pageSize.h, GL_RGBA, GL_UNSIGNED_BYTE, tex.page.data());
+            glext::countUpload(tex.page.size());
+        }
+
+        glActiveTexture(GL_TEXTURE0 + poolUnit);
+        glBindTexture(GL_TEXTURE_2D, pool);
+
+        glActiveTexture(GL_TEXTURE0);
+    }
+}
@@ -0,0 +1,54 @@
+﻿// 큰 텍스쳐 (가상 텍스쳐)
+// 8K 텍스쳐를 통째로 올리지 않고 밉맵 단계별로 타일로 잘라서, 화면에 필요한 타일만 정해진 크기의 풀에 올려 쓴다.
+// 풀은 모든 가상 텍스쳐가 같이 쓰므로 큰 텍스쳐가 늘어나도 메모리는 늘지 않는다.
+//
+// 처음 불러올 때 PNG 를 타일로 잘라서 .vtex 파일로 저장해두고, 다음부터는 그 파일에서 필요한 타일만 읽는다.
+// 어떤 타일이 필요한지는 행성 표면 패치가 화면에서 차지하는 크기로 계산해서 request 로 알려준다 (analytic footprint).
+// 없는 타일은 읽기 스레드에서 읽어오고, 그 동안은 이미 올라와 있는 더 작은 단계를 쓴다. 가장 작은 단계는 항상 올라와 있음.
+//
+// 셰이더는 텍스쳐마다 있는 페이지 테이블에서 (단계, 타일) 이 풀의 어느 칸에 있는지 찾아서 읽는다.
+// 페이지 테이블 : 가로는 0 단계 가로 타일 수, 세로는 단계별 세로 타일 수를 이어붙인 것. 픽셀 = (풀 칸 x, 풀 칸 y, 실제 단계)
+//
+// .vtex 파일
+//   Header | 0 단계 타일들 (줄 단위) | 1 단계 타일들 | ... | 마지막 단계 (타일 하나)
+//   타일 하나는 VTEX_TILE_SLOT x VTEX_TILE_SLOT 픽셀 BGRA. 둘레 VTEX_TILE_BORDER 픽셀은 옆 타일 내용 (가로는 돌아가고 세로는 끝에서 멈춤)
+//
+// 벤치마크, 내보내기, 회귀 테스트처럼 결과가 정해져 있어야 하는 경우는 setAsync(false) 로 요청한 자리에서 바로 읽는다.
+
+#pragma once
+
+#include <string>
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+namespace vtexture
+{
+    // 풀 만들고 읽기 스레드 시작. GL 스레드에서
+    void start();
+    void stop();
+
+    // 가상 텍스쳐 불러오기. .vtex 가 없거나 PNG 보다 오래됐으면 새로 만듦. 텍스쳐 번호를 반환
+    // 로딩 스레드에서 호출 (GL 작업은 dispatch 로)
+    int load(const std::string& textureName);
+
+    // false 면 없는 타일을 요청한 자리에서 바로 읽어서 올림
+    void setAsync(bool async) noexcept;
+
+    // 이번 프레임에 필요한 영역 알려주기. GL 스레드에서
+    // uvMin, uvMax : u 는 0 ~ 1 을 넘어가도 됨 (돌아감). pixelsPerV : 화면에서 v 1 만큼이 몇 픽셀인지
+    void request(int id, glm::vec2 uvMin, glm::vec2 uvMax, float pixelsPerV);
+
+    // 프레임마다 한번. 읽어둔 타일을 count 개까지 풀에 올림. 올린 개수를 반환
+    size_t upload(size_t count);
+
+    // 읽거나 올려야 하는 타일이 남았는지
+    bool pending() noexcept;
+
+    // 셰이더 설정. 셰이더가 바인딩된 상태에서 한번
+    void setup(int id, GLuint shader, int poolUnit, int pageTableUnit);
+
+    // 텍스쳐 바인딩. 페이지 테이블이 바뀌었으면 여기서 올림
+    void bind(int id, int poolUnit, int pageTableUnit);
+}